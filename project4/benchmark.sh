@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# SM3 / Merkle Benchmark Script
+# 基准测试脚本：构建 sm3_bench，运行并保存 JSON 结果，可选与基线结果对比
+#
+# 用法: ./benchmark.sh [--quick] [基线.json]
+#   结果写入 bench-<日期>-<提交>.json；给出基线时逐项比较，
+#   SM3 ticks/byte 或证明 p50 变差超过 THRESHOLD（默认 5%）即以非零状态退出
+
+set -e
+cd "$(dirname "$0")"
+
+QUICK=""
+BASELINE=""
+for arg in "$@"; do
+    case "$arg" in
+        --quick) QUICK="--quick" ;;
+        *) BASELINE="$arg" ;;
+    esac
+done
+THRESHOLD="${THRESHOLD:-5}"
+
+echo "正在构建基准测试程序..."
+make -s sm3_bench
+
+REV="$(git rev-parse --short HEAD 2>/dev/null || echo unknown)"
+OUTPUT="bench-$(date +%Y%m%d-%H%M%S)-${REV}.json"
+
+echo "运行基准测试（结果: ${OUTPUT}）..."
+./sm3_bench $QUICK -o "$OUTPUT"
+
+if [ -z "$BASELINE" ]; then
+    echo "✅ 完成"
+    exit 0
+fi
+
+if ! command -v python3 >/dev/null 2>&1; then
+    echo "❌ 对比基线需要 python3"
+    exit 1
+fi
+
+echo ""
+echo "与基线 ${BASELINE} 对比（阈值 ${THRESHOLD}%）:"
+python3 - "$BASELINE" "$OUTPUT" "$THRESHOLD" <<'PY'
+import json
+import sys
+
+base, cur, threshold = json.load(open(sys.argv[1])), json.load(open(sys.argv[2])), float(sys.argv[3])
+
+def metrics(doc):
+    # 越小越好的指标
+    out = {}
+    for kernel in doc["sm3"]:
+        for entry in kernel["sizes"]:
+            out["sm3/%s/%d ticks_per_byte" % (kernel["kernel"], entry["size"])] = entry["ticks_per_byte"]
+    for entry in doc["tree_build"]["threads"]:
+        out["tree_build/%d threads ms" % entry["threads"]] = entry["ms"]
+    for name in ("inclusion", "consistency"):
+        for op in ("generate_ns", "verify_ns"):
+            out["proofs/%s %s p50" % (name, op)] = doc["proofs"][name][op]["p50"]
+    return out
+
+old, new = metrics(base), metrics(cur)
+regressions = 0
+for key in sorted(new):
+    if key not in old or old[key] == 0:
+        continue
+    change = (new[key] - old[key]) / old[key] * 100
+    mark = "❌" if change > threshold else "  "
+    regressions += change > threshold
+    print("%s %-45s %12.3f -> %12.3f  %+6.1f%%" % (mark, key, old[key], new[key], change))
+sys.exit(1 if regressions else 0)
+PY
@@ -14,223 +14,7 @@
 #include <stdint.h>
 #include <assert.h>
 
-// SM3 基本常数定义
-#define SM3_BLOCK_SIZE 64  // 512 bits
-#define SM3_DIGEST_SIZE 32 // 256 bits
-
-// SM3 初始值
-#define SM3_H0 0x7380166F
-#define SM3_H1 0x4914B2B9
-#define SM3_H2 0x172442D7
-#define SM3_H3 0xDA8A0600
-#define SM3_H4 0xA96F30BC
-#define SM3_H5 0x163138AA
-#define SM3_H6 0xE38DEE4D
-#define SM3_H7 0xB0FB0E4E
-
-// T 常数
-#define T_0_15 0x79cc4519
-#define T_16_63 0x7a879d8a
-
-// 基础运算宏
-#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
-
-// P0 和 P1 置换函数
-#define P0(x) ((x) ^ ROTL32((x), 9) ^ ROTL32((x), 17))
-#define P1(x) ((x) ^ ROTL32((x), 15) ^ ROTL32((x), 23))
-
-// FF 和 GG 布尔函数
-#define FF_0_15(x, y, z) ((x) ^ (y) ^ (z))
-#define FF_16_63(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
-#define GG_0_15(x, y, z) ((x) ^ (y) ^ (z))
-#define GG_16_63(x, y, z) (((x) & (y)) | (~(x) & (z)))
-
-// SM3 上下文结构
-typedef struct
-{
-    uint32_t state[8];      // 256位哈希状态
-    uint8_t buffer[64];     // 512位输入缓冲区
-    uint64_t total_length;  // 累计输入长度（位）
-    uint32_t buffer_length; // 当前缓冲区长度
-} sm3_context_t;
-
-// 字节序转换 - 大端序
-static uint32_t bytes_to_u32_be(const uint8_t *bytes)
-{
-    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
-}
-
-static void u32_to_bytes_be(uint32_t value, uint8_t *bytes)
-{
-    bytes[0] = (value >> 24) & 0xFF;
-    bytes[1] = (value >> 16) & 0xFF;
-    bytes[2] = (value >> 8) & 0xFF;
-    bytes[3] = value & 0xFF;
-}
-
-// SM3 压缩函数
-static void sm3_compress(sm3_context_t *ctx, const uint8_t *block)
-{
-    uint32_t W[68];
-    uint32_t W1[64];
-
-    // 消息字加载
-    for (int i = 0; i < 16; i++)
-    {
-        W[i] = bytes_to_u32_be(block + i * 4);
-    }
-
-    // 消息扩展
-    for (int j = 16; j < 68; j++)
-    {
-        uint32_t temp = W[j - 16] ^ W[j - 9] ^ ROTL32(W[j - 3], 15);
-        W[j] = P1(temp) ^ ROTL32(W[j - 13], 7) ^ W[j - 6];
-    }
-
-    // 生成W'数组
-    for (int j = 0; j < 64; j++)
-    {
-        W1[j] = W[j] ^ W[j + 4];
-    }
-
-    // 压缩函数迭代
-    uint32_t A = ctx->state[0], B = ctx->state[1], C = ctx->state[2], D = ctx->state[3];
-    uint32_t E = ctx->state[4], F = ctx->state[5], G = ctx->state[6], H = ctx->state[7];
-
-    // 64轮压缩
-    for (int j = 0; j < 64; j++)
-    {
-        uint32_t T = (j < 16) ? T_0_15 : T_16_63;
-        T = ROTL32(T, j % 32);
-
-        uint32_t SS1 = ROTL32(ROTL32(A, 12) + E + T, 7);
-        uint32_t SS2 = SS1 ^ ROTL32(A, 12);
-
-        uint32_t TT1, TT2;
-        if (j < 16)
-        {
-            TT1 = FF_0_15(A, B, C) + D + SS2 + W1[j];
-            TT2 = GG_0_15(E, F, G) + H + SS1 + W[j];
-        }
-        else
-        {
-            TT1 = FF_16_63(A, B, C) + D + SS2 + W1[j];
-            TT2 = GG_16_63(E, F, G) + H + SS1 + W[j];
-        }
-
-        D = C;
-        C = ROTL32(B, 9);
-        B = A;
-        A = TT1;
-        H = G;
-        G = ROTL32(F, 19);
-        F = E;
-        E = P0(TT2);
-    }
-
-    // 更新状态
-    ctx->state[0] ^= A;
-    ctx->state[1] ^= B;
-    ctx->state[2] ^= C;
-    ctx->state[3] ^= D;
-    ctx->state[4] ^= E;
-    ctx->state[5] ^= F;
-    ctx->state[6] ^= G;
-    ctx->state[7] ^= H;
-}
-
-// SM3 初始化
-void sm3_init(sm3_context_t *ctx)
-{
-    ctx->state[0] = SM3_H0;
-    ctx->state[1] = SM3_H1;
-    ctx->state[2] = SM3_H2;
-    ctx->state[3] = SM3_H3;
-    ctx->state[4] = SM3_H4;
-    ctx->state[5] = SM3_H5;
-    ctx->state[6] = SM3_H6;
-    ctx->state[7] = SM3_H7;
-
-    ctx->total_length = 0;
-    ctx->buffer_length = 0;
-    memset(ctx->buffer, 0, 64);
-}
-
-// SM3 更新
-void sm3_update(sm3_context_t *ctx, const uint8_t *data, uint64_t len)
-{
-    ctx->total_length += len * 8; // 转换为位数
-
-    while (len > 0)
-    {
-        uint32_t chunk_size = 64 - ctx->buffer_length;
-        if (chunk_size > len)
-            chunk_size = len;
-
-        memcpy(ctx->buffer + ctx->buffer_length, data, chunk_size);
-        ctx->buffer_length += chunk_size;
-        data += chunk_size;
-        len -= chunk_size;
-
-        if (ctx->buffer_length == 64)
-        {
-            sm3_compress(ctx, ctx->buffer);
-            ctx->buffer_length = 0;
-        }
-    }
-}
-
-// SM3 最终化
-void sm3_final(sm3_context_t *ctx, uint8_t *digest)
-{
-    // 添加填充
-    ctx->buffer[ctx->buffer_length] = 0x80;
-    ctx->buffer_length++;
-
-    // 如果空间不足，先处理一个块
-    if (ctx->buffer_length > 56)
-    {
-        while (ctx->buffer_length < 64)
-        {
-            ctx->buffer[ctx->buffer_length] = 0x00;
-            ctx->buffer_length++;
-        }
-        sm3_compress(ctx, ctx->buffer);
-        ctx->buffer_length = 0;
-    }
-
-    // 填充到56字节
-    while (ctx->buffer_length < 56)
-    {
-        ctx->buffer[ctx->buffer_length] = 0x00;
-        ctx->buffer_length++;
-    }
-
-    // 添加长度（大端序，64位）
-    uint64_t bit_length = ctx->total_length;
-    for (int i = 7; i >= 0; i--)
-    {
-        ctx->buffer[56 + i] = bit_length & 0xFF;
-        bit_length >>= 8;
-    }
-
-    sm3_compress(ctx, ctx->buffer);
-
-    // 输出哈希值（大端序）
-    for (int i = 0; i < 8; i++)
-    {
-        u32_to_bytes_be(ctx->state[i], digest + i * 4);
-    }
-}
-
-// 一次性哈希计算
-void sm3_hash(const uint8_t *data, uint64_t len, uint8_t *digest)
-{
-    sm3_context_t ctx;
-    sm3_init(&ctx);
-    sm3_update(&ctx, data, len);
-    sm3_final(&ctx, digest);
-}
+#include "sm3.h"
 
 // 计算SM3填充
 uint64_t sm3_calculate_padding_length(uint64_t original_length)
@@ -299,19 +83,10 @@ void sm3_generate_padding(uint64_t original_length, uint8_t *padding, uint64_t *
 void sm3_length_extension_init(sm3_context_t *ctx, const uint8_t *known_hash,
                                uint64_t known_message_length)
 {
-    // 从已知哈希值设置状态
-    for (int i = 0; i < 8; i++)
-    {
-        ctx->state[i] = bytes_to_u32_be(known_hash + i * 4);
-    }
-
-    // 计算已处理的总长度（包括secret + message + padding）
-    uint64_t original_bit_length = known_message_length * 8;
+    // 已知哈希值即 secret + message + padding 之后的中间状态，总长度恰为块的整数倍
     uint64_t padding_length = sm3_calculate_padding_length(known_message_length);
-    ctx->total_length = original_bit_length + padding_length * 8;
-
-    ctx->buffer_length = 0;
-    memset(ctx->buffer, 0, 64);
+    sm3_init(ctx);
+    sm3_midstate_import(ctx, known_hash, known_message_length + padding_length);
 }
 
 // 打印十六进制数据
@@ -436,6 +211,25 @@ void demonstrate_length_extension_attack()
         printf("总长度: %llu bytes\n", (unsigned long long)forged_message_length);
     }
 
+    // 6. 对照：同样的伪造对 HMAC-SM3 无效
+    printf("\n6. 改用 HMAC-SM3 认证:\n");
+    {
+        uint8_t tag[SM3_DIGEST_SIZE], forged_check[SM3_DIGEST_SIZE];
+        sm3_hmac((const uint8_t *)secret, strlen(secret), (const uint8_t *)original_message, strlen(original_message),
+                 tag);
+        print_hex("   - 原始认证标签 HMAC(secret, message)", tag, SM3_DIGEST_SIZE);
+
+        // 攻击者仍以已知标签为中间状态扩展
+        sm3_length_extension_init(&attack_ctx, tag, combined_length);
+        sm3_update(&attack_ctx, (const uint8_t *)additional_message, strlen(additional_message));
+        sm3_final(&attack_ctx, forged_hash);
+
+        sm3_hmac((const uint8_t *)secret, strlen(secret), forged_message + strlen(secret),
+                 forged_message_length - strlen(secret), forged_check);
+        printf("   - 伪造标签能否通过验证: %s\n",
+               memcmp(forged_hash, forged_check, SM3_DIGEST_SIZE) == 0 ? "❌ 能（不应发生）" : "✅ 不能");
+    }
+
     // 清理内存
     free(combined);
     free(forged_message);
@@ -444,7 +238,7 @@ void demonstrate_length_extension_attack()
     printf("1. 攻击原理: SM3采用Merkle-Damgård结构，哈希状态只依赖于前面的输入\n");
     printf("2. 攻击条件: 已知H(secret||message)、message长度、secret长度\n");
     printf("3. 攻击结果: 可伪造H(secret||message||padding||additional_message)\n");
-    printf("4. 防护措施: 使用HMAC、基于海绵结构的哈希函数(如SHA-3)等\n");
+    printf("4. 防护措施: 使用HMAC（本库提供 sm3_hmac）、基于海绵结构的哈希函数(如SHA-3)等\n");
 }
 
 // 测试不同场景的长度扩展攻击
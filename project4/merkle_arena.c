@@ -0,0 +1,107 @@
+/*
+ * RFC6962 Merkle Proof Arena
+ * 证明与临时数据的线性分配器
+ *
+ * 证明服务中每个请求分配若干个小对象、很快整体丢弃，逐个 malloc/free 会让分配器成为热点。
+ * arena 只移动偏移量完成分配，reset 时整体回收；堆上追加的块在 reset 后保留并按顺序复用，
+ * 因此一个请求循环在预热之后不再调用 malloc
+ */
+
+#include <stdlib.h>
+
+#include "merkle_internal.h"
+
+struct rfc6962_arena_chunk
+{
+    struct rfc6962_arena_chunk *next;
+    size_t size;
+    uint8_t data[] __attribute__((aligned(RFC6962_ARENA_ALIGN)));
+};
+
+static __thread rfc6962_arena_t rfc6962_local_arena;
+static __thread int rfc6962_local_arena_ready;
+
+void rfc6962_arena_init(rfc6962_arena_t *arena, void *buffer, size_t size, size_t grow)
+{
+    arena->initial = buffer;
+    arena->initial_size = buffer ? size : 0;
+    arena->chunks = NULL;
+    arena->grow = grow;
+    rfc6962_arena_reset(arena);
+}
+
+void *rfc6962_arena_alloc(rfc6962_arena_t *arena, size_t size)
+{
+    size_t offset = (arena->used + RFC6962_ARENA_ALIGN - 1) & ~(size_t)(RFC6962_ARENA_ALIGN - 1);
+    rfc6962_arena_chunk_t *next;
+
+    if (arena->base && offset <= arena->size && size <= arena->size - offset)
+    {
+        arena->used = offset + size;
+        return arena->base + offset;
+    }
+    if (arena->grow == 0)
+        return NULL;
+
+    // 优先复用上一轮留下的块，放不下时在当前位置插入一个新块
+    next = arena->current ? arena->current->next : arena->chunks;
+    if (!next || next->size < size)
+    {
+        size_t chunk_size = size > arena->grow ? size : arena->grow;
+        rfc6962_arena_chunk_t *chunk = malloc(sizeof(rfc6962_arena_chunk_t) + chunk_size);
+
+        if (!chunk)
+            return NULL;
+        chunk->size = chunk_size;
+        chunk->next = next;
+        if (arena->current)
+            arena->current->next = chunk;
+        else
+            arena->chunks = chunk;
+        next = chunk;
+    }
+
+    arena->current = next;
+    arena->base = next->data;
+    arena->size = next->size;
+    arena->used = size;
+    return next->data;
+}
+
+void rfc6962_arena_reset(rfc6962_arena_t *arena)
+{
+    arena->base = arena->initial;
+    arena->size = arena->initial_size;
+    arena->used = 0;
+    arena->current = NULL;
+}
+
+void rfc6962_arena_destroy(rfc6962_arena_t *arena)
+{
+    while (arena->chunks)
+    {
+        rfc6962_arena_chunk_t *next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+    rfc6962_arena_reset(arena);
+}
+
+rfc6962_arena_t *rfc6962_thread_arena(void)
+{
+    if (!rfc6962_local_arena_ready)
+    {
+        rfc6962_arena_init(&rfc6962_local_arena, NULL, 0, RFC6962_ARENA_DEFAULT_GROW);
+        rfc6962_local_arena_ready = 1;
+    }
+    return &rfc6962_local_arena;
+}
+
+void rfc6962_thread_arena_release(void)
+{
+    if (rfc6962_local_arena_ready)
+    {
+        rfc6962_arena_destroy(&rfc6962_local_arena);
+        rfc6962_local_arena_ready = 0;
+    }
+}
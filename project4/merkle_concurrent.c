@@ -0,0 +1,266 @@
+/*
+ * RFC6962 Merkle Tree Concurrent Read Path
+ * 无锁并发读：不可变快照 + 基于纪元的回收
+ *
+ * 写者（追加方之间用互斥锁串行）在每次追加后发布一个不可变快照：叶子数、根、各层节点数，
+ * 以及右边缘不完整节点（每层至多一个）的副本。完整子树的节点一经写入便不再改变，
+ * 快照只需复制 O(log n) 个节点，其余节点直接读共享节点区，因此读者生成证明时不加锁、
+ * 不阻塞写者，证明始终对应快照的大小与根，不受之后的追加影响。
+ *
+ * 旧快照的回收采用纪元（epoch）方案：读者在读取当前快照指针前公布自己看到的全局纪元，
+ * 写者替换指针后推进纪元，旧快照只有在所有活跃读者公布的纪元都大于其退役纪元时才释放
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "merkle_internal.h"
+
+#define RFC6962_CACHE_LINE 64
+
+// 每个读者一个缓存行，避免读者之间伪共享
+typedef struct
+{
+    uint64_t epoch; // 0 表示未持有快照
+    int used;
+    uint8_t pad[RFC6962_CACHE_LINE - sizeof(uint64_t) - sizeof(int)];
+} rfc6962_reader_slot_t;
+
+struct rfc6962_concurrent_tree
+{
+    rfc6962_merkle_tree_t *tree;
+    rfc6962_snapshot_t *current; // 原子读写
+    uint64_t epoch;              // 全局纪元，原子读写，从1开始
+    rfc6962_reader_slot_t readers[RFC6962_MAX_READERS];
+    rfc6962_snapshot_t *retired; // 待回收的旧快照，只由写者访问
+    pthread_mutex_t writer_lock; // 只在追加方之间互斥，读者从不获取
+};
+
+// 按树的当前状态创建快照
+static rfc6962_snapshot_t *rfc6962_snapshot_take(const rfc6962_merkle_tree_t *tree)
+{
+    rfc6962_snapshot_t *snap = malloc(sizeof(rfc6962_snapshot_t));
+
+    if (!snap)
+        return NULL;
+
+    snap->size = tree->leaf_count;
+    memcpy(snap->root_hash, tree->root_hash, SM3_DIGEST_SIZE);
+    snap->level_count = tree->level_count;
+    for (int level = 0; level < tree->level_count; level++)
+    {
+        uint64_t last = tree->level_size[level] - 1;
+
+        snap->level_size[level] = tree->level_size[level];
+        if (((last + 1) << level) > tree->leaf_count)
+            memcpy(snap->edge[level], rfc6962_node(tree, level, last), SM3_DIGEST_SIZE);
+    }
+    snap->retired_next = NULL;
+    snap->retired_epoch = 0;
+    return snap;
+}
+
+void rfc6962_snapshot_view(const rfc6962_concurrent_tree_t *ct, const rfc6962_snapshot_t *snap, rfc6962_view_t *view)
+{
+    view->tree = ct->tree;
+    view->size = snap->size;
+    view->level_count = snap->level_count;
+    view->level_size = snap->level_size;
+    view->edge = (const merkle_node_t *)snap->edge;
+    view->root_hash = snap->root_hash;
+}
+
+// 释放所有活跃读者都已不可能持有的旧快照（调用方持有写锁）
+static void rfc6962_reclaim(rfc6962_concurrent_tree_t *ct)
+{
+    uint64_t oldest = UINT64_MAX;
+    rfc6962_snapshot_t **link = &ct->retired;
+
+    for (int i = 0; i < RFC6962_MAX_READERS; i++)
+    {
+        uint64_t e = __atomic_load_n(&ct->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (e != 0 && e < oldest)
+            oldest = e;
+    }
+
+    while (*link)
+    {
+        rfc6962_snapshot_t *snap = *link;
+        if (snap->retired_epoch < oldest)
+        {
+            *link = snap->retired_next;
+            free(snap);
+        }
+        else
+        {
+            link = &snap->retired_next;
+        }
+    }
+}
+
+// 发布树的当前状态，旧快照进入回收链表（调用方持有写锁）
+static int rfc6962_publish(rfc6962_concurrent_tree_t *ct)
+{
+    rfc6962_snapshot_t *snap = rfc6962_snapshot_take(ct->tree);
+    rfc6962_snapshot_t *old;
+
+    if (!snap)
+        return -1;
+
+    old = __atomic_exchange_n(&ct->current, snap, __ATOMIC_SEQ_CST);
+    // 在此之前读取全局纪元的读者可能仍持有 old
+    old->retired_epoch = __atomic_fetch_add(&ct->epoch, 1, __ATOMIC_SEQ_CST);
+    old->retired_next = ct->retired;
+    ct->retired = old;
+
+    rfc6962_reclaim(ct);
+    return 0;
+}
+
+rfc6962_concurrent_tree_t *rfc6962_concurrent_create(rfc6962_merkle_tree_t *tree)
+{
+    rfc6962_concurrent_tree_t *ct;
+
+    if (!tree)
+        return NULL;
+
+    ct = calloc(1, sizeof(rfc6962_concurrent_tree_t));
+    if (!ct)
+        return NULL;
+
+    ct->tree = tree;
+    ct->epoch = 1;
+    ct->current = rfc6962_snapshot_take(tree);
+    if (!ct->current || pthread_mutex_init(&ct->writer_lock, NULL) != 0)
+    {
+        free(ct->current);
+        free(ct);
+        return NULL;
+    }
+    return ct;
+}
+
+void rfc6962_concurrent_free(rfc6962_concurrent_tree_t *ct)
+{
+    if (!ct)
+        return;
+
+    // 调用方保证此时已没有读者
+    while (ct->retired)
+    {
+        rfc6962_snapshot_t *next = ct->retired->retired_next;
+        free(ct->retired);
+        ct->retired = next;
+    }
+    free(ct->current);
+    pthread_mutex_destroy(&ct->writer_lock);
+    free_rfc6962_merkle_tree(ct->tree);
+    free(ct);
+}
+
+int rfc6962_concurrent_append(rfc6962_concurrent_tree_t *ct, const uint8_t *data, size_t data_len)
+{
+    int ret;
+
+    pthread_mutex_lock(&ct->writer_lock);
+    ret = rfc6962_tree_append(ct->tree, data, data_len);
+    if (ret == 0)
+        ret = rfc6962_publish(ct);
+    pthread_mutex_unlock(&ct->writer_lock);
+    return ret;
+}
+
+int rfc6962_concurrent_append_batch(rfc6962_concurrent_tree_t *ct, uint8_t **data_array, uint64_t *data_lengths,
+                                    uint64_t count)
+{
+    int ret;
+
+    pthread_mutex_lock(&ct->writer_lock);
+    ret = rfc6962_tree_append_batch(ct->tree, data_array, data_lengths, count);
+    if (ret == 0)
+        ret = rfc6962_publish(ct);
+    pthread_mutex_unlock(&ct->writer_lock);
+    return ret;
+}
+
+int rfc6962_reader_register(rfc6962_concurrent_tree_t *ct)
+{
+    for (int i = 0; i < RFC6962_MAX_READERS; i++)
+    {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&ct->readers[i].used, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return i;
+    }
+    return -1;
+}
+
+void rfc6962_reader_unregister(rfc6962_concurrent_tree_t *ct, int reader)
+{
+    __atomic_store_n(&ct->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&ct->readers[reader].used, 0, __ATOMIC_RELEASE);
+}
+
+const rfc6962_snapshot_t *rfc6962_snapshot_acquire(rfc6962_concurrent_tree_t *ct, int reader)
+{
+    // 先公布纪元再读取指针：写者推进纪元之后的回收扫描必然能看到这次公布
+    uint64_t e = __atomic_load_n(&ct->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ct->readers[reader].epoch, e, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&ct->current, __ATOMIC_SEQ_CST);
+}
+
+void rfc6962_snapshot_release(rfc6962_concurrent_tree_t *ct, int reader)
+{
+    __atomic_store_n(&ct->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+rfc6962_inclusion_proof_t *generate_rfc6962_inclusion_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                               const rfc6962_snapshot_t *snap, uint64_t leaf_index)
+{
+    rfc6962_view_t view;
+
+    rfc6962_snapshot_view(ct, snap, &view);
+    return rfc6962_view_inclusion_proof(&view, leaf_index);
+}
+
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                                   const rfc6962_snapshot_t *snap, uint64_t old_size)
+{
+    rfc6962_view_t view;
+
+    rfc6962_snapshot_view(ct, snap, &view);
+    return rfc6962_view_consistency_proof(&view, old_size);
+}
+
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_between_at(const rfc6962_concurrent_tree_t *ct,
+                                                                           const rfc6962_snapshot_t *snap,
+                                                                           uint64_t old_size, uint64_t new_size)
+{
+    rfc6962_view_storage_t storage;
+    rfc6962_view_t base, view;
+
+    rfc6962_snapshot_view(ct, snap, &base);
+    if (rfc6962_view_at(&base, new_size, &storage, &view) != 0)
+        return NULL;
+    return rfc6962_view_consistency_proof(&view, old_size);
+}
+
+rfc6962_compact_proof_t *generate_rfc6962_compact_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                           const rfc6962_snapshot_t *snap, uint64_t leaf_index,
+                                                           rfc6962_arena_t *arena)
+{
+    rfc6962_view_t view;
+
+    rfc6962_snapshot_view(ct, snap, &view);
+    return rfc6962_view_compact_proof(&view, leaf_index, arena);
+}
+
+rfc6962_multiproof_t *generate_rfc6962_multiproof_at(const rfc6962_concurrent_tree_t *ct,
+                                                     const rfc6962_snapshot_t *snap, const uint64_t *indices,
+                                                     uint64_t count)
+{
+    rfc6962_view_t view;
+
+    rfc6962_snapshot_view(ct, snap, &view);
+    return rfc6962_view_multiproof(&view, indices, count);
+}
@@ -0,0 +1,524 @@
+/*
+ * RFC6962 Merkle Tree GPU Backend
+ * 可选的 OpenCL 设备后端：叶子哈希与各内部层的归约放到 GPU 上
+ *
+ * 叶子层按 2^RFC6962_GPU_CHUNK_LEVELS 个叶子切块（与 CPU 并行构建相同的块划分），每块是一棵
+ * 独立子树：上传该块的记录与偏移表，每个工作项哈希一个叶子，之后每层每个工作项哈希一对兄弟节点，
+ * 块内各层（或只有块根）读回主机，块以上的少数几层由 CPU 归约
+ *
+ * 两组设备缓冲区与两个命令队列交替使用：第 c 块的计算与第 c + 1 块的上传、第 c - 1 块的读回
+ * 在不同队列上重叠，PCIe 传输不成为瓶颈
+ *
+ * make GPU=1 时编译 OpenCL 路径：运行时用 dlopen 加载 libOpenCL.so.1，不依赖 OpenCL 头文件；
+ * 没有驱动、没有 GPU/加速器设备或内核编译失败时自动使用 CPU 构建
+ */
+
+#define _DEFAULT_SOURCE // dlopen
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "merkle_internal.h"
+
+#define RFC6962_GPU_CHUNK_LEVELS 20      // 每块 2^20 个叶子，每组设备缓冲区约 64MB 节点
+#define RFC6962_GPU_MIN_LEAVES (1 << 16) // 自动选择时，少于此数的叶子直接在 CPU 上构建
+#define RFC6962_GPU_GROUP 64             // 全局工作项数向上取整到该值的倍数
+
+#ifdef RFC6962_GPU
+#include <dlfcn.h>
+
+// 用到的 OpenCL 1.2 类型与常量（与 CL/cl.h 一致）
+typedef int32_t cl_int;
+typedef uint32_t cl_uint;
+typedef uint64_t cl_bitfield;
+typedef struct _cl_platform_id *cl_platform_id;
+typedef struct _cl_device_id *cl_device_id;
+typedef struct _cl_context *cl_context;
+typedef struct _cl_command_queue *cl_command_queue;
+typedef struct _cl_program *cl_program;
+typedef struct _cl_kernel *cl_kernel;
+typedef struct _cl_mem *cl_mem;
+typedef struct _cl_event *cl_event;
+
+#define CL_SUCCESS 0
+#define CL_FALSE 0
+#define CL_DEVICE_TYPE_GPU ((cl_bitfield)1 << 2)
+#define CL_DEVICE_TYPE_ACCELERATOR ((cl_bitfield)1 << 3)
+#define CL_DEVICE_NAME 0x102B
+#define CL_MEM_READ_WRITE ((cl_bitfield)1 << 0)
+#define CL_MEM_READ_ONLY ((cl_bitfield)1 << 2)
+
+#define RFC6962_GPU_MAX_PLATFORMS 8
+
+typedef struct
+{
+    cl_int (*GetPlatformIDs)(cl_uint, cl_platform_id *, cl_uint *);
+    cl_int (*GetDeviceIDs)(cl_platform_id, cl_bitfield, cl_uint, cl_device_id *, cl_uint *);
+    cl_int (*GetDeviceInfo)(cl_device_id, cl_uint, size_t, void *, size_t *);
+    cl_context (*CreateContext)(const intptr_t *, cl_uint, const cl_device_id *,
+                                void (*)(const char *, const void *, size_t, void *), void *, cl_int *);
+    cl_command_queue (*CreateCommandQueue)(cl_context, cl_device_id, cl_bitfield, cl_int *);
+    cl_program (*CreateProgramWithSource)(cl_context, cl_uint, const char **, const size_t *, cl_int *);
+    cl_int (*BuildProgram)(cl_program, cl_uint, const cl_device_id *, const char *, void (*)(cl_program, void *),
+                           void *);
+    cl_kernel (*CreateKernel)(cl_program, const char *, cl_int *);
+    cl_mem (*CreateBuffer)(cl_context, cl_bitfield, size_t, void *, cl_int *);
+    cl_int (*SetKernelArg)(cl_kernel, cl_uint, size_t, const void *);
+    cl_int (*EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, const void *, cl_uint,
+                                 const cl_event *, cl_event *);
+    cl_int (*EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, void *, cl_uint, const cl_event *,
+                                cl_event *);
+    cl_int (*EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const size_t *, const size_t *,
+                                   const size_t *, cl_uint, const cl_event *, cl_event *);
+    cl_int (*Flush)(cl_command_queue);
+    cl_int (*Finish)(cl_command_queue);
+    cl_int (*ReleaseMemObject)(cl_mem);
+    cl_int (*ReleaseCommandQueue)(cl_command_queue);
+} rfc6962_cl_api_t;
+
+// 按 rfc6962_cl_api_t 的字段顺序
+static const char *const rfc6962_cl_symbols[] = {
+    "clGetPlatformIDs",     "clGetDeviceIDs",       "clGetDeviceInfo",      "clCreateContext",
+    "clCreateCommandQueue", "clCreateProgramWithSource", "clBuildProgram",  "clCreateKernel",
+    "clCreateBuffer",       "clSetKernelArg",       "clEnqueueWriteBuffer", "clEnqueueReadBuffer",
+    "clEnqueueNDRangeKernel", "clFlush",            "clFinish",             "clReleaseMemObject",
+    "clReleaseCommandQueue",
+};
+
+typedef char rfc6962_cl_api_check[sizeof(rfc6962_cl_api_t) ==
+                                          sizeof(rfc6962_cl_symbols) / sizeof(rfc6962_cl_symbols[0]) * sizeof(void *)
+                                      ? 1
+                                      : -1];
+
+// 设备端 SM3：每个工作项独立计算一条 prefix || data，消息逐字节装入私有块
+static const char rfc6962_gpu_source[] =
+    "#define ROTL(x, n) rotate((uint)(x), (uint)(n))\n"
+    "#define P0(x) ((x) ^ ROTL(x, 9) ^ ROTL(x, 17))\n"
+    "#define P1(x) ((x) ^ ROTL(x, 15) ^ ROTL(x, 23))\n"
+    "void sm3_compress(uint *v, const uint *b)\n"
+    "{\n"
+    "    uint w[68];\n"
+    "    uint r[8];\n"
+    "    for (int j = 0; j < 16; j++) w[j] = b[j];\n"
+    "    for (int j = 16; j < 68; j++)\n"
+    "        w[j] = P1(w[j - 16] ^ w[j - 9] ^ ROTL(w[j - 3], 15)) ^ ROTL(w[j - 13], 7) ^ w[j - 6];\n"
+    "    for (int j = 0; j < 8; j++) r[j] = v[j];\n"
+    "    for (int j = 0; j < 64; j++)\n"
+    "    {\n"
+    "        uint t = j < 16 ? 0x79cc4519u : 0x7a879d8au;\n"
+    "        uint ss1 = ROTL(ROTL(r[0], 12) + r[4] + ROTL(t, j % 32), 7);\n"
+    "        uint ss2 = ss1 ^ ROTL(r[0], 12);\n"
+    "        uint ff = j < 16 ? r[0] ^ r[1] ^ r[2] : (r[0] & r[1]) | (r[0] & r[2]) | (r[1] & r[2]);\n"
+    "        uint gg = j < 16 ? r[4] ^ r[5] ^ r[6] : (r[4] & r[5]) | (~r[4] & r[6]);\n"
+    "        uint tt1 = ff + r[3] + ss2 + (w[j] ^ w[j + 4]);\n"
+    "        uint tt2 = gg + r[7] + ss1 + w[j];\n"
+    "        r[3] = r[2]; r[2] = ROTL(r[1], 9); r[1] = r[0]; r[0] = tt1;\n"
+    "        r[7] = r[6]; r[6] = ROTL(r[5], 19); r[5] = r[4]; r[4] = P0(tt2);\n"
+    "    }\n"
+    "    for (int j = 0; j < 8; j++) v[j] ^= r[j];\n"
+    "}\n"
+    "void sm3_prefixed(uchar prefix, global const uchar *p, ulong len, global uchar *out)\n"
+    "{\n"
+    "    uint v[8] = {0x7380166fu, 0x4914b2b9u, 0x172442d7u, 0xda8a0600u,\n"
+    "                 0xa96f30bcu, 0x163138aau, 0xe38dee4du, 0xb0fb0e4eu};\n"
+    "    uint b[16] = {0};\n"
+    "    uint pos = 1;\n"
+    "    b[0] = (uint)prefix << 24;\n"
+    "    for (ulong k = 0; k < len; k++)\n"
+    "    {\n"
+    "        b[pos >> 2] |= (uint)p[k] << (24 - 8 * (pos & 3));\n"
+    "        if (++pos == 64)\n"
+    "        {\n"
+    "            sm3_compress(v, b);\n"
+    "            for (int j = 0; j < 16; j++) b[j] = 0;\n"
+    "            pos = 0;\n"
+    "        }\n"
+    "    }\n"
+    "    b[pos >> 2] |= 0x80u << (24 - 8 * (pos & 3));\n"
+    "    if (++pos > 56)\n"
+    "    {\n"
+    "        sm3_compress(v, b);\n"
+    "        for (int j = 0; j < 16; j++) b[j] = 0;\n"
+    "    }\n"
+    "    ulong bits = (len + 1) * 8;\n"
+    "    b[14] = (uint)(bits >> 32);\n"
+    "    b[15] = (uint)bits;\n"
+    "    sm3_compress(v, b);\n"
+    "    for (int j = 0; j < 8; j++)\n"
+    "    {\n"
+    "        out[4 * j] = (uchar)(v[j] >> 24); out[4 * j + 1] = (uchar)(v[j] >> 16);\n"
+    "        out[4 * j + 2] = (uchar)(v[j] >> 8); out[4 * j + 3] = (uchar)v[j];\n"
+    "    }\n"
+    "}\n"
+    "kernel void rfc6962_leaf(global const uchar *data, global const ulong *offsets, ulong base, ulong n,\n"
+    "                         global uchar *nodes)\n"
+    "{\n"
+    "    ulong i = get_global_id(0);\n"
+    "    if (i >= n) return;\n"
+    "    sm3_prefixed(0, data + (offsets[i] - base), offsets[i + 1] - offsets[i], nodes + 32 * i);\n"
+    "}\n"
+    "kernel void rfc6962_level(global uchar *nodes, ulong child_off, ulong child_count, ulong parent_off, ulong n)\n"
+    "{\n"
+    "    ulong i = get_global_id(0);\n"
+    "    global const uchar *c = nodes + 32 * (child_off + 2 * i);\n"
+    "    global uchar *p = nodes + 32 * (parent_off + i);\n"
+    "    if (i >= n) return;\n"
+    "    if (2 * i + 1 < child_count)\n"
+    "        sm3_prefixed(1, c, 64, p);\n"
+    "    else\n"
+    "        for (int j = 0; j < 32; j++) p[j] = c[j];\n"
+    "}\n";
+
+// 设备在进程内只探测一次，之后各次构建共用上下文与内核
+typedef struct
+{
+    rfc6962_cl_api_t cl;
+    cl_device_id device;
+    cl_context context;
+    cl_kernel leaf_kernel;
+    cl_kernel level_kernel;
+    char name[128];
+    int ready;
+} rfc6962_gpu_t;
+
+static rfc6962_gpu_t rfc6962_gpu;
+static pthread_once_t rfc6962_gpu_once = PTHREAD_ONCE_INIT;
+
+static void rfc6962_gpu_init(void)
+{
+    rfc6962_gpu_t *g = &rfc6962_gpu;
+    void *lib = dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+    cl_platform_id platforms[RFC6962_GPU_MAX_PLATFORMS];
+    cl_uint platform_count = 0;
+    const char *source = rfc6962_gpu_source;
+    cl_program program;
+    cl_int err;
+
+    if (!lib)
+        return;
+    for (size_t i = 0; i < sizeof(rfc6962_cl_symbols) / sizeof(rfc6962_cl_symbols[0]); i++)
+    {
+        void *sym = dlsym(lib, rfc6962_cl_symbols[i]);
+        if (!sym)
+            return;
+        memcpy((void **)&g->cl + i, &sym, sizeof(void *));
+    }
+
+    // 取第一个 GPU 或加速器设备
+    if (g->cl.GetPlatformIDs(RFC6962_GPU_MAX_PLATFORMS, platforms, &platform_count) != CL_SUCCESS)
+        return;
+    if (platform_count > RFC6962_GPU_MAX_PLATFORMS)
+        platform_count = RFC6962_GPU_MAX_PLATFORMS;
+    for (cl_uint i = 0; i < platform_count && !g->device; i++)
+    {
+        if (g->cl.GetDeviceIDs(platforms[i], CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR, 1, &g->device, NULL) !=
+            CL_SUCCESS)
+            g->device = NULL;
+    }
+    if (!g->device)
+        return;
+
+    if (g->cl.GetDeviceInfo(g->device, CL_DEVICE_NAME, sizeof(g->name) - 1, g->name, NULL) != CL_SUCCESS)
+        strcpy(g->name, "OpenCL device");
+
+    g->context = g->cl.CreateContext(NULL, 1, &g->device, NULL, NULL, &err);
+    if (err != CL_SUCCESS)
+        return;
+    program = g->cl.CreateProgramWithSource(g->context, 1, &source, NULL, &err);
+    if (err != CL_SUCCESS || g->cl.BuildProgram(program, 1, &g->device, "", NULL, NULL) != CL_SUCCESS)
+        return;
+    g->leaf_kernel = g->cl.CreateKernel(program, "rfc6962_leaf", &err);
+    if (err != CL_SUCCESS)
+        return;
+    g->level_kernel = g->cl.CreateKernel(program, "rfc6962_level", &err);
+    if (err != CL_SUCCESS)
+        return;
+    g->ready = 1; // 上下文、程序与库句柄保留到进程退出
+}
+
+// 一组设备缓冲区：记录、偏移表、块内各层节点
+typedef struct
+{
+    cl_command_queue queue;
+    cl_mem data;
+    cl_mem offsets;
+    cl_mem nodes;
+} rfc6962_gpu_slot_t;
+
+static void rfc6962_gpu_slot_release(rfc6962_gpu_slot_t *slot)
+{
+    const rfc6962_cl_api_t *cl = &rfc6962_gpu.cl;
+
+    if (slot->queue)
+    {
+        cl->Finish(slot->queue);
+        cl->ReleaseCommandQueue(slot->queue);
+    }
+    if (slot->data)
+        cl->ReleaseMemObject(slot->data);
+    if (slot->offsets)
+        cl->ReleaseMemObject(slot->offsets);
+    if (slot->nodes)
+        cl->ReleaseMemObject(slot->nodes);
+}
+
+static int rfc6962_gpu_run(cl_command_queue queue, cl_kernel kernel, uint64_t n)
+{
+    size_t global = (size_t)((n + RFC6962_GPU_GROUP - 1) / RFC6962_GPU_GROUP * RFC6962_GPU_GROUP);
+    return rfc6962_gpu.cl.EnqueueNDRangeKernel(queue, kernel, 1, NULL, &global, NULL, 0, NULL, NULL) == CL_SUCCESS
+               ? 0
+               : -1;
+}
+
+// 在设备上计算各块：tree 非 NULL 时块内各层写回 tree 的节点区，否则只把块根写入 tops[chunk]
+static int rfc6962_gpu_chunks(const uint8_t *base, const uint64_t *offsets, uint64_t count, int chunk_levels,
+                              rfc6962_merkle_tree_t *tree, merkle_node_t *tops)
+{
+    const rfc6962_cl_api_t *cl = &rfc6962_gpu.cl;
+    uint64_t chunk_leaves = (uint64_t)1 << chunk_levels;
+    uint64_t chunk_count = ((count - 1) >> chunk_levels) + 1;
+    uint64_t level_off[MERKLE_MAX_LEVELS];
+    uint64_t max_span = 1;
+    uint64_t total = 0;
+    rfc6962_gpu_slot_t slots[2];
+    cl_int err = CL_SUCCESS;
+    int ret = -1;
+
+    // 块内布局固定：第 j 层从 level_off[j] 个节点处开始
+    for (int j = 0; j <= chunk_levels; j++)
+    {
+        level_off[j] = total;
+        total += chunk_leaves >> j;
+    }
+    for (uint64_t c = 0; c < chunk_count; c++)
+    {
+        uint64_t begin = c << chunk_levels;
+        uint64_t end = begin + chunk_leaves < count ? begin + chunk_leaves : count;
+        if (offsets[end] - offsets[begin] > max_span)
+            max_span = offsets[end] - offsets[begin];
+    }
+
+    memset(slots, 0, sizeof(slots));
+    for (int s = 0; s < 2 && err == CL_SUCCESS; s++)
+    {
+        slots[s].queue = cl->CreateCommandQueue(rfc6962_gpu.context, rfc6962_gpu.device, 0, &err);
+        if (err == CL_SUCCESS)
+            slots[s].data = cl->CreateBuffer(rfc6962_gpu.context, CL_MEM_READ_ONLY, (size_t)max_span, NULL, &err);
+        if (err == CL_SUCCESS)
+            slots[s].offsets = cl->CreateBuffer(rfc6962_gpu.context, CL_MEM_READ_ONLY,
+                                                (size_t)(chunk_leaves + 1) * sizeof(uint64_t), NULL, &err);
+        if (err == CL_SUCCESS)
+            slots[s].nodes = cl->CreateBuffer(rfc6962_gpu.context, CL_MEM_READ_WRITE,
+                                              (size_t)total * sizeof(merkle_node_t), NULL, &err);
+    }
+    if (err != CL_SUCCESS)
+        goto done;
+
+    for (uint64_t c = 0; c < chunk_count; c++)
+    {
+        rfc6962_gpu_slot_t *slot = &slots[c & 1];
+        uint64_t begin = c << chunk_levels;
+        uint64_t end = begin + chunk_leaves < count ? begin + chunk_leaves : count;
+        uint64_t n = end - begin;
+        uint64_t data_base = offsets[begin];
+
+        // 该组缓冲区上一次（第 c - 2 块）的读回完成后才能复用
+        if (c >= 2 && cl->Finish(slot->queue) != CL_SUCCESS)
+            goto done;
+
+        // 上传与读回都不阻塞：调用方缓冲区与节点区在本函数返回前保持有效；
+        // 全是空记录的块没有数据可传（零长度写入是 CL_INVALID_VALUE），叶子内核也不会读数据区
+        uint64_t span = offsets[end] - data_base;
+        if ((span > 0 && cl->EnqueueWriteBuffer(slot->queue, slot->data, CL_FALSE, 0, (size_t)span, base + data_base,
+                                                0, NULL, NULL) != CL_SUCCESS) ||
+            cl->EnqueueWriteBuffer(slot->queue, slot->offsets, CL_FALSE, 0, (size_t)(n + 1) * sizeof(uint64_t),
+                                   offsets + begin, 0, NULL, NULL) != CL_SUCCESS)
+            goto done;
+
+        // 内核参数在入队时被拷贝，两个队列可以共用同一个内核对象
+        if (cl->SetKernelArg(rfc6962_gpu.leaf_kernel, 0, sizeof(cl_mem), &slot->data) != CL_SUCCESS ||
+            cl->SetKernelArg(rfc6962_gpu.leaf_kernel, 1, sizeof(cl_mem), &slot->offsets) != CL_SUCCESS ||
+            cl->SetKernelArg(rfc6962_gpu.leaf_kernel, 2, sizeof(uint64_t), &data_base) != CL_SUCCESS ||
+            cl->SetKernelArg(rfc6962_gpu.leaf_kernel, 3, sizeof(uint64_t), &n) != CL_SUCCESS ||
+            cl->SetKernelArg(rfc6962_gpu.leaf_kernel, 4, sizeof(cl_mem), &slot->nodes) != CL_SUCCESS ||
+            rfc6962_gpu_run(slot->queue, rfc6962_gpu.leaf_kernel, n) != 0)
+            goto done;
+
+        // 块内第 j 层共 ceil(n / 2^j) 个节点，落单的最后一个节点直接提升
+        uint64_t child_count = n;
+        for (int j = 1; j <= chunk_levels; j++)
+        {
+            uint64_t parents = (child_count + 1) / 2;
+
+            if (cl->SetKernelArg(rfc6962_gpu.level_kernel, 0, sizeof(cl_mem), &slot->nodes) != CL_SUCCESS ||
+                cl->SetKernelArg(rfc6962_gpu.level_kernel, 1, sizeof(uint64_t), &level_off[j - 1]) != CL_SUCCESS ||
+                cl->SetKernelArg(rfc6962_gpu.level_kernel, 2, sizeof(uint64_t), &child_count) != CL_SUCCESS ||
+                cl->SetKernelArg(rfc6962_gpu.level_kernel, 3, sizeof(uint64_t), &level_off[j]) != CL_SUCCESS ||
+                cl->SetKernelArg(rfc6962_gpu.level_kernel, 4, sizeof(uint64_t), &parents) != CL_SUCCESS ||
+                rfc6962_gpu_run(slot->queue, rfc6962_gpu.level_kernel, parents) != 0)
+                goto done;
+            child_count = parents;
+        }
+
+        if (tree)
+        {
+            uint64_t size = n;
+            for (int j = 0; j <= chunk_levels; j++)
+            {
+                if (cl->EnqueueReadBuffer(slot->queue, slot->nodes, CL_FALSE,
+                                          (size_t)level_off[j] * sizeof(merkle_node_t),
+                                          (size_t)size * sizeof(merkle_node_t), rfc6962_node(tree, j, begin >> j), 0,
+                                          NULL, NULL) != CL_SUCCESS)
+                    goto done;
+                size = (size + 1) / 2;
+            }
+        }
+        else if (cl->EnqueueReadBuffer(slot->queue, slot->nodes, CL_FALSE,
+                                       (size_t)level_off[chunk_levels] * sizeof(merkle_node_t),
+                                       sizeof(merkle_node_t), tops[c], 0, NULL, NULL) != CL_SUCCESS)
+        {
+            goto done;
+        }
+        cl->Flush(slot->queue);
+    }
+
+    if (cl->Finish(slots[0].queue) == CL_SUCCESS && cl->Finish(slots[1].queue) == CL_SUCCESS)
+        ret = 0;
+
+done:
+    rfc6962_gpu_slot_release(&slots[0]);
+    rfc6962_gpu_slot_release(&slots[1]);
+    return ret;
+}
+// 块大小：整棵树不足一块时整棵树就是一块
+static int rfc6962_gpu_chunk_levels(uint64_t count)
+{
+    int levels = 0;
+
+    while (levels < RFC6962_GPU_CHUNK_LEVELS && ((uint64_t)1 << levels) < count)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+// 逐层两两归约到根，nodes 与 scratch 交替作为输入和输出
+static void rfc6962_gpu_reduce(merkle_node_t *nodes, merkle_node_t *scratch, uint64_t n, uint8_t *root)
+{
+    while (n > 1)
+    {
+        uint64_t pairs = n / 2;
+        merkle_node_t *swap;
+
+        hash_level(scratch, nodes, pairs);
+        if (n & 1)
+            memcpy(scratch[pairs], nodes[n - 1], SM3_DIGEST_SIZE);
+        swap = nodes;
+        nodes = scratch;
+        scratch = swap;
+        n = (n + 1) / 2;
+    }
+    memcpy(root, nodes[0], SM3_DIGEST_SIZE);
+}
+
+#endif
+
+int rfc6962_gpu_available(void)
+{
+#ifdef RFC6962_GPU
+    pthread_once(&rfc6962_gpu_once, rfc6962_gpu_init);
+    return rfc6962_gpu.ready;
+#else
+    return 0;
+#endif
+}
+
+const char *rfc6962_gpu_device_name(void)
+{
+#ifdef RFC6962_GPU
+    if (rfc6962_gpu_available())
+        return rfc6962_gpu.name;
+#endif
+    return NULL;
+}
+
+// 本次构建是否走设备：AUTO 且叶子太少时不值得传输
+static int rfc6962_gpu_wanted(uint64_t count, int backend)
+{
+    if (backend == RFC6962_BACKEND_CPU)
+        return 0;
+    if (backend == RFC6962_BACKEND_AUTO && count < RFC6962_GPU_MIN_LEAVES)
+        return 0;
+    return rfc6962_gpu_available();
+}
+
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_device(const uint8_t *base, const uint64_t *offsets, uint64_t count,
+                                                        int backend)
+{
+    if (count == 0)
+        return NULL;
+    if (!rfc6962_gpu_wanted(count, backend))
+        return backend == RFC6962_BACKEND_GPU ? NULL : build_rfc6962_merkle_tree_buffer(base, offsets, count, 0);
+
+#ifdef RFC6962_GPU
+    SM3_STAT_TIMER(start);
+    rfc6962_merkle_tree_t *tree = rfc6962_tree_create(count);
+    int chunk_levels = rfc6962_gpu_chunk_levels(count);
+
+    if (!tree)
+        return NULL;
+    rfc6962_set_size(tree, count);
+    if (rfc6962_gpu_chunks(base, offsets, count, chunk_levels, tree, NULL) != 0)
+    {
+        free_rfc6962_merkle_tree(tree);
+        return backend == RFC6962_BACKEND_GPU ? NULL : build_rfc6962_merkle_tree_buffer(base, offsets, count, 0);
+    }
+    rfc6962_hash_levels(tree, chunk_levels);
+
+    SM3_STAT_ADD(tree_builds, 1);
+    SM3_STAT_ADD(tree_build_leaves, count);
+    SM3_STAT_LATENCY(tree_build_ns, start, tree_build, count);
+    return tree;
+#else
+    return NULL;
+#endif
+}
+
+int rfc6962_root_device(const uint8_t *base, const uint64_t *offsets, uint64_t count, int backend, uint8_t *root)
+{
+    if (count == 0)
+    {
+        rfc6962_empty_root(root);
+        return 0;
+    }
+
+#ifdef RFC6962_GPU
+    if (rfc6962_gpu_wanted(count, backend))
+    {
+        int chunk_levels = rfc6962_gpu_chunk_levels(count);
+        uint64_t chunk_count = ((count - 1) >> chunk_levels) + 1;
+        merkle_node_t *tops = malloc((size_t)(chunk_count + chunk_count / 2 + 1) * sizeof(merkle_node_t));
+        int ret = -1;
+
+        // 块从 2^chunk_levels 的整数倍开始，块根正是第 chunk_levels 层，按同样的规则继续归约即为 MTH
+        if (tops && rfc6962_gpu_chunks(base, offsets, count, chunk_levels, NULL, tops) == 0)
+        {
+            rfc6962_gpu_reduce(tops, tops + chunk_count, chunk_count, root);
+            ret = 0;
+        }
+        free(tops);
+        if (ret == 0 || backend == RFC6962_BACKEND_GPU)
+            return ret;
+    }
+#endif
+    if (backend == RFC6962_BACKEND_GPU)
+        return -1;
+
+    rfc6962_merkle_tree_t *tree = build_rfc6962_merkle_tree_buffer(base, offsets, count, 0);
+    if (!tree)
+        return -1;
+    memcpy(root, tree->root_hash, SM3_DIGEST_SIZE);
+    free_rfc6962_merkle_tree(tree);
+    return 0;
+}
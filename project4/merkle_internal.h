@@ -0,0 +1,80 @@
+/*
+ * RFC6962 Merkle Tree Internal Definitions
+ * Merkle 树各模块共享的内部定义（不对外安装）
+ */
+
+#ifndef MERKLE_INTERNAL_H
+#define MERKLE_INTERNAL_H
+
+#include "merkle_rfc6962.h"
+#include "sm3_stats.h"
+
+// 树在某个大小下的只读视图
+// 完整子树的节点一经写入便不再改变，直接读节点区；右边缘不完整的节点（每层至多一个）
+// 取自 edge[level]。edge 为 NULL 时视图就是树的当前状态
+typedef struct
+{
+    const rfc6962_merkle_tree_t *tree;
+    uint64_t size;
+    int level_count;
+    const uint64_t *level_size;
+    const merkle_node_t *edge;
+    const uint8_t *root_hash;
+} rfc6962_view_t;
+
+static inline const uint8_t *rfc6962_view_node(const rfc6962_view_t *view, int level, uint64_t index)
+{
+    SM3_STAT_ADD(node_hits, 1);
+    if (view->edge && ((index + 1) << level) > view->size)
+        return view->edge[level];
+    return rfc6962_node(view->tree, level, index);
+}
+
+void rfc6962_view_current(const rfc6962_merkle_tree_t *tree, rfc6962_view_t *view);
+// 并发树快照对应的视图（merkle_concurrent.c），在快照 release 之前有效
+void rfc6962_snapshot_view(const rfc6962_concurrent_tree_t *ct, const rfc6962_snapshot_t *snap, rfc6962_view_t *view);
+
+// 历史视图所需的各层节点数与右边缘副本
+typedef struct
+{
+    uint64_t level_size[MERKLE_MAX_LEVELS];
+    merkle_node_t edge[MERKLE_MAX_LEVELS];
+} rfc6962_view_storage_t;
+
+// 由 base 派生大小为 size 的历史视图，至多 O(log n) 次哈希；size 非法返回-1
+int rfc6962_view_at(const rfc6962_view_t *base, uint64_t size, rfc6962_view_storage_t *storage, rfc6962_view_t *view);
+
+// 基于视图的证明生成，公开接口与并发快照共用
+rfc6962_inclusion_proof_t *rfc6962_view_inclusion_proof(const rfc6962_view_t *view, uint64_t leaf_index);
+rfc6962_consistency_proof_t *rfc6962_view_consistency_proof(const rfc6962_view_t *view, uint64_t old_size);
+rfc6962_multiproof_t *rfc6962_view_multiproof(const rfc6962_view_t *view, const uint64_t *indices, uint64_t count);
+int rfc6962_view_root_at(const rfc6962_view_t *view, uint64_t size, uint8_t *root);
+rfc6962_compact_proof_t *rfc6962_view_compact_proof(const rfc6962_view_t *view, uint64_t leaf_index,
+                                                    rfc6962_arena_t *arena);
+
+// 按 RFC 9162 2.1.3.2 节验证审计路径，路径节点左右位置只由 leaf_index 与 tree_size 决定
+int rfc6962_verify_path(uint64_t leaf_index, uint64_t tree_size, const uint8_t *leaf_hash, const merkle_node_t *path,
+                        int path_length, const uint8_t *root_hash);
+
+// 按容量计算各层在节点区中的偏移，每层区域起点按 align 个节点对齐
+// 返回节点区总节点数，*levels 为容量对应的层数
+uint64_t rfc6962_layout(uint64_t capacity, uint64_t align, uint64_t *level_offset, int *levels);
+
+// 设置叶子数并重新计算各层节点数与层数（不做哈希）
+void rfc6962_set_size(rfc6962_merkle_tree_t *tree, uint64_t count);
+
+// 第 from_level 层已完整写入后，自底向上计算其上各层与根
+void rfc6962_hash_levels(rfc6962_merkle_tree_t *tree, int from_level);
+
+// 重新计算右边缘不完整的节点与根，O(log n) 次哈希
+void rfc6962_rebuild_right_edge(rfc6962_merkle_tree_t *tree);
+
+// 空树根 MTH({}) = SM3("")
+void rfc6962_empty_root(uint8_t *root);
+
+// 存储层钩子：只读打开的存储不接受追加；追加完成后提交 [old_size, leaf_count) 涉及的节点；释放映射
+int rfc6962_store_readonly(const rfc6962_merkle_tree_t *tree);
+int rfc6962_store_commit(rfc6962_merkle_tree_t *tree, uint64_t old_size);
+void rfc6962_store_close(rfc6962_merkle_tree_t *tree);
+
+#endif // MERKLE_INTERNAL_H
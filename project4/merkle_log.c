@@ -0,0 +1,78 @@
+/*
+ * RFC6962 Append-only Merkle Log
+ * 追加式增量 Merkle 日志
+ *
+ * 追加一个叶子相当于对 size 做二进制加一：从第 0 层开始，遇到已有的完整子树就与之合并
+ * 并向上进位，因此每次追加均摊一次 hash_children；根由 frontier 从右向左折叠得到
+ */
+
+#include <string.h>
+
+#include "merkle_internal.h"
+
+void rfc6962_log_init(rfc6962_log_t *log)
+{
+    log->size = 0;
+}
+
+void rfc6962_log_append_hash(rfc6962_log_t *log, const uint8_t *leaf_hash)
+{
+    uint8_t carry[SM3_DIGEST_SIZE];
+    int level = 0;
+
+    memcpy(carry, leaf_hash, SM3_DIGEST_SIZE);
+    while ((log->size >> level) & 1)
+    {
+        hash_children(log->frontier[level], carry, carry);
+        level++;
+    }
+    memcpy(log->frontier[level], carry, SM3_DIGEST_SIZE);
+    log->size++;
+}
+
+void rfc6962_log_append(rfc6962_log_t *log, const uint8_t *data, size_t data_len)
+{
+    uint8_t leaf[SM3_DIGEST_SIZE];
+
+    hash_leaf(data, data_len, leaf);
+    rfc6962_log_append_hash(log, leaf);
+}
+
+void rfc6962_log_append_batch(rfc6962_log_t *log, uint8_t **data_array, uint64_t *data_lengths, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i++)
+    {
+        rfc6962_log_append(log, data_array[i], data_lengths[i]);
+    }
+}
+
+void rfc6962_log_root(const rfc6962_log_t *log, uint8_t *root)
+{
+    uint8_t acc[SM3_DIGEST_SIZE];
+    int have = 0;
+
+    if (log->size == 0)
+    {
+        rfc6962_empty_root(root);
+        return;
+    }
+
+    // 由最小的完整子树开始，依次与左侧更大的子树合并
+    for (int level = 0; level < MERKLE_MAX_LEVELS - 1; level++)
+    {
+        if (!((log->size >> level) & 1))
+            continue;
+
+        if (have)
+        {
+            hash_children(log->frontier[level], acc, acc);
+        }
+        else
+        {
+            memcpy(acc, log->frontier[level], SM3_DIGEST_SIZE);
+            have = 1;
+        }
+    }
+
+    memcpy(root, acc, SM3_DIGEST_SIZE);
+}
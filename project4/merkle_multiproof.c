@@ -0,0 +1,242 @@
+/*
+ * RFC6962 Merkle Multiproofs
+ * 批量包含性证明（多叶子证明）
+ *
+ * 对一组叶子逐层向上合并：同一层中两个已知节点互为兄弟时直接配对，
+ * 只有无法由已知节点推出的兄弟才写入证明，且每个只写一次。
+ * 验证方按同样的顺序逐层消费证明节点，每个共享的内部节点只计算一次哈希；
+ * 索引越集中，相对逐个证明节省的带宽与哈希次数越多
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "merkle_internal.h"
+
+static int rfc6962_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// 由叶子数计算各层节点数，返回层数
+static int rfc6962_level_sizes(uint64_t tree_size, uint64_t *level_size)
+{
+    uint64_t size = tree_size;
+    int level = 0;
+
+    while (size > 0)
+    {
+        level_size[level++] = size;
+        if (size == 1)
+            break;
+        size = (size + 1) / 2;
+    }
+    return level;
+}
+
+// 逐层收集证明节点；out 为 NULL 时只计数
+// idx 为已排序、无重复的叶子索引，遍历过程中被原地替换为上一层的索引
+static uint64_t rfc6962_multiproof_walk(const rfc6962_view_t *view, uint64_t *idx, uint64_t count,
+                                        merkle_node_t *out)
+{
+    uint64_t emitted = 0;
+
+    for (int level = 0; level < view->level_count - 1; level++)
+    {
+        uint64_t size = view->level_size[level];
+        uint64_t w = 0;
+
+        for (uint64_t r = 0; r < count; r++)
+        {
+            uint64_t i = idx[r];
+            uint64_t sibling = UINT64_MAX;
+
+            if (i & 1)
+            {
+                sibling = i - 1; // 左兄弟未知（否则已在上一轮配对）
+            }
+            else if (i + 1 < size)
+            {
+                if (r + 1 < count && idx[r + 1] == i + 1)
+                    r++; // 兄弟也是已知节点，直接配对
+                else
+                    sibling = i + 1;
+            }
+            // 否则为被提升的节点，该层无兄弟
+
+            if (sibling != UINT64_MAX)
+            {
+                if (out)
+                    memcpy(out[emitted], rfc6962_view_node(view, level, sibling), SM3_DIGEST_SIZE);
+                emitted++;
+            }
+            idx[w++] = i >> 1;
+        }
+        count = w;
+    }
+    return emitted;
+}
+
+// 在视图上生成批量包含性证明：索引可以无序、可以重复，输出按升序去重
+rfc6962_multiproof_t *rfc6962_view_multiproof(const rfc6962_view_t *view, const uint64_t *indices, uint64_t count)
+{
+    rfc6962_multiproof_t *proof;
+    uint64_t *scratch;
+    uint64_t unique = 0;
+
+    if (count == 0 || view->size == 0)
+        return NULL;
+
+    SM3_STAT_TIMER(start);
+    proof = calloc(1, sizeof(rfc6962_multiproof_t));
+    scratch = malloc((size_t)count * sizeof(uint64_t));
+    if (!proof || !scratch)
+        goto fail;
+
+    memcpy(scratch, indices, (size_t)count * sizeof(uint64_t));
+    qsort(scratch, (size_t)count, sizeof(uint64_t), rfc6962_cmp_u64);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (scratch[i] >= view->size)
+            goto fail;
+        if (unique == 0 || scratch[unique - 1] != scratch[i])
+            scratch[unique++] = scratch[i];
+    }
+
+    proof->tree_size = view->size;
+    proof->leaf_count = unique;
+    memcpy(proof->root_hash, view->root_hash, SM3_DIGEST_SIZE);
+    proof->leaf_indices = malloc((size_t)unique * sizeof(uint64_t));
+    proof->leaf_hashes = malloc((size_t)unique * sizeof(merkle_node_t));
+    if (!proof->leaf_indices || !proof->leaf_hashes)
+        goto fail;
+
+    for (uint64_t i = 0; i < unique; i++)
+    {
+        proof->leaf_indices[i] = scratch[i];
+        memcpy(proof->leaf_hashes[i], rfc6962_view_node(view, 0, scratch[i]), SM3_DIGEST_SIZE);
+    }
+
+    // 先计数再填充，证明节点存放在一块连续内存中
+    proof->node_count = rfc6962_multiproof_walk(view, scratch, unique, NULL);
+    proof->nodes = malloc((size_t)(proof->node_count ? proof->node_count : 1) * sizeof(merkle_node_t));
+    if (!proof->nodes)
+        goto fail;
+    memcpy(scratch, proof->leaf_indices, (size_t)unique * sizeof(uint64_t));
+    rfc6962_multiproof_walk(view, scratch, unique, proof->nodes);
+
+    free(scratch);
+    SM3_STAT_LATENCY(proof_generate_ns[SM3_STATS_PROOF_MULTIPROOF], start, proof_generate, SM3_STATS_PROOF_MULTIPROOF);
+    return proof;
+
+fail:
+    free(scratch);
+    free_rfc6962_multiproof(proof);
+    return NULL;
+}
+
+rfc6962_multiproof_t *generate_rfc6962_multiproof(rfc6962_merkle_tree_t *tree, const uint64_t *indices,
+                                                  uint64_t count)
+{
+    rfc6962_view_t view;
+
+    rfc6962_view_current(tree, &view);
+    return rfc6962_view_multiproof(&view, indices, count);
+}
+
+// 验证批量包含性证明
+static int rfc6962_verify_multiproof(const rfc6962_multiproof_t *proof)
+{
+    uint64_t level_size[MERKLE_MAX_LEVELS];
+    uint64_t *idx;
+    merkle_node_t *hash;
+    uint64_t count = proof->leaf_count;
+    uint64_t consumed = 0;
+    int levels;
+    int ok = 0;
+
+    if (proof->tree_size == 0 || count == 0)
+        return 0;
+
+    // 索引必须严格递增且在范围内
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (proof->leaf_indices[i] >= proof->tree_size || (i > 0 && proof->leaf_indices[i] <= proof->leaf_indices[i - 1]))
+            return 0;
+    }
+
+    idx = malloc((size_t)count * sizeof(uint64_t));
+    hash = malloc((size_t)count * sizeof(merkle_node_t));
+    if (!idx || !hash)
+        goto done;
+
+    memcpy(idx, proof->leaf_indices, (size_t)count * sizeof(uint64_t));
+    memcpy(hash, proof->leaf_hashes, (size_t)count * sizeof(merkle_node_t));
+    levels = rfc6962_level_sizes(proof->tree_size, level_size);
+
+    for (int level = 0; level < levels - 1; level++)
+    {
+        uint64_t w = 0;
+
+        for (uint64_t r = 0; r < count; r++)
+        {
+            uint64_t i = idx[r];
+
+            if (i & 1)
+            {
+                if (consumed >= proof->node_count)
+                    goto done;
+                hash_children(proof->nodes[consumed++], hash[r], hash[w]);
+            }
+            else if (i + 1 < level_size[level])
+            {
+                if (r + 1 < count && idx[r + 1] == i + 1)
+                {
+                    hash_children(hash[r], hash[r + 1], hash[w]);
+                    r++;
+                }
+                else
+                {
+                    if (consumed >= proof->node_count)
+                        goto done;
+                    hash_children(hash[r], proof->nodes[consumed++], hash[w]);
+                }
+            }
+            else if (w != r)
+            {
+                memcpy(hash[w], hash[r], SM3_DIGEST_SIZE);
+            }
+            idx[w++] = i >> 1;
+        }
+        count = w;
+    }
+
+    ok = count == 1 && consumed == proof->node_count && memcmp(hash[0], proof->root_hash, SM3_DIGEST_SIZE) == 0;
+
+done:
+    free(idx);
+    free(hash);
+    return ok;
+}
+
+int verify_rfc6962_multiproof(const rfc6962_multiproof_t *proof)
+{
+    SM3_STAT_TIMER(start);
+    int ok = rfc6962_verify_multiproof(proof);
+
+    SM3_STAT_LATENCY(proof_verify_ns[SM3_STATS_PROOF_MULTIPROOF], start, proof_verify, SM3_STATS_PROOF_MULTIPROOF);
+    return ok;
+}
+
+void free_rfc6962_multiproof(rfc6962_multiproof_t *proof)
+{
+    if (!proof)
+        return;
+
+    free(proof->leaf_indices);
+    free(proof->leaf_hashes);
+    free(proof->nodes);
+    free(proof);
+}
@@ -0,0 +1,1007 @@
+/*
+ * RFC6962 Merkle Tree Implementation
+ * 基于 SM3 的 RFC6962 Merkle 树实现
+ *
+ * 节点区布局（n 为叶子数）：
+ *   第 0 层：n 个叶子哈希
+ *   第 k 层：ceil(n / 2^k) 个节点，第 i 个节点为 MTH(D[i * 2^k : min((i + 1) * 2^k, n)])
+ *            其子节点为第 k-1 层的 2i、2i+1；当 2i+1 不存在时该节点直接提升（拷贝）自 2i
+ * 这正是 RFC6962 的 k 分割树形：右边缘不完整的子树不参与补齐，也不额外哈希，
+ * 各层首尾相接存放在同一块对齐内存中，整棵树只需一次分配
+ */
+
+#define _POSIX_C_SOURCE 200112L // posix_memalign, pthread, sysconf
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "merkle_internal.h"
+
+// RFC6962标准的哈希函数
+// 域分隔前缀作为单独的一次 update 送入栈上的流式上下文，不拷贝、不分配堆内存
+static const uint8_t rfc6962_leaf_prefix = 0x00;
+static const uint8_t rfc6962_node_prefix = 0x01;
+
+void hash_leaf(const uint8_t *data, size_t data_len, uint8_t *output)
+{
+    // RFC6962: H(0x00 || data)
+    sm3_context_t ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, &rfc6962_leaf_prefix, 1);
+    sm3_update(&ctx, data, data_len);
+    sm3_final(&ctx, output);
+}
+
+void hash_children(const uint8_t *left, const uint8_t *right, uint8_t *output)
+{
+    // RFC6962: H(0x01 || left || right)
+    sm3_context_t ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, &rfc6962_node_prefix, 1);
+    sm3_update(&ctx, left, SM3_DIGEST_SIZE);
+    sm3_update(&ctx, right, SM3_DIGEST_SIZE);
+    sm3_final(&ctx, output);
+}
+
+// 批量接口每次交给多路引擎的消息数：指针与长度数组放在栈上，远大于通道数以保持各路满载
+#define RFC6962_HASH_BATCH 256
+// 少于此数的节点逐个哈希，避免多路调度的固定开销
+#define RFC6962_HASH_BATCH_MIN 4
+
+// 域分隔前缀作为 1 字节的前缀中间状态：多路引擎把它与消息开头直接拼进各路的首块，
+// 不为每条消息准备 0x00 || data 的暂存副本
+void hash_leaves_batch(const uint8_t *const *data, const size_t *lens, merkle_node_t *out, uint64_t count)
+{
+    sm3_prefix_t prefix;
+
+    sm3_prefix_init(&prefix, &rfc6962_leaf_prefix, 1);
+    sm3_hash_many_prefixed(&prefix, data, lens, out, (size_t)count);
+}
+
+// 每一层的输入都是等长的 65 字节 0x01 || L || R，正好适合多路并行：
+// 孩子节点在节点区中相邻存放，第 i 对孩子就是 children[2i] 起的 64 字节，直接作为后缀
+void hash_level(merkle_node_t *parents, const merkle_node_t *children, uint64_t n)
+{
+    const uint8_t *pairs[RFC6962_HASH_BATCH];
+    size_t lens[RFC6962_HASH_BATCH];
+    sm3_prefix_t prefix;
+
+    if (n < RFC6962_HASH_BATCH_MIN)
+    {
+        for (uint64_t i = 0; i < n; i++)
+            hash_children(children[2 * i], children[2 * i + 1], parents[i]);
+        return;
+    }
+
+    sm3_prefix_init(&prefix, &rfc6962_node_prefix, 1);
+    for (int i = 0; i < RFC6962_HASH_BATCH; i++)
+        lens[i] = 2 * SM3_DIGEST_SIZE;
+    for (uint64_t done = 0; done < n; done += RFC6962_HASH_BATCH)
+    {
+        uint64_t batch = n - done < RFC6962_HASH_BATCH ? n - done : RFC6962_HASH_BATCH;
+
+        for (uint64_t i = 0; i < batch; i++)
+            pairs[i] = children[2 * (done + i)];
+        sm3_hash_many_prefixed(&prefix, pairs, lens, parents + done, (size_t)batch);
+    }
+}
+
+// RFC6962: MTH({}) = HASH()
+void rfc6962_empty_root(uint8_t *root)
+{
+    static const uint8_t empty = 0;
+    sm3_hash(&empty, 0, root);
+}
+
+// 按容量计算各层偏移
+uint64_t rfc6962_layout(uint64_t capacity, uint64_t align, uint64_t *level_offset, int *levels)
+{
+    uint64_t offset = 0;
+    uint64_t size = capacity;
+    int level = 0;
+
+    for (;;)
+    {
+        level_offset[level++] = offset;
+        offset += (size + align - 1) / align * align;
+        if (size <= 1)
+            break;
+        size = (size + 1) / 2;
+    }
+
+    *levels = level;
+    return offset;
+}
+
+void rfc6962_set_size(rfc6962_merkle_tree_t *tree, uint64_t count)
+{
+    uint64_t size = count;
+    int level = 0;
+
+    tree->leaf_count = count;
+    while (size > 0)
+    {
+        tree->level_size[level++] = size;
+        if (size == 1)
+            break;
+        size = (size + 1) / 2;
+    }
+    tree->level_count = level;
+}
+
+// 分配节点区并计算各层偏移
+static int rfc6962_alloc_levels(rfc6962_merkle_tree_t *tree, uint64_t capacity)
+{
+    void *arena;
+    int levels;
+    uint64_t total = rfc6962_layout(capacity, 1, tree->level_offset, &levels);
+
+    if (posix_memalign(&arena, MERKLE_NODE_ALIGN, total * sizeof(merkle_node_t)) != 0)
+        return -1;
+
+    tree->nodes = arena;
+    tree->leaves = tree->nodes;
+    tree->capacity = capacity;
+    tree->node_count = total;
+    tree->store = NULL;
+    rfc6962_set_size(tree, 0);
+    rfc6962_empty_root(tree->root_hash);
+    return 0;
+}
+
+// 计算第 level 层的节点 [lo, hi)（level >= 1），子节点取自第 level-1 层
+// 该层落单的最后一个节点直接提升，因此整棵树总计恰好 n-1 次 hash_children
+static void rfc6962_hash_range(rfc6962_merkle_tree_t *tree, int level, uint64_t lo, uint64_t hi)
+{
+    uint64_t child_size = tree->level_size[level - 1];
+    uint64_t pairs = child_size / 2; // 有两个孩子的节点为 [0, pairs)
+    uint64_t end = hi < pairs ? hi : pairs;
+
+    if (lo < end)
+        hash_level((merkle_node_t *)rfc6962_node(tree, level, lo),
+                   (const merkle_node_t *)rfc6962_node(tree, level - 1, 2 * lo), end - lo);
+    if (lo <= pairs && pairs < hi && (child_size & 1))
+        memcpy(rfc6962_node(tree, level, pairs), rfc6962_node(tree, level - 1, 2 * pairs), SM3_DIGEST_SIZE);
+}
+
+// 由第 from_level 层自底向上计算其上各层（原地写入节点区）
+void rfc6962_hash_levels(rfc6962_merkle_tree_t *tree, int from_level)
+{
+    for (int level = from_level + 1; level < tree->level_count; level++)
+    {
+        rfc6962_hash_range(tree, level, 0, tree->level_size[level]);
+    }
+    memcpy(tree->root_hash, rfc6962_node(tree, tree->level_count - 1, 0), SM3_DIGEST_SIZE);
+}
+
+// 并行构建：叶子层按 2^chunk_levels 个叶子切分为若干块，每块是一棵独立子树，
+// 由工作线程完成叶子哈希及块内 chunk_levels 层；块以上的少数几层由主线程串行归约
+typedef struct
+{
+    rfc6962_merkle_tree_t *tree;
+    rfc6962_leaf_source_fn source;
+    void *source_ctx;
+    int chunk_levels;
+    uint64_t chunk_count;
+    uint64_t next_chunk; // 下一个待领取的块，__atomic 原子递增
+} rfc6962_build_job_t;
+
+static void rfc6962_build_chunk(rfc6962_build_job_t *job, uint64_t chunk)
+{
+    rfc6962_merkle_tree_t *tree = job->tree;
+    uint64_t begin = chunk << job->chunk_levels;
+    uint64_t end = (chunk + 1) << job->chunk_levels;
+
+    if (end > tree->leaf_count)
+        end = tree->leaf_count;
+
+    // 计算叶子哈希：按批取出记录位置，整批经多路引擎
+    for (uint64_t i = begin; i < end; i += RFC6962_HASH_BATCH)
+    {
+        const uint8_t *data[RFC6962_HASH_BATCH];
+        size_t lens[RFC6962_HASH_BATCH];
+        uint64_t batch = end - i < RFC6962_HASH_BATCH ? end - i : RFC6962_HASH_BATCH;
+
+        for (uint64_t j = 0; j < batch; j++)
+            job->source(job->source_ctx, i + j, &data[j], &lens[j]);
+        hash_leaves_batch(data, lens, tree->leaves + i, batch);
+    }
+
+    // 块内各层：第 level 层覆盖 [begin >> level, ceil(end / 2^level))
+    for (int level = 1; level <= job->chunk_levels; level++)
+    {
+        uint64_t lo = begin >> level;
+        uint64_t hi = (end + ((uint64_t)1 << level) - 1) >> level;
+        rfc6962_hash_range(tree, level, lo, hi);
+    }
+}
+
+static void *rfc6962_build_worker(void *arg)
+{
+    rfc6962_build_job_t *job = arg;
+
+    for (;;)
+    {
+        uint64_t chunk = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= job->chunk_count)
+            break;
+        rfc6962_build_chunk(job, chunk);
+    }
+    return NULL;
+}
+
+// 选择块大小：至少 2^RFC6962_MIN_CHUNK_LEVELS 个叶子，并保证每个线程平均能分到约4块
+#define RFC6962_MIN_CHUNK_LEVELS 10
+#define RFC6962_CHUNKS_PER_THREAD 4
+
+static int rfc6962_pick_chunk_levels(uint64_t count, int threads)
+{
+    int levels = RFC6962_MIN_CHUNK_LEVELS;
+    while (levels < 63 && (count >> (levels + 1)) >= (uint64_t)threads * RFC6962_CHUNKS_PER_THREAD)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+// 小于 n 的最大2的幂（n > 1）
+static uint64_t rfc6962_split_point(uint64_t n)
+{
+    uint64_t k = 1;
+    while (k * 2 < n)
+    {
+        k *= 2;
+    }
+    return k;
+}
+
+// 查找子树 D[start : start + size] 的哈希
+// 要求该子树是当前树中的一个节点（起点按 2^j 对齐，且为完整子树或延伸到树的右边缘），
+// 一致性证明递归中出现的子树均满足此条件，因此只需查表
+static const uint8_t *rfc6962_subtree_hash(const rfc6962_view_t *view, uint64_t start, uint64_t size)
+{
+    int level = 0;
+    while (((uint64_t)1 << level) < size)
+    {
+        level++;
+    }
+    return rfc6962_view_node(view, level, start >> level);
+}
+
+void rfc6962_view_current(const rfc6962_merkle_tree_t *tree, rfc6962_view_t *view)
+{
+    view->tree = tree;
+    view->size = tree->leaf_count;
+    view->level_count = tree->level_count;
+    view->level_size = tree->level_size;
+    view->edge = NULL;
+    view->root_hash = tree->root_hash;
+}
+
+// 由 base 派生大小为 size（0 < size <= base->size）的历史视图
+// 完整子树的节点直接取自 base，只有右边缘每层至多一个不完整的节点需要由其左孩子（完整）
+// 与右孩子（不完整）合并得到，至多 ceil(log2 size) 次哈希；size 等于 base->size 时不做哈希
+int rfc6962_view_at(const rfc6962_view_t *base, uint64_t size, rfc6962_view_storage_t *storage, rfc6962_view_t *view)
+{
+    int level = 0;
+
+    if (size == 0 || size > base->size)
+        return -1;
+    if (size == base->size)
+    {
+        *view = *base;
+        return 0;
+    }
+
+    storage->level_size[0] = size;
+    while (storage->level_size[level] > 1)
+    {
+        uint64_t last = storage->level_size[level] - 1;
+        uint64_t parent = last >> 1;
+
+        storage->level_size[level + 1] = parent + 1;
+        if (((parent + 1) << (level + 1)) > size)
+        {
+            // 父节点不完整：孩子中只有最后一个可能不完整
+            const uint8_t *child = ((last + 1) << level) > size ? storage->edge[level]
+                                                               : rfc6962_view_node(base, level, last);
+            if (last & 1)
+            {
+                SM3_STAT_ADD(node_misses, 1);
+                hash_children(rfc6962_view_node(base, level, last - 1), child, storage->edge[level + 1]);
+            }
+            else
+                memcpy(storage->edge[level + 1], child, SM3_DIGEST_SIZE); // 被提升的节点
+        }
+        level++;
+    }
+
+    view->tree = base->tree;
+    view->size = size;
+    view->level_count = level + 1;
+    view->level_size = storage->level_size;
+    view->edge = (const merkle_node_t *)storage->edge;
+    view->root_hash = ((uint64_t)1 << level) > size ? storage->edge[level] : rfc6962_view_node(base, level, 0);
+    return 0;
+}
+
+// 审计路径 PATH(m, D[n]) 的节点数：被提升的节点（所在层最后一个且没有右兄弟）不产生路径节点
+static int rfc6962_path_length(const rfc6962_view_t *view, uint64_t target_index)
+{
+    int length = 0;
+
+    for (int level = 0; level < view->level_count - 1; level++, target_index >>= 1)
+    {
+        if ((target_index & 1) || target_index + 1 < view->level_size[level])
+            length++;
+    }
+    return length;
+}
+
+// 从常驻的各层节点中直接查找审计路径：每层至多取一个兄弟节点，不做任何哈希计算
+// path 须能容纳 rfc6962_path_length 个节点；directions（0=兄弟在左, 1=兄弟在右）与
+// direction_bits（第 i 位为 directions[i]）可为 NULL
+static int rfc6962_fill_path(const rfc6962_view_t *view, uint64_t target_index, merkle_node_t *path,
+                             int *directions, uint64_t *direction_bits)
+{
+    uint64_t current_idx = target_index;
+    uint64_t bits = 0;
+    int length = 0;
+
+    for (int level = 0; level < view->level_count - 1; level++)
+    {
+        uint64_t sibling_idx;
+        int right;
+        if (current_idx % 2 == 0)
+        {
+            if (current_idx + 1 >= view->level_size[level])
+            {
+                current_idx = current_idx / 2; // 被提升，直接进入上一层
+                continue;
+            }
+            // 当前节点是左子节点，兄弟在右边
+            sibling_idx = current_idx + 1;
+            right = 1;
+        }
+        else
+        {
+            // 当前节点是右子节点，兄弟在左边
+            sibling_idx = current_idx - 1;
+            right = 0;
+        }
+
+        memcpy(path[length], rfc6962_view_node(view, level, sibling_idx), SM3_DIGEST_SIZE);
+        if (directions)
+            directions[length] = right;
+        bits |= (uint64_t)right << length;
+        length++;
+
+        current_idx = current_idx / 2; // 向上一层
+    }
+
+    if (direction_bits)
+        *direction_bits = bits;
+    return length;
+}
+
+// 叶子来源：指针数组 + 长度数组
+typedef struct
+{
+    uint8_t **data_array;
+    uint64_t *data_lengths;
+} rfc6962_array_source_t;
+
+static void rfc6962_array_source(void *ctx, uint64_t index, const uint8_t **data, size_t *data_len)
+{
+    rfc6962_array_source_t *src = ctx;
+    *data = src->data_array[index];
+    *data_len = (size_t)src->data_lengths[index];
+}
+
+// 叶子来源：一块连续缓冲区 + 偏移表，第 i 条记录为 base[offsets[i], offsets[i + 1])
+typedef struct
+{
+    const uint8_t *base;
+    const uint64_t *offsets;
+} rfc6962_buffer_source_t;
+
+static void rfc6962_buffer_source(void *ctx, uint64_t index, const uint8_t **data, size_t *data_len)
+{
+    rfc6962_buffer_source_t *src = ctx;
+    *data = src->base + src->offsets[index];
+    *data_len = (size_t)(src->offsets[index + 1] - src->offsets[index]);
+}
+
+// 构建RFC6962 Merkle树（单线程）
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree(uint8_t **data_array, uint64_t *data_lengths, uint64_t count)
+{
+    return build_rfc6962_merkle_tree_mt(data_array, data_lengths, count, 1);
+}
+
+// 多线程构建RFC6962 Merkle树，结果与单线程逐位一致
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_mt(uint8_t **data_array, uint64_t *data_lengths, uint64_t count,
+                                                    int threads)
+{
+    rfc6962_array_source_t src = {data_array, data_lengths};
+    return build_rfc6962_merkle_tree_source(rfc6962_array_source, &src, count, threads);
+}
+
+// 零拷贝构建：叶子直接从调用方的连续缓冲区中就地哈希
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_buffer(const uint8_t *base, const uint64_t *offsets, uint64_t count,
+                                                        int threads)
+{
+    rfc6962_buffer_source_t src = {base, offsets};
+    return build_rfc6962_merkle_tree_source(rfc6962_buffer_source, &src, count, threads);
+}
+
+// 通用构建入口：叶子由回调提供
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_source(rfc6962_leaf_source_fn source, void *source_ctx,
+                                                        uint64_t count, int threads)
+{
+    if (count == 0)
+        return NULL;
+
+    SM3_STAT_TIMER(start);
+    rfc6962_merkle_tree_t *tree = malloc(sizeof(rfc6962_merkle_tree_t));
+    if (!tree)
+        return NULL;
+
+    if (rfc6962_alloc_levels(tree, count) != 0)
+    {
+        free(tree);
+        return NULL;
+    }
+    rfc6962_set_size(tree, count);
+
+    if (threads <= 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+
+    rfc6962_build_job_t job;
+    job.tree = tree;
+    job.source = source;
+    job.source_ctx = source_ctx;
+    job.chunk_levels = rfc6962_pick_chunk_levels(count, threads);
+    if (job.chunk_levels > tree->level_count - 1)
+        job.chunk_levels = tree->level_count - 1;
+    job.chunk_count = ((count - 1) >> job.chunk_levels) + 1;
+    job.next_chunk = 0;
+
+    if ((uint64_t)threads > job.chunk_count)
+        threads = (int)job.chunk_count;
+
+    // 主线程也作为一个工作线程参与；线程创建失败时由已有线程领取剩余块
+    pthread_t *workers = NULL;
+    int started = 0;
+    if (threads > 1)
+    {
+        workers = malloc((size_t)(threads - 1) * sizeof(pthread_t));
+        for (int t = 0; workers && t < threads - 1; t++)
+        {
+            if (pthread_create(&workers[t], NULL, rfc6962_build_worker, &job) != 0)
+                break;
+            started++;
+        }
+    }
+    rfc6962_build_worker(&job);
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(workers[t], NULL);
+    }
+    free(workers);
+
+    // 块以上各层串行归约
+    rfc6962_hash_levels(tree, job.chunk_levels);
+
+    SM3_STAT_ADD(tree_builds, 1);
+    SM3_STAT_ADD(tree_build_leaves, count);
+    SM3_STAT_LATENCY(tree_build_ns, start, tree_build, count);
+    return tree;
+}
+
+// 重新计算右边缘不完整的节点（每层至多一个），完整子树的节点一经写入便不再改变
+void rfc6962_rebuild_right_edge(rfc6962_merkle_tree_t *tree)
+{
+    if (tree->leaf_count == 0)
+    {
+        rfc6962_empty_root(tree->root_hash);
+        return;
+    }
+
+    for (int level = 1; level < tree->level_count; level++)
+    {
+        uint64_t last = tree->level_size[level] - 1;
+        if (((last + 1) << level) > tree->leaf_count)
+            rfc6962_hash_range(tree, level, last, last + 1);
+    }
+    memcpy(tree->root_hash, rfc6962_node(tree, tree->level_count - 1, 0), SM3_DIGEST_SIZE);
+}
+
+// 预留容量的空树
+rfc6962_merkle_tree_t *rfc6962_tree_create(uint64_t capacity)
+{
+    if (capacity == 0)
+        return NULL;
+
+    rfc6962_merkle_tree_t *tree = malloc(sizeof(rfc6962_merkle_tree_t));
+    if (!tree)
+        return NULL;
+
+    if (rfc6962_alloc_levels(tree, capacity) != 0)
+    {
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+// 叶子层已写入 [old_size, leaf_count) 后，重新计算右边缘受影响的节点：
+// 第 k 层为 [old_size >> k, level_size[k])，批量追加 m 个叶子约需 m + log n 次哈希
+static int rfc6962_finish_append(rfc6962_merkle_tree_t *tree, uint64_t old_size)
+{
+    for (int level = 1; level < tree->level_count; level++)
+    {
+        rfc6962_hash_range(tree, level, old_size >> level, tree->level_size[level]);
+    }
+    memcpy(tree->root_hash, rfc6962_node(tree, tree->level_count - 1, 0), SM3_DIGEST_SIZE);
+
+    if (tree->store)
+        return rfc6962_store_commit(tree, old_size);
+    return 0;
+}
+
+int rfc6962_tree_append_hash(rfc6962_merkle_tree_t *tree, const uint8_t *leaf_hash)
+{
+    uint64_t old_size = tree->leaf_count;
+
+    // 只读存储的映射是 MAP_PRIVATE：写进去的叶子不会落盘，提交前就要拒绝，保持树不变
+    if (old_size >= tree->capacity || rfc6962_store_readonly(tree))
+        return -1;
+
+    memcpy(tree->leaves[old_size], leaf_hash, SM3_DIGEST_SIZE);
+    rfc6962_set_size(tree, old_size + 1);
+    return rfc6962_finish_append(tree, old_size);
+}
+
+int rfc6962_tree_append(rfc6962_merkle_tree_t *tree, const uint8_t *data, size_t data_len)
+{
+    uint8_t leaf[SM3_DIGEST_SIZE];
+
+    hash_leaf(data, data_len, leaf);
+    return rfc6962_tree_append_hash(tree, leaf);
+}
+
+int rfc6962_tree_append_batch(rfc6962_merkle_tree_t *tree, uint8_t **data_array, uint64_t *data_lengths,
+                              uint64_t count)
+{
+    uint64_t old_size = tree->leaf_count;
+
+    if (count == 0)
+        return 0;
+    if (count > tree->capacity - old_size || rfc6962_store_readonly(tree))
+        return -1;
+
+    for (uint64_t i = 0; i < count; i += RFC6962_HASH_BATCH)
+    {
+        size_t lens[RFC6962_HASH_BATCH];
+        uint64_t batch = count - i < RFC6962_HASH_BATCH ? count - i : RFC6962_HASH_BATCH;
+
+        for (uint64_t j = 0; j < batch; j++)
+            lens[j] = (size_t)data_lengths[i + j];
+        hash_leaves_batch((const uint8_t *const *)data_array + i, lens, tree->leaves + old_size + i, batch);
+    }
+    rfc6962_set_size(tree, old_size + count);
+    return rfc6962_finish_append(tree, old_size);
+}
+
+// 生成RFC6962审计路径
+rfc6962_audit_path_t *generate_rfc6962_audit_path(rfc6962_merkle_tree_t *tree, uint64_t leaf_index)
+{
+    if (leaf_index >= tree->leaf_count)
+        return NULL;
+
+    rfc6962_audit_path_t *path = malloc(sizeof(rfc6962_audit_path_t));
+    if (!path)
+        return NULL;
+
+    rfc6962_view_t view;
+    rfc6962_view_current(tree, &view);
+    int length = rfc6962_path_length(&view, leaf_index);
+    path->leaf_index = leaf_index;
+    path->path = malloc((size_t)(length ? length : 1) * sizeof(merkle_node_t));
+    path->directions = malloc((size_t)(length ? length : 1) * sizeof(int));
+    if (!path->path || !path->directions)
+    {
+        free(path->path);
+        free(path->directions);
+        free(path);
+        return NULL;
+    }
+    path->path_length = rfc6962_fill_path(&view, leaf_index, path->path, path->directions, NULL);
+
+    return path;
+}
+
+// 验证RFC6962包含性证明
+// 按 RFC 9162 2.1.3.2 节的算法，仅由 leaf_index 与 tree_size 确定每个路径节点的左右位置，
+// 与 CT 风格的验证器一致（directions 字段仅供展示）
+int rfc6962_verify_path(uint64_t leaf_index, uint64_t tree_size, const uint8_t *leaf_hash, const merkle_node_t *path,
+                        int path_length, const uint8_t *root_hash)
+{
+    uint8_t computed_hash[SM3_DIGEST_SIZE];
+    uint64_t fn = leaf_index;
+    uint64_t sn;
+
+    if (tree_size == 0 || leaf_index >= tree_size)
+        return 0;
+
+    sn = tree_size - 1;
+    memcpy(computed_hash, leaf_hash, SM3_DIGEST_SIZE);
+
+    // 从叶子向根重建路径
+    for (int i = 0; i < path_length; i++)
+    {
+        if (sn == 0)
+            return 0;
+
+        if ((fn & 1) || fn == sn)
+        {
+            // 兄弟在左边，当前节点在右边
+            hash_children(path[i], computed_hash, computed_hash);
+            // 跳过当前节点被提升的各层
+            if (!(fn & 1))
+            {
+                while (fn != 0 && !(fn & 1))
+                {
+                    fn >>= 1;
+                    sn >>= 1;
+                }
+            }
+        }
+        else
+        {
+            // 兄弟在右边，当前节点在左边
+            hash_children(computed_hash, path[i], computed_hash);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+
+    return sn == 0 && memcmp(computed_hash, root_hash, SM3_DIGEST_SIZE) == 0;
+}
+
+int verify_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof)
+{
+    SM3_STAT_TIMER(start);
+    int ok = rfc6962_verify_path(proof->leaf_index, proof->tree_size, proof->leaf_hash, proof->audit_path.path,
+                                 proof->audit_path.path_length, proof->root_hash);
+
+    SM3_STAT_LATENCY(proof_verify_ns[SM3_STATS_PROOF_INCLUSION], start, proof_verify, SM3_STATS_PROOF_INCLUSION);
+    return ok;
+}
+
+// 在视图上生成包含性证明
+rfc6962_inclusion_proof_t *rfc6962_view_inclusion_proof(const rfc6962_view_t *view, uint64_t leaf_index)
+{
+    if (leaf_index >= view->size)
+        return NULL;
+
+    // 证明头、路径节点与方向数组放在同一块内存中，一次分配、一次释放
+    SM3_STAT_TIMER(start);
+    int length = rfc6962_path_length(view, leaf_index);
+    rfc6962_inclusion_proof_t *proof =
+        malloc(sizeof(rfc6962_inclusion_proof_t) + (size_t)length * (sizeof(merkle_node_t) + sizeof(int)));
+    if (!proof)
+        return NULL;
+
+    proof->leaf_index = leaf_index;
+    memcpy(proof->leaf_hash, rfc6962_view_node(view, 0, leaf_index), SM3_DIGEST_SIZE);
+    memcpy(proof->root_hash, view->root_hash, SM3_DIGEST_SIZE);
+    proof->tree_size = view->size;
+
+    proof->audit_path.leaf_index = leaf_index;
+    proof->audit_path.path = (merkle_node_t *)(proof + 1);
+    proof->audit_path.directions = (int *)(proof->audit_path.path + length);
+    proof->audit_path.path_length =
+        rfc6962_fill_path(view, leaf_index, proof->audit_path.path, proof->audit_path.directions, NULL);
+
+    SM3_STAT_LATENCY(proof_generate_ns[SM3_STATS_PROOF_INCLUSION], start, proof_generate, SM3_STATS_PROOF_INCLUSION);
+    return proof;
+}
+
+// 生成包含性证明
+rfc6962_inclusion_proof_t *generate_rfc6962_inclusion_proof(rfc6962_merkle_tree_t *tree, uint64_t leaf_index)
+{
+    rfc6962_view_t view;
+
+    rfc6962_view_current(tree, &view);
+    return rfc6962_view_inclusion_proof(&view, leaf_index);
+}
+
+// 在视图上生成紧凑包含性证明：头部与路径节点为一整块，取自 arena（NULL 时 malloc）
+rfc6962_compact_proof_t *rfc6962_view_compact_proof(const rfc6962_view_t *view, uint64_t leaf_index,
+                                                    rfc6962_arena_t *arena)
+{
+    rfc6962_compact_proof_t *proof;
+    int depth;
+    size_t size;
+
+    if (leaf_index >= view->size)
+        return NULL;
+
+    SM3_STAT_TIMER(start);
+    depth = rfc6962_path_length(view, leaf_index);
+    size = RFC6962_COMPACT_PROOF_SIZE(depth);
+    proof = arena ? rfc6962_arena_alloc(arena, size) : malloc(size);
+    if (!proof)
+        return NULL;
+
+    proof->leaf_index = leaf_index;
+    proof->tree_size = view->size;
+    memcpy(proof->leaf_hash, rfc6962_view_node(view, 0, leaf_index), SM3_DIGEST_SIZE);
+    memcpy(proof->root_hash, view->root_hash, SM3_DIGEST_SIZE);
+    proof->depth = (uint32_t)depth;
+    proof->reserved = 0;
+    rfc6962_fill_path(view, leaf_index, proof->path, NULL, &proof->directions);
+
+    SM3_STAT_LATENCY(proof_generate_ns[SM3_STATS_PROOF_INCLUSION], start, proof_generate, SM3_STATS_PROOF_INCLUSION);
+    return proof;
+}
+
+rfc6962_compact_proof_t *generate_rfc6962_compact_proof(rfc6962_merkle_tree_t *tree, uint64_t leaf_index,
+                                                        rfc6962_arena_t *arena)
+{
+    rfc6962_view_t view;
+
+    rfc6962_view_current(tree, &view);
+    return rfc6962_view_compact_proof(&view, leaf_index, arena);
+}
+
+int verify_rfc6962_compact_proof(const rfc6962_compact_proof_t *proof)
+{
+    SM3_STAT_TIMER(start);
+    int ok = proof->depth < MERKLE_MAX_LEVELS &&
+             rfc6962_verify_path(proof->leaf_index, proof->tree_size, proof->leaf_hash,
+                                 (const merkle_node_t *)proof->path, (int)proof->depth, proof->root_hash);
+
+    SM3_STAT_LATENCY(proof_verify_ns[SM3_STATS_PROOF_INCLUSION], start, proof_verify, SM3_STATS_PROOF_INCLUSION);
+    return ok;
+}
+
+// 历史树根 MTH(D[0:size])
+// 将 [0, size) 按 size 的二进制位分解为若干完整子树（均已存放在节点区中），
+// 再从右向左折叠，只需 popcount(size) - 1 次哈希
+int rfc6962_view_root_at(const rfc6962_view_t *view, uint64_t size, uint8_t *root)
+{
+    uint8_t acc[SM3_DIGEST_SIZE];
+    uint64_t end = size;
+    int have = 0;
+
+    if (size == 0 || size > view->size)
+        return -1;
+    if (size == view->size)
+    {
+        memcpy(root, view->root_hash, SM3_DIGEST_SIZE);
+        return 0;
+    }
+
+    for (int level = 0; end > 0; level++)
+    {
+        if (!((size >> level) & 1))
+            continue;
+
+        // 完整子树 D[end - 2^level : end]
+        end -= (uint64_t)1 << level;
+        const uint8_t *node = rfc6962_view_node(view, level, end >> level);
+        if (have)
+        {
+            SM3_STAT_ADD(node_misses, 1);
+            hash_children(node, acc, acc);
+        }
+        else
+        {
+            memcpy(acc, node, SM3_DIGEST_SIZE);
+            have = 1;
+        }
+    }
+
+    memcpy(root, acc, SM3_DIGEST_SIZE);
+    return 0;
+}
+
+int rfc6962_root_at(const rfc6962_merkle_tree_t *tree, uint64_t size, uint8_t *root)
+{
+    rfc6962_view_t view;
+
+    rfc6962_view_current(tree, &view);
+    return rfc6962_view_root_at(&view, size, root);
+}
+
+// SUBPROOF(m, D[start : start + n], b)，RFC6962 2.1.2 节
+static void rfc6962_subproof(const rfc6962_view_t *view, uint64_t m, uint64_t start, uint64_t n,
+                             int complete, rfc6962_consistency_proof_t *proof)
+{
+    if (m == n)
+    {
+        if (!complete)
+        {
+            memcpy(proof->path[proof->path_length++], rfc6962_subtree_hash(view, start, n), SM3_DIGEST_SIZE);
+        }
+        return;
+    }
+
+    uint64_t k = rfc6962_split_point(n);
+    if (m <= k)
+    {
+        rfc6962_subproof(view, m, start, k, complete, proof);
+        memcpy(proof->path[proof->path_length++], rfc6962_subtree_hash(view, start + k, n - k), SM3_DIGEST_SIZE);
+    }
+    else
+    {
+        rfc6962_subproof(view, m - k, start + k, n - k, 0, proof);
+        memcpy(proof->path[proof->path_length++], rfc6962_subtree_hash(view, start, k), SM3_DIGEST_SIZE);
+    }
+}
+
+// 在视图上生成一致性证明 PROOF(old_size, D[view->size])
+rfc6962_consistency_proof_t *rfc6962_view_consistency_proof(const rfc6962_view_t *view, uint64_t old_size)
+{
+    if (old_size == 0 || old_size > view->size)
+        return NULL;
+
+    SM3_STAT_TIMER(start);
+    rfc6962_consistency_proof_t *proof = malloc(sizeof(rfc6962_consistency_proof_t));
+    if (!proof)
+        return NULL;
+
+    // 证明长度不超过 ceil(log2 n) + 1
+    proof->path = malloc((size_t)(view->level_count + 1) * sizeof(merkle_node_t));
+    if (!proof->path)
+    {
+        free(proof);
+        return NULL;
+    }
+
+    proof->old_size = old_size;
+    proof->new_size = view->size;
+    proof->path_length = 0;
+    rfc6962_view_root_at(view, old_size, proof->old_root);
+    memcpy(proof->new_root, view->root_hash, SM3_DIGEST_SIZE);
+
+    rfc6962_subproof(view, old_size, 0, view->size, 1, proof);
+
+    SM3_STAT_LATENCY(proof_generate_ns[SM3_STATS_PROOF_CONSISTENCY], start, proof_generate,
+                     SM3_STATS_PROOF_CONSISTENCY);
+    return proof;
+}
+
+// 生成一致性证明 PROOF(old_size, D[leaf_count])
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof(rfc6962_merkle_tree_t *tree, uint64_t old_size)
+{
+    rfc6962_view_t view;
+
+    rfc6962_view_current(tree, &view);
+    return rfc6962_view_consistency_proof(&view, old_size);
+}
+
+// 生成任意两个历史大小之间的一致性证明 PROOF(old_size, D[new_size])，0 < old_size <= new_size <= leaf_count
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_between(rfc6962_merkle_tree_t *tree, uint64_t old_size,
+                                                                        uint64_t new_size)
+{
+    rfc6962_view_storage_t storage;
+    rfc6962_view_t base, view;
+
+    rfc6962_view_current(tree, &base);
+    if (rfc6962_view_at(&base, new_size, &storage, &view) != 0)
+        return NULL;
+    return rfc6962_view_consistency_proof(&view, old_size);
+}
+
+// 验证一致性证明，RFC 9162 2.1.4.2 节
+static int rfc6962_verify_consistency(const rfc6962_consistency_proof_t *proof)
+{
+    uint8_t fr[SM3_DIGEST_SIZE], sr[SM3_DIGEST_SIZE];
+    uint64_t fn, sn;
+    int i = 0;
+
+    if (proof->old_size == 0 || proof->old_size > proof->new_size)
+        return 0;
+    if (proof->old_size == proof->new_size)
+        return proof->path_length == 0 && memcmp(proof->old_root, proof->new_root, SM3_DIGEST_SIZE) == 0;
+    if (proof->path_length == 0)
+        return 0;
+
+    fn = proof->old_size - 1;
+    sn = proof->new_size - 1;
+
+    // 旧树大小为2的幂时，旧树根本身是新树中的一个节点，不在证明中重复给出
+    if ((proof->old_size & (proof->old_size - 1)) == 0)
+    {
+        memcpy(fr, proof->old_root, SM3_DIGEST_SIZE);
+    }
+    else
+    {
+        memcpy(fr, proof->path[i++], SM3_DIGEST_SIZE);
+    }
+    memcpy(sr, fr, SM3_DIGEST_SIZE);
+
+    while (fn & 1)
+    {
+        fn >>= 1;
+        sn >>= 1;
+    }
+
+    for (; i < proof->path_length; i++)
+    {
+        const uint8_t *c = proof->path[i];
+
+        if (sn == 0)
+            return 0;
+
+        if ((fn & 1) || fn == sn)
+        {
+            hash_children(c, fr, fr);
+            hash_children(c, sr, sr);
+            if (!(fn & 1))
+            {
+                while (fn != 0 && !(fn & 1))
+                {
+                    fn >>= 1;
+                    sn >>= 1;
+                }
+            }
+        }
+        else
+        {
+            hash_children(sr, c, sr);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+
+    return sn == 0 && memcmp(fr, proof->old_root, SM3_DIGEST_SIZE) == 0 &&
+           memcmp(sr, proof->new_root, SM3_DIGEST_SIZE) == 0;
+}
+
+int verify_rfc6962_consistency_proof(const rfc6962_consistency_proof_t *proof)
+{
+    SM3_STAT_TIMER(start);
+    int ok = rfc6962_verify_consistency(proof);
+
+    SM3_STAT_LATENCY(proof_verify_ns[SM3_STATS_PROOF_CONSISTENCY], start, proof_verify, SM3_STATS_PROOF_CONSISTENCY);
+    return ok;
+}
+
+// 清理函数
+void free_rfc6962_merkle_tree(rfc6962_merkle_tree_t *tree)
+{
+    if (!tree)
+        return;
+
+    if (tree->store)
+        rfc6962_store_close(tree);
+    else
+        free(tree->nodes);
+    free(tree);
+}
+
+void free_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof)
+{
+    if (!proof)
+        return;
+
+    free(proof); // 路径与方向数组和证明头在同一块内存中
+}
+
+void free_rfc6962_consistency_proof(rfc6962_consistency_proof_t *proof)
+{
+    if (!proof)
+        return;
+
+    free(proof->path);
+    free(proof);
+}
@@ -0,0 +1,385 @@
+/*
+ * RFC6962 Merkle Tree Interface
+ * 基于 SM3 的 RFC6962 Merkle 树
+ *
+ * 树形严格按 RFC6962 的 MTH 定义（在小于 n 的最大2的幂处分割），n 个叶子恰好需要 n-1 次
+ * 内部哈希；整棵树存放在一块连续、缓存行对齐的节点区中，自叶子层向上逐层排列，
+ * 构建完成后叶子层与各内部层常驻内存
+ */
+
+#ifndef MERKLE_RFC6962_H
+#define MERKLE_RFC6962_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sm3.h"
+
+#define MERKLE_NODE_ALIGN 64  // 节点区按缓存行对齐
+#define MERKLE_MAX_LEVELS 65  // 2^64 个叶子时的层数上限
+
+// 单个节点哈希
+typedef uint8_t merkle_node_t[SM3_DIGEST_SIZE];
+
+// RFC6962 Merkle树结构
+typedef struct
+{
+    merkle_node_t *nodes;  // 连续节点区：第 k 层位于 nodes + level_offset[k]
+    merkle_node_t *leaves; // 叶子节点哈希数组（即第 0 层）
+    uint64_t leaf_count;   // 实际叶子节点数量
+    uint64_t capacity;     // 节点区按此叶子数为各层预留空间，追加不超过该容量
+    uint64_t node_count;   // 节点区总节点数
+    int level_count;       // 当前层数（含叶子层与根），空树为0
+    uint64_t level_offset[MERKLE_MAX_LEVELS];
+    uint64_t level_size[MERKLE_MAX_LEVELS]; // 第 k 层节点数 = ceil(leaf_count / 2^k)
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    struct rfc6962_store *store; // 文件映射存储（见 merkle_store.c），内存树为 NULL
+} rfc6962_merkle_tree_t;
+
+typedef struct
+{
+    merkle_node_t *path; // 审计路径（连续存放）
+    int *directions; // 方向数组 (0=兄弟在左, 1=兄弟在右)
+    int path_length;
+    uint64_t leaf_index;
+} rfc6962_audit_path_t;
+
+typedef struct
+{
+    uint64_t leaf_index;
+    uint8_t leaf_hash[SM3_DIGEST_SIZE];
+    rfc6962_audit_path_t audit_path;
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    uint64_t tree_size;
+} rfc6962_inclusion_proof_t;
+
+// 一致性证明 PROOF(old_size, D[new_size])
+typedef struct
+{
+    uint64_t old_size;
+    uint64_t new_size;
+    uint8_t old_root[SM3_DIGEST_SIZE];
+    uint8_t new_root[SM3_DIGEST_SIZE];
+    merkle_node_t *path; // 证明节点（连续存放）
+    int path_length;
+} rfc6962_consistency_proof_t;
+
+// 批量包含性证明：多个叶子共享的兄弟节点只出现一次
+typedef struct
+{
+    uint64_t tree_size;
+    uint64_t leaf_count;        // 被证明的叶子数
+    uint64_t *leaf_indices;     // 升序、无重复
+    merkle_node_t *leaf_hashes; // 与 leaf_indices 一一对应
+    merkle_node_t *nodes;       // 去重后的证明节点（连续存放，按验证时的消费顺序）
+    uint64_t node_count;
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+} rfc6962_multiproof_t;
+
+// 紧凑包含性证明：头部、方向位与路径节点为一整块连续内存，可直接放在调用方内存或 arena 中，
+// 释放时不需要逐个指针处理（arena 整体 reset，或 arena 为 NULL 时单次 free）
+typedef struct
+{
+    uint64_t leaf_index;
+    uint64_t tree_size;
+    uint8_t leaf_hash[SM3_DIGEST_SIZE];
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    uint32_t depth;       // 路径节点数
+    uint32_t reserved;
+    uint64_t directions;  // 第 i 位为1表示 path[i] 是右兄弟（验证只依赖 leaf_index 与 tree_size）
+    merkle_node_t path[]; // depth 个节点，自叶子向根
+} rfc6962_compact_proof_t;
+
+#define RFC6962_COMPACT_PROOF_SIZE(depth) (sizeof(rfc6962_compact_proof_t) + (size_t)(depth) * sizeof(merkle_node_t))
+#define RFC6962_COMPACT_PROOF_MAX_SIZE RFC6962_COMPACT_PROOF_SIZE(MERKLE_MAX_LEVELS - 1)
+
+// 线性分配器（merkle_arena.c）
+// 先使用调用方提供的缓冲区，用尽后按 grow 字节一块从堆上追加（grow 为 0 时不增长，分配失败返回 NULL）；
+// reset 一次性回收全部分配，堆上的块保留下来供下一轮复用，稳定状态下不再调用 malloc
+typedef struct rfc6962_arena_chunk rfc6962_arena_chunk_t;
+
+typedef struct
+{
+    uint8_t *base; // 当前块
+    size_t size;
+    size_t used;
+    uint8_t *initial; // 调用方提供的缓冲区，可为 NULL
+    size_t initial_size;
+    rfc6962_arena_chunk_t *chunks;  // 堆上的块，按使用顺序链接
+    rfc6962_arena_chunk_t *current; // 正在使用的堆块，NULL 表示仍在调用方缓冲区中
+    size_t grow;
+} rfc6962_arena_t;
+
+#define RFC6962_ARENA_ALIGN 16
+#define RFC6962_ARENA_DEFAULT_GROW (64 * 1024)
+
+void rfc6962_arena_init(rfc6962_arena_t *arena, void *buffer, size_t size, size_t grow);
+void *rfc6962_arena_alloc(rfc6962_arena_t *arena, size_t size); // 按 RFC6962_ARENA_ALIGN 对齐
+void rfc6962_arena_reset(rfc6962_arena_t *arena);
+void rfc6962_arena_destroy(rfc6962_arena_t *arena); // 释放堆上的块，调用方缓冲区由调用方管理
+// 每线程一个按需增长的 arena（块大小 RFC6962_ARENA_DEFAULT_GROW），由本线程 reset；
+// 线程退出前调用 rfc6962_thread_arena_release 归还内存
+rfc6962_arena_t *rfc6962_thread_arena(void);
+void rfc6962_thread_arena_release(void);
+
+// RFC6962标准的哈希函数
+void hash_leaf(const uint8_t *data, size_t data_len, uint8_t *output);                // H(0x00 || data)
+void hash_children(const uint8_t *left, const uint8_t *right, uint8_t *output);       // H(0x01 || left || right)
+
+// 批量哈希，经多路引擎并行（8/16 路），域分隔前缀直接拼入各路首块
+void hash_leaves_batch(const uint8_t *const *data, const size_t *lens, merkle_node_t *out, uint64_t count); // out[i] = H(0x00 || data[i])
+void hash_level(merkle_node_t *parents, const merkle_node_t *children, uint64_t n); // parents[i] = H(0x01 || children[2i] || children[2i+1])
+
+// 构建与释放
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree(uint8_t **data_array, uint64_t *data_lengths, uint64_t count);
+// 多线程构建：threads <= 0 时使用全部在线CPU，根哈希与单线程构建逐位一致
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_mt(uint8_t **data_array, uint64_t *data_lengths, uint64_t count,
+                                                    int threads);
+
+// 零拷贝构建：第 i 条记录为 base[offsets[i], offsets[i + 1])，offsets 共 count + 1 项
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_buffer(const uint8_t *base, const uint64_t *offsets, uint64_t count,
+                                                        int threads);
+
+// 叶子来源回调：返回第 index 条记录的位置与长度，数据在构建期间须保持有效，
+// 多线程构建时会被多个线程并发调用
+typedef void (*rfc6962_leaf_source_fn)(void *ctx, uint64_t index, const uint8_t **data, size_t *data_len);
+
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_source(rfc6962_leaf_source_fn source, void *source_ctx,
+                                                        uint64_t count, int threads);
+
+// 设备构建（merkle_gpu.c）：make GPU=1 时叶子哈希与块内各层在 OpenCL 设备上计算，传输与计算流水重叠
+#define RFC6962_BACKEND_AUTO 0 // 有设备且叶子足够多时用 GPU，否则回退到全部 CPU 线程
+#define RFC6962_BACKEND_CPU 1
+#define RFC6962_BACKEND_GPU 2 // 只用设备，不可用时失败
+
+int rfc6962_gpu_available(void);
+const char *rfc6962_gpu_device_name(void); // 无可用设备时为 NULL
+// 记录格式同 build_rfc6962_merkle_tree_buffer，各层常驻内存，结果与 CPU 构建逐位一致
+rfc6962_merkle_tree_t *build_rfc6962_merkle_tree_device(const uint8_t *base, const uint64_t *offsets, uint64_t count,
+                                                        int backend);
+// 只计算根：设备只读回每块的子树根，主机内存只需 O(count / 2^20) 个节点，失败返回-1
+int rfc6962_root_device(const uint8_t *base, const uint64_t *offsets, uint64_t count, int backend, uint8_t *root);
+void free_rfc6962_merkle_tree(rfc6962_merkle_tree_t *tree); // 文件存储的树同时解除映射并关闭文件
+
+// 预留 capacity 个叶子空间的空树，随后通过追加接口增长
+rfc6962_merkle_tree_t *rfc6962_tree_create(uint64_t capacity);
+
+// 追加叶子：更新右边缘每层一个节点（O(log n)），超出容量返回-1
+int rfc6962_tree_append(rfc6962_merkle_tree_t *tree, const uint8_t *data, size_t data_len);
+int rfc6962_tree_append_hash(rfc6962_merkle_tree_t *tree, const uint8_t *leaf_hash);
+int rfc6962_tree_append_batch(rfc6962_merkle_tree_t *tree, uint8_t **data_array, uint64_t *data_lengths,
+                              uint64_t count);
+
+// 内存映射的持久化存储（merkle_store.c）
+// 文件由一个头部页和按容量预留的各层哈希数组组成，打开时只重算右边缘的 O(log n) 个节点并与已提交的根比对，
+// 证明只会换入它访问到的 O(log n) 个节点所在的页；追加直接写入映射
+#define RFC6962_SYNC_NONE 0   // 由内核回写，调用 rfc6962_store_sync 时才保证落盘
+#define RFC6962_SYNC_APPEND 1 // 每次追加返回前同步所写节点，再同步头部中的叶子数与根
+
+rfc6962_merkle_tree_t *rfc6962_store_create(const char *path, uint64_t capacity, int sync_policy);
+rfc6962_merkle_tree_t *rfc6962_store_open(const char *path, int writable, int sync_policy);
+int rfc6962_store_sync(rfc6962_merkle_tree_t *tree);
+
+// 包含性证明
+rfc6962_audit_path_t *generate_rfc6962_audit_path(rfc6962_merkle_tree_t *tree, uint64_t leaf_index);
+rfc6962_inclusion_proof_t *generate_rfc6962_inclusion_proof(rfc6962_merkle_tree_t *tree, uint64_t leaf_index);
+int verify_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof);
+void free_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof);
+
+// 紧凑包含性证明：arena 为 NULL 时用 malloc 分配，以 free 释放
+rfc6962_compact_proof_t *generate_rfc6962_compact_proof(rfc6962_merkle_tree_t *tree, uint64_t leaf_index,
+                                                        rfc6962_arena_t *arena);
+int verify_rfc6962_compact_proof(const rfc6962_compact_proof_t *proof);
+
+// 批量包含性证明（merkle_multiproof.c）：索引可无序、可重复
+rfc6962_multiproof_t *generate_rfc6962_multiproof(rfc6962_merkle_tree_t *tree, const uint64_t *indices,
+                                                  uint64_t count);
+int verify_rfc6962_multiproof(const rfc6962_multiproof_t *proof);
+void free_rfc6962_multiproof(rfc6962_multiproof_t *proof);
+
+// 一致性证明：证明大小为 old_size 的历史树是当前树的前缀（0 < old_size <= leaf_count）
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof(rfc6962_merkle_tree_t *tree, uint64_t old_size);
+// 任意两个历史大小之间的一致性证明（0 < old_size <= new_size <= leaf_count）：证明节点都是常驻的
+// 完整子树根，直接查表；new_size 小于当前大小时另需把右边缘折叠为该大小，至多 O(log n) 次哈希
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_between(rfc6962_merkle_tree_t *tree, uint64_t old_size,
+                                                                        uint64_t new_size);
+int verify_rfc6962_consistency_proof(const rfc6962_consistency_proof_t *proof);
+void free_rfc6962_consistency_proof(rfc6962_consistency_proof_t *proof);
+
+// SM3 树哈希模式（merkle_treehash.c）：输入按 chunk_size 字节切块，块摘要 hash_leaf(chunk) 为叶子，
+// 摘要为其 RFC6962 MTH，各块在全部线程上并行哈希（threads <= 0 时使用全部在线CPU）
+// 摘要不同于普通 SM3 摘要且随块大小变化；chunks 非 NULL 时交出块摘要树（空输入为 NULL），调用方释放
+#define RFC6962_TREEHASH_CHUNK ((size_t)1 << 20)
+
+int rfc6962_treehash(const uint8_t *data, uint64_t len, size_t chunk_size, int threads, uint8_t *digest,
+                     rfc6962_merkle_tree_t **chunks);
+// flags 同 sm3_hash_fd：普通文件整体映射后并行哈希，管道等流式输入逐批读入；成功后文件位置在末尾
+int rfc6962_treehash_fd(int fd, int flags, size_t chunk_size, int threads, uint8_t *digest,
+                        rfc6962_merkle_tree_t **chunks);
+int rfc6962_treehash_file(const char *path, int flags, size_t chunk_size, int threads, uint8_t *digest,
+                          rfc6962_merkle_tree_t **chunks); // path 为 "-" 时读取标准输入
+// 校验输入 data（共 len 字节）的区间 [offset, offset + range_len)：只重新哈希覆盖的块，
+// 经块摘要树中的审计路径对到可信摘要 digest，块摘要树可以来自不可信的存储；一致返回1
+int rfc6962_treehash_verify_range(rfc6962_merkle_tree_t *chunks, const uint8_t *digest, const uint8_t *data,
+                                  uint64_t len, size_t chunk_size, uint64_t offset, uint64_t range_len);
+
+// 计算前 size 个叶子构成的历史树根 MTH(D[0:size])，只对右边缘的 O(log n) 个节点做哈希
+int rfc6962_root_at(const rfc6962_merkle_tree_t *tree, uint64_t size, uint8_t *root);
+
+// 追加式增量日志
+// 只保存右边缘 frontier：size 的第 k 位为1时，frontier[k] 为一棵 2^k 个叶子的完整子树根，
+// 这些子树从左到右（k 从大到小）恰好拼成当前整棵树；全部状态约 2KB
+typedef struct
+{
+    uint64_t size; // 已追加的叶子数
+    merkle_node_t frontier[MERKLE_MAX_LEVELS - 1];
+} rfc6962_log_t;
+
+void rfc6962_log_init(rfc6962_log_t *log);
+void rfc6962_log_append(rfc6962_log_t *log, const uint8_t *data, size_t data_len);       // 均摊 O(1) 次哈希
+void rfc6962_log_append_hash(rfc6962_log_t *log, const uint8_t *leaf_hash);           // 追加已计算好的叶子哈希
+void rfc6962_log_append_batch(rfc6962_log_t *log, uint8_t **data_array, uint64_t *data_lengths, uint64_t count);
+void rfc6962_log_root(const rfc6962_log_t *log, uint8_t *root);                       // O(log n)，空日志为 SM3("")
+
+// 证明与签名树头的二进制编码（merkle_wire.c），字段布局见该文件开头
+#define RFC6962_WIRE_VERSION 1
+#define RFC6962_WIRE_INCLUSION 1
+#define RFC6962_WIRE_TREE_HEAD 2
+#define RFC6962_WIRE_HEADER_SIZE 8
+#define RFC6962_WIRE_INCLUSION_SIZE(depth) (96 + (size_t)(depth) * SM3_DIGEST_SIZE)
+#define RFC6962_WIRE_TREE_HEAD_SIZE(signature_len) (56 + (size_t)(signature_len))
+#define RFC6962_TLS_TREE_HEAD_SIZE 50 // RFC6962 3.5 节 TreeHeadSignature 签名输入
+
+// 解码结果直接指向接收缓冲区，缓冲区须在使用期间保持有效
+typedef struct
+{
+    uint64_t leaf_index;
+    uint64_t tree_size;
+    uint64_t directions;
+    uint32_t depth;
+    const uint8_t *leaf_hash;
+    const uint8_t *root_hash;
+    const uint8_t *path; // depth 个连续的 32 字节节点
+} rfc6962_wire_inclusion_t;
+
+// 签名树头：签名由调用方对 rfc6962_tls_encode_tree_head 的输出计算，本库只负责携带
+typedef struct
+{
+    uint64_t tree_size;
+    uint64_t timestamp; // 毫秒
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    const uint8_t *signature;
+    uint16_t signature_len;
+} rfc6962_tree_head_t;
+
+// 编码函数返回写入的字节数，缓冲区不足或参数非法返回0；解码成功返回0，格式错误返回-1
+size_t rfc6962_wire_encode_inclusion(const rfc6962_compact_proof_t *proof, uint8_t *buf, size_t cap);
+int rfc6962_wire_decode_inclusion(const uint8_t *buf, size_t len, rfc6962_wire_inclusion_t *out);
+// 直接在收到的缓冲区上验证；trusted_root 非 NULL 时还要求证明中的根与之相同
+int rfc6962_wire_verify_inclusion(const uint8_t *buf, size_t len, const uint8_t *trusted_root);
+size_t rfc6962_wire_encode_tree_head(const rfc6962_tree_head_t *sth, uint8_t *buf, size_t cap);
+int rfc6962_wire_decode_tree_head(const uint8_t *buf, size_t len, rfc6962_tree_head_t *sth);
+
+// TLS 编码（RFC 9162 InclusionProofDataV2 / RFC6962 TreeHeadSignature）
+size_t rfc6962_tls_encode_inclusion(const rfc6962_compact_proof_t *proof, const uint8_t *log_id, size_t log_id_len,
+                                    uint8_t *buf, size_t cap);
+int rfc6962_tls_verify_inclusion(const uint8_t *buf, size_t len, const uint8_t *leaf_hash, const uint8_t *root_hash);
+size_t rfc6962_tls_encode_tree_head(const rfc6962_tree_head_t *sth, uint8_t *buf, size_t cap);
+
+// 无锁并发读（merkle_concurrent.c）
+// 写者每次追加后发布不可变快照（大小、根以及右边缘 O(log n) 个节点的副本），
+// 读者获取快照后不加锁地生成证明，证明对应快照时刻的树，不受之后追加的影响
+#define RFC6962_MAX_READERS 64
+
+typedef struct rfc6962_snapshot
+{
+    uint64_t size;
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    int level_count;
+    uint64_t level_size[MERKLE_MAX_LEVELS];
+    merkle_node_t edge[MERKLE_MAX_LEVELS]; // 第 k 层最后一个节点不完整时的副本
+    struct rfc6962_snapshot *retired_next;
+    uint64_t retired_epoch;
+} rfc6962_snapshot_t;
+
+typedef struct rfc6962_concurrent_tree rfc6962_concurrent_tree_t;
+
+rfc6962_concurrent_tree_t *rfc6962_concurrent_create(rfc6962_merkle_tree_t *tree); // 接管 tree
+void rfc6962_concurrent_free(rfc6962_concurrent_tree_t *ct);                       // 调用前所有读者须已注销
+// 追加方之间互斥，追加完成后发布新快照；超出容量返回-1
+int rfc6962_concurrent_append(rfc6962_concurrent_tree_t *ct, const uint8_t *data, size_t data_len);
+int rfc6962_concurrent_append_batch(rfc6962_concurrent_tree_t *ct, uint8_t **data_array, uint64_t *data_lengths,
+                                    uint64_t count);
+
+// 每个读线程注册一次，返回读者编号，名额用尽返回-1
+int rfc6962_reader_register(rfc6962_concurrent_tree_t *ct);
+void rfc6962_reader_unregister(rfc6962_concurrent_tree_t *ct, int reader);
+// 获取当前快照，在 release 之前有效；同一读者同时只持有一个快照
+const rfc6962_snapshot_t *rfc6962_snapshot_acquire(rfc6962_concurrent_tree_t *ct, int reader);
+void rfc6962_snapshot_release(rfc6962_concurrent_tree_t *ct, int reader);
+
+// 基于快照生成证明，返回的证明不引用快照，release 之后仍然有效
+rfc6962_inclusion_proof_t *generate_rfc6962_inclusion_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                               const rfc6962_snapshot_t *snap, uint64_t leaf_index);
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                                   const rfc6962_snapshot_t *snap, uint64_t old_size);
+rfc6962_consistency_proof_t *generate_rfc6962_consistency_proof_between_at(const rfc6962_concurrent_tree_t *ct,
+                                                                           const rfc6962_snapshot_t *snap,
+                                                                           uint64_t old_size, uint64_t new_size);
+rfc6962_compact_proof_t *generate_rfc6962_compact_proof_at(const rfc6962_concurrent_tree_t *ct,
+                                                           const rfc6962_snapshot_t *snap, uint64_t leaf_index,
+                                                           rfc6962_arena_t *arena);
+rfc6962_multiproof_t *generate_rfc6962_multiproof_at(const rfc6962_concurrent_tree_t *ct,
+                                                     const rfc6962_snapshot_t *snap, const uint64_t *indices,
+                                                     uint64_t count);
+
+// 证明服务引擎（merkle_server.c）：嵌入 RPC 前端的异步证明生成核心
+// 请求经无锁 MPMC 队列交给工作线程，每个线程一次取出一批，整批共用一个快照，
+// 同一树大小的请求共用一次历史视图推导；证明直接写入请求自带的缓冲区，服务路径上不分配内存
+#define RFC6962_SERVER_PIN 1        // 工作线程轮流分配到各 NUMA 节点并绑定该节点的CPU
+#define RFC6962_SERVER_MULTIPROOF 2 // 同一批中同一树大小的回调请求另外合并成一个批量证明
+#define RFC6962_SERVER_BATCH 64     // 每个工作线程一次最多取出的请求数，限制批内排队时间
+#define RFC6962_SERVER_DEFAULT_DEPTH 4096
+
+typedef struct rfc6962_serve_request rfc6962_serve_request_t;
+typedef void (*rfc6962_serve_complete_fn)(rfc6962_serve_request_t *req);
+
+struct rfc6962_serve_request
+{
+    // 输入，请求在完成前由调用方保持有效
+    uint64_t leaf_index;
+    uint64_t tree_size;                 // 0 表示取出请求时的最新快照
+    rfc6962_compact_proof_t *proof;     // 调用方的证明缓冲区（8 字节对齐）
+    size_t proof_capacity;              // RFC6962_COMPACT_PROOF_MAX_SIZE 总是足够
+    rfc6962_serve_complete_fn complete; // 在工作线程上回调；NULL 时进入完成队列并通知 eventfd
+    void *user;
+    // 输出
+    int status;                             // 0 成功；索引或树大小无效、缓冲区不足为-1
+    const rfc6962_multiproof_t *multiproof; // RFC6962_SERVER_MULTIPROOF 时同组共享，只在 complete 回调内有效
+};
+
+typedef struct
+{
+    int workers;          // <= 0 时为在线CPU数，至多 RFC6962_MAX_READERS
+    uint32_t queue_depth; // 在途请求上限，向上取整为2的幂；0 时为 RFC6962_SERVER_DEFAULT_DEPTH
+    int flags;
+} rfc6962_server_config_t;
+
+typedef struct rfc6962_server rfc6962_server_t;
+
+rfc6962_server_t *rfc6962_server_create(rfc6962_concurrent_tree_t *ct, const rfc6962_server_config_t *config);
+// 等待已提交的请求全部完成后退出工作线程；调用时不得再有提交，未取走的完成队列项被丢弃
+void rfc6962_server_destroy(rfc6962_server_t *server);
+// 任意线程可并发提交，不加锁；在途请求达到上限返回-1
+int rfc6962_server_submit(rfc6962_server_t *server, rfc6962_serve_request_t *req);
+// 完成队列：eventfd 可读表示有请求完成，poll 取出至多 max 个并清除 eventfd
+int rfc6962_server_eventfd(const rfc6962_server_t *server);
+size_t rfc6962_server_poll(rfc6962_server_t *server, rfc6962_serve_request_t **done, size_t max);
+
+// 第 level 层第 index 个节点，即 MTH(D[index * 2^level : min((index + 1) * 2^level, leaf_count)])
+static inline uint8_t *rfc6962_node(const rfc6962_merkle_tree_t *tree, int level, uint64_t index)
+{
+    return tree->nodes[tree->level_offset[level] + index];
+}
+
+#endif // MERKLE_RFC6962_H
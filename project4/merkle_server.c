@@ -0,0 +1,473 @@
+/*
+ * RFC6962 Merkle Tree Proof Server
+ * 异步、成批的证明服务核心
+ *
+ * 提交方把请求放入有界无锁 MPMC 环形队列（每个槽带序号，生产者与消费者各用一次 CAS 认领位置），
+ * 再对计数信号量做一次 post；空闲的工作线程阻塞在信号量上，不空转。工作线程被唤醒后一次取出
+ * 至多 RFC6962_SERVER_BATCH 个请求，整批只获取一次快照，按树大小排序分组，每组只推导一次
+ * 历史视图（O(log n) 次哈希），组内各请求的紧凑证明直接写入请求自带的缓冲区。
+ *
+ * 完成通知两种方式：请求带回调时在工作线程上直接回调；否则放入完成队列，整批完成后对
+ * eventfd 写一次，前端把 eventfd 加进自己的 epoll 循环即可。在途请求数不超过队列深度，
+ * 两个环形队列都不会溢出，提交失败即为背压信号
+ */
+
+#define _GNU_SOURCE // pthread_setaffinity_np, CPU_SET, eventfd
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "merkle_internal.h"
+
+#define RFC6962_CACHE_LINE 64
+#define RFC6962_MAX_NUMA_NODES 64
+
+// Vyukov 有界 MPMC 队列：槽 i 的序号等于 pos 时可写，等于 pos + 1 时可读
+typedef struct
+{
+    uint64_t seq;
+    rfc6962_serve_request_t *req;
+} rfc6962_ring_slot_t;
+
+typedef struct
+{
+    rfc6962_ring_slot_t *slots;
+    uint64_t mask;
+    uint8_t pad0[RFC6962_CACHE_LINE - sizeof(void *) - sizeof(uint64_t)];
+    uint64_t enqueue_pos; // 生产者与消费者的位置各占一个缓存行
+    uint8_t pad1[RFC6962_CACHE_LINE - sizeof(uint64_t)];
+    uint64_t dequeue_pos;
+    uint8_t pad2[RFC6962_CACHE_LINE - sizeof(uint64_t)];
+} rfc6962_ring_t;
+
+static int rfc6962_ring_init(rfc6962_ring_t *ring, uint64_t capacity)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (posix_memalign((void **)&ring->slots, RFC6962_CACHE_LINE, (size_t)capacity * sizeof(rfc6962_ring_slot_t)) != 0)
+        return -1;
+    for (uint64_t i = 0; i < capacity; i++)
+    {
+        ring->slots[i].seq = i;
+        ring->slots[i].req = NULL;
+    }
+    ring->mask = capacity - 1;
+    return 0;
+}
+
+static int rfc6962_ring_push(rfc6962_ring_t *ring, rfc6962_serve_request_t *req)
+{
+    uint64_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        rfc6962_ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        int64_t diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                slot->req = req;
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        }
+        else if (diff < 0)
+        {
+            return -1; // 满
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static rfc6962_serve_request_t *rfc6962_ring_pop(rfc6962_ring_t *ring)
+{
+    uint64_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        rfc6962_ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        int64_t diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                rfc6962_serve_request_t *req = slot->req;
+                __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+                return req;
+            }
+        }
+        else if (diff < 0)
+        {
+            return NULL; // 空，或队首的生产者尚未写完
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+typedef struct
+{
+    struct rfc6962_server *server;
+    pthread_t thread;
+    int reader;
+    int started;
+    // 一批请求及其实际树大小，按树大小排序
+    rfc6962_serve_request_t *batch[RFC6962_SERVER_BATCH];
+    uint64_t sizes[RFC6962_SERVER_BATCH];
+    uint64_t indices[RFC6962_SERVER_BATCH];
+    rfc6962_view_storage_t storage;
+} rfc6962_worker_t;
+
+struct rfc6962_server
+{
+    rfc6962_ring_t requests;
+    rfc6962_ring_t completions;
+    rfc6962_concurrent_tree_t *ct;
+    uint64_t depth;
+    uint64_t inflight; // 已提交且尚未回调或被 poll 取走的请求数，原子读写
+    int flags;
+    int stopping;
+    int event_fd;
+    sem_t pending; // 每个已入队的请求对应一个计数；停止时每个工作线程再加一个
+    int worker_count;
+    rfc6962_worker_t *workers;
+};
+
+// 取出一个已计数的请求：计数在入队完成之后才 post，队首的生产者未写完时稍等即可；
+// 停止时计数可能不对应请求，返回 NULL
+static rfc6962_serve_request_t *rfc6962_server_take(rfc6962_server_t *server)
+{
+    for (;;)
+    {
+        rfc6962_serve_request_t *req = rfc6962_ring_pop(&server->requests);
+        if (req)
+            return req;
+        if (__atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE))
+            return NULL;
+        sched_yield();
+    }
+}
+
+static void rfc6962_serve_group(rfc6962_worker_t *worker, const rfc6962_view_t *base, int first, int end)
+{
+    rfc6962_server_t *server = worker->server;
+    rfc6962_view_t view;
+    rfc6962_multiproof_t *multiproof = NULL;
+    int valid = rfc6962_view_at(base, worker->sizes[first], &worker->storage, &view) == 0;
+    uint64_t ok_count = 0;
+
+    for (int i = first; i < end; i++)
+    {
+        rfc6962_serve_request_t *req = worker->batch[i];
+        rfc6962_arena_t arena;
+
+        // 缓冲区当作不增长的 arena，证明恰好落在缓冲区开头
+        rfc6962_arena_init(&arena, req->proof, req->proof ? req->proof_capacity : 0, 0);
+        req->status = valid && rfc6962_view_compact_proof(&view, req->leaf_index, &arena) ? 0 : -1;
+        req->multiproof = NULL;
+        // 批量证明只交给回调，完成队列里的请求拿不到，不必计入
+        if (req->status == 0 && req->complete)
+            worker->indices[ok_count++] = req->leaf_index;
+    }
+
+    if ((server->flags & RFC6962_SERVER_MULTIPROOF) && ok_count > 1)
+        multiproof = rfc6962_view_multiproof(&view, worker->indices, ok_count);
+
+    for (int i = first; i < end; i++)
+    {
+        rfc6962_serve_request_t *req = worker->batch[i];
+
+        if (!req->complete)
+        {
+            // 在途数不超过深度，只会遇到 poll 已认领但尚未释放的槽位
+            while (rfc6962_ring_push(&server->completions, req) != 0)
+            {
+                sched_yield();
+            }
+            continue;
+        }
+        if (req->status == 0)
+            req->multiproof = multiproof;
+        req->complete(req); // 回调返回后 req 归还调用方，可能已被再次提交
+        __atomic_fetch_sub(&server->inflight, 1, __ATOMIC_RELEASE);
+    }
+    free_rfc6962_multiproof(multiproof);
+}
+
+static void rfc6962_serve_batch(rfc6962_worker_t *worker, int count)
+{
+    rfc6962_server_t *server = worker->server;
+    const rfc6962_snapshot_t *snap = rfc6962_snapshot_acquire(server->ct, worker->reader);
+    rfc6962_view_t base;
+    uint64_t queued = 0;
+
+    // 按实际树大小插入排序（批很小），同一大小的请求相邻
+    for (int i = 0; i < count; i++)
+    {
+        rfc6962_serve_request_t *req = worker->batch[i];
+        uint64_t size = req->tree_size ? req->tree_size : snap->size;
+        int j = i;
+
+        while (j > 0 && worker->sizes[j - 1] > size)
+        {
+            worker->batch[j] = worker->batch[j - 1];
+            worker->sizes[j] = worker->sizes[j - 1];
+            j--;
+        }
+        worker->batch[j] = req;
+        worker->sizes[j] = size;
+        queued += req->complete == NULL;
+    }
+
+    rfc6962_snapshot_view(server->ct, snap, &base);
+    for (int first = 0; first < count;)
+    {
+        int end = first + 1;
+        while (end < count && worker->sizes[end] == worker->sizes[first])
+        {
+            end++;
+        }
+        rfc6962_serve_group(worker, &base, first, end);
+        first = end;
+    }
+    rfc6962_snapshot_release(server->ct, worker->reader);
+
+    // 整批只通知一次
+    if (queued && write(server->event_fd, &queued, sizeof(queued)) != (ssize_t)sizeof(queued))
+        perror("rfc6962_server: eventfd");
+}
+
+static void *rfc6962_worker_main(void *arg)
+{
+    rfc6962_worker_t *worker = arg;
+    rfc6962_server_t *server = worker->server;
+
+    for (;;)
+    {
+        int count = 0;
+
+        while (sem_wait(&server->pending) != 0 && errno == EINTR)
+        {
+        }
+        if (!(worker->batch[count] = rfc6962_server_take(server)))
+            break;
+        count++;
+
+        // 已在队列中的请求顺带取走，不再等待
+        while (count < RFC6962_SERVER_BATCH && sem_trywait(&server->pending) == 0)
+        {
+            if (!(worker->batch[count] = rfc6962_server_take(server)))
+            {
+                sem_post(&server->pending); // 这是停止计数，留给其他线程
+                break;
+            }
+            count++;
+        }
+        rfc6962_serve_batch(worker, count);
+    }
+    return NULL;
+}
+
+// 解析 /sys/devices/system/node/nodeN/cpulist（如 "0-3,8-11"），节点不存在返回-1
+static int rfc6962_numa_cpus(int node, cpu_set_t *set)
+{
+    char path[64];
+    FILE *f;
+    int first, last;
+    char sep;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    f = fopen(path, "r");
+    if (!f)
+        return -1;
+
+    CPU_ZERO(set);
+    while (fscanf(f, "%d", &first) == 1)
+    {
+        last = first;
+        sep = (char)fgetc(f);
+        if (sep == '-')
+        {
+            if (fscanf(f, "%d", &last) != 1)
+                break;
+            sep = (char)fgetc(f);
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+        {
+            CPU_SET(cpu, set);
+        }
+        if (sep != ',')
+            break;
+    }
+    fclose(f);
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// 第 i 个工作线程绑定到第 i % 节点数 个 NUMA 节点；没有 NUMA 信息时不绑定
+static void rfc6962_server_pin(rfc6962_server_t *server)
+{
+    cpu_set_t nodes[RFC6962_MAX_NUMA_NODES];
+    int node_count = 0;
+
+    while (node_count < RFC6962_MAX_NUMA_NODES && rfc6962_numa_cpus(node_count, &nodes[node_count]) == 0)
+    {
+        node_count++;
+    }
+    for (int i = 0; node_count > 0 && i < server->worker_count; i++)
+    {
+        pthread_setaffinity_np(server->workers[i].thread, sizeof(cpu_set_t), &nodes[i % node_count]);
+    }
+}
+
+rfc6962_server_t *rfc6962_server_create(rfc6962_concurrent_tree_t *ct, const rfc6962_server_config_t *config)
+{
+    rfc6962_server_config_t defaults = {0, 0, 0};
+    rfc6962_server_t *server;
+    uint64_t depth = 1;
+
+    if (!ct)
+        return NULL;
+    if (!config)
+        config = &defaults;
+
+    server = calloc(1, sizeof(rfc6962_server_t));
+    if (!server)
+        return NULL;
+
+    while (depth < (config->queue_depth ? config->queue_depth : RFC6962_SERVER_DEFAULT_DEPTH))
+    {
+        depth <<= 1;
+    }
+    server->ct = ct;
+    server->depth = depth;
+    server->flags = config->flags;
+    server->event_fd = -1;
+    server->worker_count = config->workers;
+    if (server->worker_count <= 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        server->worker_count = online > 0 ? (int)online : 1;
+    }
+    if (server->worker_count > RFC6962_MAX_READERS)
+        server->worker_count = RFC6962_MAX_READERS;
+
+    if (rfc6962_ring_init(&server->requests, depth) != 0 || rfc6962_ring_init(&server->completions, depth) != 0 ||
+        (server->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0 || sem_init(&server->pending, 0, 0) != 0)
+    {
+        free(server->requests.slots);
+        free(server->completions.slots);
+        if (server->event_fd >= 0)
+            close(server->event_fd);
+        free(server);
+        return NULL;
+    }
+
+    server->workers = calloc((size_t)server->worker_count, sizeof(rfc6962_worker_t));
+    for (int i = 0; server->workers && i < server->worker_count; i++)
+    {
+        server->workers[i].reader = -1;
+    }
+    for (int i = 0; server->workers && i < server->worker_count; i++)
+    {
+        rfc6962_worker_t *worker = &server->workers[i];
+
+        worker->server = server;
+        worker->reader = rfc6962_reader_register(ct);
+        if (worker->reader < 0 || pthread_create(&worker->thread, NULL, rfc6962_worker_main, worker) != 0)
+            break;
+        worker->started = 1;
+    }
+    if (!server->workers || !server->workers[server->worker_count - 1].started)
+    {
+        rfc6962_server_destroy(server);
+        return NULL;
+    }
+
+    if (server->flags & RFC6962_SERVER_PIN)
+        rfc6962_server_pin(server);
+    return server;
+}
+
+void rfc6962_server_destroy(rfc6962_server_t *server)
+{
+    if (!server)
+        return;
+
+    // 已入队的请求先于停止计数被取走：take 只有在队列已空时才因停止返回 NULL
+    __atomic_store_n(&server->stopping, 1, __ATOMIC_RELEASE);
+    for (int i = 0; server->workers && i < server->worker_count; i++)
+    {
+        sem_post(&server->pending);
+    }
+    for (int i = 0; server->workers && i < server->worker_count; i++)
+    {
+        rfc6962_worker_t *worker = &server->workers[i];
+
+        if (worker->started)
+            pthread_join(worker->thread, NULL);
+        if (worker->reader >= 0)
+            rfc6962_reader_unregister(server->ct, worker->reader);
+    }
+    free(server->workers);
+    sem_destroy(&server->pending);
+    close(server->event_fd);
+    free(server->requests.slots);
+    free(server->completions.slots);
+    free(server);
+}
+
+int rfc6962_server_submit(rfc6962_server_t *server, rfc6962_serve_request_t *req)
+{
+    // 先占在途名额：名额数等于队列容量，入队与完成入队都不会失败
+    if (__atomic_add_fetch(&server->inflight, 1, __ATOMIC_ACQUIRE) > server->depth)
+    {
+        __atomic_fetch_sub(&server->inflight, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    while (rfc6962_ring_push(&server->requests, req) != 0)
+    {
+        sched_yield(); // 消费者已认领但尚未释放槽位
+    }
+    sem_post(&server->pending);
+    return 0;
+}
+
+int rfc6962_server_eventfd(const rfc6962_server_t *server)
+{
+    return server->event_fd;
+}
+
+size_t rfc6962_server_poll(rfc6962_server_t *server, rfc6962_serve_request_t **done, size_t max)
+{
+    uint64_t events;
+    size_t n = 0;
+
+    // 先清 eventfd 再取：之后完成的请求会再次写 eventfd，不会丢失通知
+    if (read(server->event_fd, &events, sizeof(events)) < 0 && errno != EAGAIN)
+        return 0;
+    while (n < max && (done[n] = rfc6962_ring_pop(&server->completions)) != NULL)
+    {
+        n++;
+    }
+    __atomic_fetch_sub(&server->inflight, n, __ATOMIC_RELEASE);
+
+    // 没取完时重新置位，调用方的事件循环会再次回来
+    events = 1;
+    if (n == max && write(server->event_fd, &events, sizeof(events)) != (ssize_t)sizeof(events))
+        perror("rfc6962_server: eventfd");
+    return n;
+}
@@ -0,0 +1,257 @@
+/*
+ * RFC6962 Merkle Tree On-disk Storage
+ * 内存映射的持久化 Merkle 树
+ *
+ * 文件格式（头部整数字段为主机字节序，提交时经映射原地更新；节点是哈希字节串，与字节序无关）：
+ *   [0, 4096)        头部页：魔数、版本、瓦片高度、容量、已提交叶子数、根哈希、字节序标记、各层偏移
+ *   [4096, ...)      节点区：第 k 层预留 ceil(capacity / 2^k) 个 32 字节哈希，
+ *                    每层起点按瓦片（2^8 个节点 = 8KB，整数个页）对齐
+ * 同一层中相邻 256 个节点构成一个瓦片，证明在每层访问的节点落在同一瓦片内时只换入 2 页；
+ * 文件按容量一次性 ftruncate 为稀疏文件，追加时只有实际写入的页占用磁盘
+ *
+ * 头部中的叶子数与根是提交点：RFC6962_SYNC_APPEND 下先同步新写入的节点再同步头部。
+ * 完整子树的节点写入后不再改变，而右边缘不完整的节点（每层至多一个）会被后续追加覆盖，
+ * 因此打开时按头部中的叶子数重算右边缘（O(log n) 次哈希）并与头部中的根比对；
+ * 崩溃后重新打开得到的总是最后一次提交的树。
+ * 文件不能在字节序不同的主机之间直接移动：打开时字节序标记对不上即拒绝
+ */
+
+#define _POSIX_C_SOURCE 200809L // mmap, msync, ftruncate, pread, pwrite
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "merkle_internal.h"
+
+#define RFC6962_STORE_MAGIC "SM3MTREE"
+#define RFC6962_STORE_VERSION 2              // 版本 2 起头部带字节序标记
+#define RFC6962_STORE_BYTE_ORDER 0x01020304u // 按主机字节序写入，异序主机读出为 0x04030201
+#define RFC6962_STORE_HEADER_SIZE 4096
+#define RFC6962_STORE_TILE_HEIGHT 8
+
+// 文件头部
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t tile_height;
+    uint64_t capacity;
+    uint64_t size; // 已提交的叶子数
+    uint8_t root_hash[SM3_DIGEST_SIZE];
+    uint32_t level_count; // 容量对应的层数
+    uint32_t byte_order; // RFC6962_STORE_BYTE_ORDER
+    uint64_t level_offset[MERKLE_MAX_LEVELS]; // 以节点为单位，相对节点区起点
+} rfc6962_store_header_t;
+
+struct rfc6962_store
+{
+    int fd;
+    int writable;
+    int sync_policy;
+    uint8_t *map;
+    size_t map_size;
+    rfc6962_store_header_t *header;
+};
+
+// 同步映射中 [addr, addr + len) 所在的页
+static int rfc6962_store_msync(uint8_t *addr, size_t len)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)addr & ~(page - 1);
+    uintptr_t end = (uintptr_t)addr + len;
+
+    return msync((void *)begin, end - begin, MS_SYNC);
+}
+
+// 映射文件并填充树结构
+static rfc6962_merkle_tree_t *rfc6962_store_map(int fd, size_t file_size, int writable, int sync_policy)
+{
+    rfc6962_merkle_tree_t *tree = malloc(sizeof(rfc6962_merkle_tree_t));
+    struct rfc6962_store *store = malloc(sizeof(struct rfc6962_store));
+    void *map;
+
+    if (!tree || !store)
+        goto fail;
+
+    // 只读打开使用私有映射：重算右边缘只写入进程私有的少数几页，不修改文件
+    map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        goto fail;
+
+    store->fd = fd;
+    store->writable = writable;
+    store->sync_policy = sync_policy;
+    store->map = map;
+    store->map_size = file_size;
+    store->header = map;
+
+    tree->store = store;
+    tree->nodes = (merkle_node_t *)(store->map + RFC6962_STORE_HEADER_SIZE);
+    tree->leaves = tree->nodes;
+    tree->capacity = store->header->capacity;
+    tree->node_count = (file_size - RFC6962_STORE_HEADER_SIZE) / sizeof(merkle_node_t);
+    memcpy(tree->level_offset, store->header->level_offset, sizeof(tree->level_offset));
+    rfc6962_set_size(tree, store->header->size);
+    rfc6962_rebuild_right_edge(tree);
+    if (memcmp(tree->root_hash, store->header->root_hash, SM3_DIGEST_SIZE) != 0)
+    {
+        munmap(map, file_size);
+        goto fail;
+    }
+    return tree;
+
+fail:
+    free(tree);
+    free(store);
+    return NULL;
+}
+
+// 创建容量为 capacity 个叶子的空文件
+rfc6962_merkle_tree_t *rfc6962_store_create(const char *path, uint64_t capacity, int sync_policy)
+{
+    rfc6962_store_header_t header;
+    rfc6962_merkle_tree_t *tree;
+    int levels;
+    int fd;
+
+    if (capacity == 0)
+        return NULL;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RFC6962_STORE_MAGIC, sizeof(header.magic));
+    header.version = RFC6962_STORE_VERSION;
+    header.byte_order = RFC6962_STORE_BYTE_ORDER;
+    header.tile_height = RFC6962_STORE_TILE_HEIGHT;
+    header.capacity = capacity;
+    header.size = 0;
+    rfc6962_empty_root(header.root_hash);
+
+    uint64_t nodes = rfc6962_layout(capacity, (uint64_t)1 << RFC6962_STORE_TILE_HEIGHT, header.level_offset, &levels);
+    header.level_count = (uint32_t)levels;
+    size_t file_size = RFC6962_STORE_HEADER_SIZE + (size_t)nodes * sizeof(merkle_node_t);
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, (off_t)file_size) != 0 ||
+        pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || fsync(fd) != 0)
+    {
+        close(fd);
+        unlink(path);
+        return NULL;
+    }
+
+    tree = rfc6962_store_map(fd, file_size, 1, sync_policy);
+    if (!tree)
+    {
+        close(fd);
+        unlink(path);
+    }
+    return tree;
+}
+
+// 打开已有文件：校验头部并建立映射，再重算右边缘（O(log n) 次哈希）与头部中的根比对，其余节点不读取
+rfc6962_merkle_tree_t *rfc6962_store_open(const char *path, int writable, int sync_policy)
+{
+    rfc6962_store_header_t header;
+    rfc6962_merkle_tree_t *tree;
+    struct stat st;
+    uint64_t expected[MERKLE_MAX_LEVELS];
+    int levels;
+    int fd;
+
+    fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        goto fail;
+
+    // 校验头部与文件布局一致；字节序标记与版本一起检查，异序主机写的文件在解释任何整数字段前被拒绝
+    if (memcmp(header.magic, RFC6962_STORE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RFC6962_STORE_VERSION || header.byte_order != RFC6962_STORE_BYTE_ORDER ||
+        header.tile_height != RFC6962_STORE_TILE_HEIGHT || header.capacity == 0 || header.size > header.capacity)
+        goto fail;
+
+    uint64_t nodes = rfc6962_layout(header.capacity, (uint64_t)1 << header.tile_height, expected, &levels);
+    if ((uint32_t)levels != header.level_count ||
+        memcmp(expected, header.level_offset, (size_t)levels * sizeof(uint64_t)) != 0 ||
+        (uint64_t)st.st_size != RFC6962_STORE_HEADER_SIZE + nodes * sizeof(merkle_node_t))
+        goto fail;
+
+    tree = rfc6962_store_map(fd, (size_t)st.st_size, writable, sync_policy);
+    if (!tree)
+        goto fail;
+    return tree;
+
+fail:
+    close(fd);
+    return NULL;
+}
+
+int rfc6962_store_readonly(const rfc6962_merkle_tree_t *tree)
+{
+    return tree->store && !tree->store->writable;
+}
+
+// 追加提交：按同步策略落盘新写入的节点，再更新头部中的叶子数与根
+int rfc6962_store_commit(rfc6962_merkle_tree_t *tree, uint64_t old_size)
+{
+    struct rfc6962_store *store = tree->store;
+
+    if (!store->writable)
+        return -1;
+
+    if (store->sync_policy == RFC6962_SYNC_APPEND)
+    {
+        for (int level = 0; level < tree->level_count; level++)
+        {
+            uint64_t lo = old_size >> level;
+            uint64_t hi = tree->level_size[level];
+            if (rfc6962_store_msync(rfc6962_node(tree, level, lo), (size_t)(hi - lo) * sizeof(merkle_node_t)) != 0)
+                return -1;
+        }
+    }
+
+    memcpy(store->header->root_hash, tree->root_hash, SM3_DIGEST_SIZE);
+    store->header->size = tree->leaf_count;
+
+    if (store->sync_policy == RFC6962_SYNC_APPEND)
+        return rfc6962_store_msync(store->map, sizeof(rfc6962_store_header_t));
+    return 0;
+}
+
+// 将全部修改落盘
+int rfc6962_store_sync(rfc6962_merkle_tree_t *tree)
+{
+    struct rfc6962_store *store = tree->store;
+
+    if (!store)
+        return -1;
+    if (!store->writable)
+        return 0;
+
+    // 先节点后头部，保持提交顺序
+    if (msync(store->map + RFC6962_STORE_HEADER_SIZE, store->map_size - RFC6962_STORE_HEADER_SIZE, MS_SYNC) != 0)
+        return -1;
+    if (msync(store->map, RFC6962_STORE_HEADER_SIZE, MS_SYNC) != 0)
+        return -1;
+    return fsync(store->fd);
+}
+
+void rfc6962_store_close(rfc6962_merkle_tree_t *tree)
+{
+    struct rfc6962_store *store = tree->store;
+
+    if (store->writable)
+        rfc6962_store_sync(tree);
+    munmap(store->map, store->map_size);
+    close(store->fd);
+    free(store);
+    tree->store = NULL;
+}
@@ -1,3 +1,8 @@
+#define _POSIX_C_SOURCE 200112L // pthread, poll
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,508 +10,286 @@
 #include <time.h>
 #include <math.h>
 
-// SM3相关常量和函数声明
-#define SM3_DIGEST_SIZE 32
-
-// SM3轮函数常量 - 正确的值
-static const uint32_t K[64] = {
-    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb, 0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
-    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce, 0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
-    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
-    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
-    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
-    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
-    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
-    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43};
-
-// SM3辅助函数
-static uint32_t leftrotate(uint32_t value, int amount)
-{
-    return (value << amount) | (value >> (32 - amount));
-}
+#include "merkle_rfc6962.h"
 
-static uint32_t P0(uint32_t X)
+// 辅助函数
+void print_hash(const char *label, const uint8_t *hash)
 {
-    return X ^ leftrotate(X, 9) ^ leftrotate(X, 17);
+    printf("%s: ", label);
+    for (int i = 0; i < SM3_DIGEST_SIZE; i++)
+    {
+        printf("%02x", hash[i]);
+    }
+    printf("\n");
 }
 
-static uint32_t P1(uint32_t X)
+// 生成第 i 条测试记录的内容
+static void fill_test_record(uint8_t *record, uint64_t i, uint64_t data_len)
 {
-    return X ^ leftrotate(X, 15) ^ leftrotate(X, 23);
-}
+    // 使用安全的字符串操作
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "data_%llu_", (unsigned long long)i);
+    size_t prefix_len = strlen(prefix);
 
-static uint32_t FF(uint32_t X, uint32_t Y, uint32_t Z, int j)
-{
-    if (j < 16)
-    {
-        return X ^ Y ^ Z;
-    }
-    else
+    // 确保不会溢出
+    size_t copy_len = (prefix_len < data_len) ? prefix_len : data_len - 1;
+    memcpy(record, prefix, copy_len);
+
+    // 填充剩余字节
+    for (uint64_t j = copy_len; j < data_len; j++)
     {
-        return (X & Y) | (X & Z) | (Y & Z);
+        record[j] = (uint8_t)(i ^ j);
     }
 }
 
-static uint32_t GG(uint32_t X, uint32_t Y, uint32_t Z, int j)
+static uint64_t test_record_length(uint64_t i)
 {
-    if (j < 16)
-    {
-        return X ^ Y ^ Z;
-    }
-    else
-    {
-        return (X & Y) | (~X & Z);
-    }
+    return 32 + (i % 100);
 }
 
-// 完整的SM3哈希算法实现
-void sm3_hash(const uint8_t *input, size_t input_len, uint8_t *output)
+// 所有记录放在一次分配的连续内存中，data_array[i] 指向其中第 i 条
+void generate_test_data(uint8_t ***data_array, uint64_t **data_lengths, uint64_t count)
 {
-    // SM3初始哈希值
-    uint32_t H[8] = {
-        0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
-        0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e};
-
-    // 填充消息
-    size_t padding_len = 64 - ((input_len + 9) % 64);
-    size_t total_len = input_len + 1 + padding_len + 8;
-    uint8_t *padded = malloc(total_len);
-
-    memcpy(padded, input, input_len);
-    padded[input_len] = 0x80;
-    memset(padded + input_len + 1, 0, padding_len);
-
-    // 大端序存储长度
-    uint64_t bit_len = input_len * 8;
-    for (int i = 0; i < 8; i++)
-    {
-        padded[total_len - 1 - i] = (bit_len >> (i * 8)) & 0xFF;
-    }
+    uint64_t total = 0;
+    uint8_t *records;
 
-    // 处理每个512位块
-    for (size_t offset = 0; offset < total_len; offset += 64)
+    *data_array = malloc(count * sizeof(uint8_t *));
+    *data_lengths = malloc(count * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++)
     {
-        uint32_t W[68], W1[64];
-
-        // 消息扩展
-        for (int i = 0; i < 16; i++)
-        {
-            W[i] = ((uint32_t)padded[offset + i * 4] << 24) |
-                   ((uint32_t)padded[offset + i * 4 + 1] << 16) |
-                   ((uint32_t)padded[offset + i * 4 + 2] << 8) |
-                   ((uint32_t)padded[offset + i * 4 + 3]);
-        }
-
-        for (int i = 16; i < 68; i++)
-        {
-            W[i] = P1(W[i - 16] ^ W[i - 9] ^ leftrotate(W[i - 3], 15)) ^
-                   leftrotate(W[i - 13], 7) ^ W[i - 6];
-        }
-
-        for (int i = 0; i < 64; i++)
-        {
-            W1[i] = W[i] ^ W[i + 4];
-        }
-
-        // 压缩函数
-        uint32_t A = H[0], B = H[1], C = H[2], D = H[3];
-        uint32_t E = H[4], F = H[5], G = H[6], H_temp = H[7];
-
-        for (int j = 0; j < 64; j++)
-        {
-            uint32_t SS1 = leftrotate(leftrotate(A, 12) + E + leftrotate(K[j], j % 32), 7);
-            uint32_t SS2 = SS1 ^ leftrotate(A, 12);
-            uint32_t TT1 = FF(A, B, C, j) + D + SS2 + W1[j];
-            uint32_t TT2 = GG(E, F, G, j) + H_temp + SS1 + W[j];
-
-            D = C;
-            C = leftrotate(B, 9);
-            B = A;
-            A = TT1;
-            H_temp = G;
-            G = leftrotate(F, 19);
-            F = E;
-            E = P0(TT2);
-        }
-
-        // 更新哈希值
-        H[0] ^= A;
-        H[1] ^= B;
-        H[2] ^= C;
-        H[3] ^= D;
-        H[4] ^= E;
-        H[5] ^= F;
-        H[6] ^= G;
-        H[7] ^= H_temp;
+        (*data_lengths)[i] = test_record_length(i);
+        total += (*data_lengths)[i];
     }
 
-    // 输出结果
-    for (int i = 0; i < 8; i++)
+    records = malloc(total ? total : 1);
+    for (uint64_t i = 0; i < count; i++)
     {
-        output[i * 4] = (H[i] >> 24) & 0xFF;
-        output[i * 4 + 1] = (H[i] >> 16) & 0xFF;
-        output[i * 4 + 2] = (H[i] >> 8) & 0xFF;
-        output[i * 4 + 3] = H[i] & 0xFF;
+        (*data_array)[i] = records;
+        fill_test_record(records, i, (*data_lengths)[i]);
+        records += (*data_lengths)[i];
     }
-
-    free(padded);
 }
 
-// RFC6962 Merkle树结构
-typedef struct
+// 同样的记录连续存放在一块缓冲区中（模拟从网络或文件整块读入），offsets 共 count + 1 项
+void generate_test_buffer(uint8_t **buffer, uint64_t **offsets, uint64_t count)
 {
-    uint8_t **leaves;    // 叶子节点哈希数组
-    uint64_t leaf_count; // 实际叶子节点数量
-    uint8_t root_hash[SM3_DIGEST_SIZE];
-} rfc6962_merkle_tree_t;
+    uint64_t total = 0;
 
-typedef struct
-{
-    uint8_t **path;  // 审计路径
-    int *directions; // 方向数组 (0=兄弟在左, 1=兄弟在右)
-    int path_length;
-    uint64_t leaf_index;
-} rfc6962_audit_path_t;
+    *offsets = malloc((count + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        (*offsets)[i] = total;
+        total += test_record_length(i);
+    }
+    (*offsets)[count] = total;
 
-typedef struct
-{
-    uint64_t leaf_index;
-    uint8_t leaf_hash[SM3_DIGEST_SIZE];
-    rfc6962_audit_path_t audit_path;
-    uint8_t root_hash[SM3_DIGEST_SIZE];
-    uint64_t tree_size;
-} rfc6962_inclusion_proof_t;
-
-// RFC6962标准的哈希函数
-void hash_leaf(const uint8_t *data, size_t data_len, uint8_t *output)
-{
-    // RFC6962: H(0x00 || data)
-    uint8_t *prefixed_data = malloc(data_len + 1);
-    prefixed_data[0] = 0x00;
-    memcpy(prefixed_data + 1, data, data_len);
-    sm3_hash(prefixed_data, data_len + 1, output);
-    free(prefixed_data);
+    *buffer = malloc(total);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        fill_test_record(*buffer + (*offsets)[i], i, test_record_length(i));
+    }
 }
 
-void hash_children(const uint8_t *left, const uint8_t *right, uint8_t *output)
+void free_test_data(uint8_t **data_array, uint64_t *data_lengths, uint64_t count)
 {
-    // RFC6962: H(0x01 || left || right)
-    uint8_t combined[1 + SM3_DIGEST_SIZE * 2];
-    combined[0] = 0x01;
-    memcpy(combined + 1, left, SM3_DIGEST_SIZE);
-    memcpy(combined + 1 + SM3_DIGEST_SIZE, right, SM3_DIGEST_SIZE);
-    sm3_hash(combined, sizeof(combined), output);
+    if (count > 0)
+        free(data_array[0]); // 记录区的起点
+    free(data_array);
+    free(data_lengths);
 }
 
-// 简化但正确的二叉Merkle树构建 - 专门为验证设计
-uint8_t *build_simple_merkle_tree(uint8_t **leaves, uint64_t count, uint64_t target_index,
-                                  uint8_t ***audit_path, int **directions, int *path_length)
+// 按 RFC6962 定义递归计算 MTH(D[0:n])，用于校验逐层构建结果
+static void reference_mth(const merkle_node_t *leaves, uint64_t n, uint8_t *out)
 {
-    if (count == 0)
-        return NULL;
-    if (count == 1)
+    if (n == 1)
     {
-        *path_length = 0;
-        uint8_t *root = malloc(SM3_DIGEST_SIZE);
-        memcpy(root, leaves[0], SM3_DIGEST_SIZE);
-        return root;
+        memcpy(out, leaves[0], SM3_DIGEST_SIZE);
+        return;
     }
 
-    // 为了简化，我们构建一个完全二叉树
-    // 找到大于等于count的最小2的幂
-    uint64_t tree_size = 1;
-    while (tree_size < count)
+    uint64_t k = 1;
+    while (k * 2 < n)
     {
-        tree_size *= 2;
+        k *= 2;
     }
 
-    // 分配节点数组
-    uint8_t **nodes = malloc(tree_size * 2 * sizeof(uint8_t *));
-    for (uint64_t i = 0; i < tree_size * 2; i++)
-    {
-        nodes[i] = malloc(SM3_DIGEST_SIZE);
-    }
+    uint8_t left[SM3_DIGEST_SIZE], right[SM3_DIGEST_SIZE];
+    reference_mth(leaves, k, left);
+    reference_mth(leaves + k, n - k, right);
+    hash_children(left, right, out);
+}
 
-    // 复制叶子节点到底层
-    for (uint64_t i = 0; i < count; i++)
-    {
-        memcpy(nodes[tree_size + i], leaves[i], SM3_DIGEST_SIZE);
-    }
-    // 补充空叶子(用全0)
-    for (uint64_t i = count; i < tree_size; i++)
+// 对 1..max_size 每种大小：根与递归定义一致，所有索引的包含性证明、所有旧大小的一致性证明均可验证，
+// 最大的树上任意两个历史大小之间的一致性证明均可验证
+static int check_tree_shapes(uint8_t **data_array, uint64_t *data_lengths, uint64_t max_size)
+{
+    for (uint64_t n = 1; n <= max_size; n++)
     {
-        memset(nodes[tree_size + i], 0, SM3_DIGEST_SIZE);
-    }
+        rfc6962_merkle_tree_t *tree = build_rfc6962_merkle_tree(data_array, data_lengths, n);
+        uint8_t expected[SM3_DIGEST_SIZE];
+        int ok = tree != NULL;
 
-    // 自底向上构建树
-    for (uint64_t level_size = tree_size; level_size > 1; level_size /= 2)
-    {
-        for (uint64_t i = 0; i < level_size / 2; i++)
+        // 构建走批量叶子哈希与逐层哈希，逐个对照 hash_leaf 及递归定义
+        for (uint64_t m = 0; ok && m < n; m++)
         {
-            uint64_t left_idx = level_size + i * 2;
-            uint64_t right_idx = level_size + i * 2 + 1;
-            uint64_t parent_idx = level_size / 2 + i;
-            hash_children(nodes[left_idx], nodes[right_idx], nodes[parent_idx]);
+            hash_leaf(data_array[m], data_lengths[m], expected);
+            ok = memcmp(expected, tree->leaves[m], SM3_DIGEST_SIZE) == 0;
         }
-    }
-
-    // 生成审计路径
-    *path_length = 0;
-    uint64_t max_depth = 32; // 足够大
-    *audit_path = malloc(max_depth * sizeof(uint8_t *));
-    *directions = malloc(max_depth * sizeof(int));
-
-    uint64_t current_idx = tree_size + target_index;
-
-    while (current_idx > 1)
-    {
-        uint64_t sibling_idx;
-        if (current_idx % 2 == 0)
+        if (ok)
         {
-            // 当前节点是左子节点，兄弟在右边
-            sibling_idx = current_idx + 1;
-            (*directions)[*path_length] = 1; // 兄弟在右
+            reference_mth(tree->leaves, n, expected);
+            ok = memcmp(expected, tree->root_hash, SM3_DIGEST_SIZE) == 0;
         }
-        else
+        for (uint64_t m = 0; ok && m < n; m++)
         {
-            // 当前节点是右子节点，兄弟在左边
-            sibling_idx = current_idx - 1;
-            (*directions)[*path_length] = 0; // 兄弟在左
+            rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof(tree, m);
+            ok = proof != NULL && verify_rfc6962_inclusion_proof(proof);
+            if (ok)
+            {
+                // 篡改叶子后必须验证失败
+                proof->leaf_hash[0] ^= 1;
+                ok = !verify_rfc6962_inclusion_proof(proof);
+            }
+            free_rfc6962_inclusion_proof(proof);
         }
-
-        (*audit_path)[*path_length] = malloc(SM3_DIGEST_SIZE);
-        memcpy((*audit_path)[*path_length], nodes[sibling_idx], SM3_DIGEST_SIZE);
-        (*path_length)++;
-
-        current_idx = current_idx / 2; // 向上一层
-    }
-
-    uint8_t *root = malloc(SM3_DIGEST_SIZE);
-    memcpy(root, nodes[1], SM3_DIGEST_SIZE);
-
-    // 清理
-    for (uint64_t i = 0; i < tree_size * 2; i++)
-    {
-        free(nodes[i]);
-    }
-    free(nodes);
-
-    return root;
-}
-
-// 构建RFC6962 Merkle树
-rfc6962_merkle_tree_t *build_rfc6962_merkle_tree(uint8_t **data_array, uint64_t *data_lengths, uint64_t count)
-{
-    if (count == 0)
-        return NULL;
-
-    rfc6962_merkle_tree_t *tree = malloc(sizeof(rfc6962_merkle_tree_t));
-    if (!tree)
-        return NULL;
-
-    tree->leaf_count = count;
-    tree->leaves = malloc(count * sizeof(uint8_t *));
-    if (!tree->leaves)
-    {
-        free(tree);
-        return NULL;
-    }
-
-    // 计算叶子哈希
-    for (uint64_t i = 0; i < count; i++)
-    {
-        tree->leaves[i] = malloc(SM3_DIGEST_SIZE);
-        if (!tree->leaves[i])
+        for (uint64_t m = 0; ok && m < n; m++)
         {
-            // 清理已分配的内存
-            for (uint64_t j = 0; j < i; j++)
+            // 间隔为 m+1 的叶子子集
+            uint64_t subset[64];
+            uint64_t k = 0;
+            for (uint64_t i = m % 3; i < n; i += m + 1)
             {
-                free(tree->leaves[j]);
+                subset[k++] = i;
             }
-            free(tree->leaves);
-            free(tree);
-            return NULL;
+            rfc6962_multiproof_t *multi = k ? generate_rfc6962_multiproof(tree, subset, k) : NULL;
+            ok = k == 0 || (multi != NULL && verify_rfc6962_multiproof(multi));
+            free_rfc6962_multiproof(multi);
         }
-        hash_leaf(data_array[i], data_lengths[i], tree->leaves[i]);
-    }
-
-    // 使用简化的方法构建根哈希
-    uint8_t **dummy_path;
-    int *dummy_directions;
-    int dummy_path_len;
-    uint8_t *root = build_simple_merkle_tree(tree->leaves, count, 0, &dummy_path, &dummy_directions, &dummy_path_len);
-
-    if (root)
-    {
-        memcpy(tree->root_hash, root, SM3_DIGEST_SIZE);
-        free(root);
-    }
-
-    // 清理临时数据
-    for (int i = 0; i < dummy_path_len; i++)
-    {
-        free(dummy_path[i]);
-    }
-    free(dummy_path);
-    free(dummy_directions);
-
-    return tree;
-}
-
-// 生成RFC6962审计路径
-rfc6962_audit_path_t *generate_rfc6962_audit_path(rfc6962_merkle_tree_t *tree, uint64_t leaf_index)
-{
-    if (leaf_index >= tree->leaf_count)
-        return NULL;
-
-    rfc6962_audit_path_t *path = malloc(sizeof(rfc6962_audit_path_t));
-    if (!path)
-        return NULL;
-
-    // 使用简化方法生成路径
-    uint8_t *dummy_root = build_simple_merkle_tree(tree->leaves, tree->leaf_count, leaf_index,
-                                                   &path->path, &path->directions, &path->path_length);
-    path->leaf_index = leaf_index;
-
-    if (dummy_root)
-    {
-        free(dummy_root);
-    }
-
-    return path;
-}
-
-// 验证RFC6962包含性证明
-int verify_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof)
-{
-    uint8_t computed_hash[SM3_DIGEST_SIZE];
-    memcpy(computed_hash, proof->leaf_hash, SM3_DIGEST_SIZE);
-
-    // 从叶子向根重建路径
-    for (int i = 0; i < proof->audit_path.path_length; i++)
-    {
-        uint8_t parent_hash[SM3_DIGEST_SIZE];
-
-        if (proof->audit_path.directions[i] == 0)
+        for (uint64_t m = 1; ok && m <= n; m++)
         {
-            // 兄弟在左边，当前节点在右边
-            hash_children(proof->audit_path.path[i], computed_hash, parent_hash);
+            rfc6962_consistency_proof_t *proof = generate_rfc6962_consistency_proof(tree, m);
+            ok = proof != NULL && verify_rfc6962_consistency_proof(proof);
+            if (ok)
+            {
+                reference_mth(tree->leaves, m, expected);
+                ok = memcmp(expected, proof->old_root, SM3_DIGEST_SIZE) == 0;
+            }
+            if (ok && m < n)
+            {
+                proof->old_root[0] ^= 1;
+                ok = !verify_rfc6962_consistency_proof(proof);
+            }
+            free_rfc6962_consistency_proof(proof);
         }
-        else
+        // 最大的树上检查所有 (old, new) 历史大小组合
+        for (uint64_t b = 1; ok && n == max_size && b <= n; b++)
         {
-            // 兄弟在右边，当前节点在左边
-            hash_children(computed_hash, proof->audit_path.path[i], parent_hash);
+            uint8_t old_root[SM3_DIGEST_SIZE];
+            reference_mth(tree->leaves, b, expected);
+            for (uint64_t m = 1; ok && m <= b; m++)
+            {
+                rfc6962_consistency_proof_t *proof = generate_rfc6962_consistency_proof_between(tree, m, b);
+                reference_mth(tree->leaves, m, old_root);
+                ok = proof != NULL && proof->new_size == b && verify_rfc6962_consistency_proof(proof) &&
+                     memcmp(expected, proof->new_root, SM3_DIGEST_SIZE) == 0 &&
+                     memcmp(old_root, proof->old_root, SM3_DIGEST_SIZE) == 0;
+                free_rfc6962_consistency_proof(proof);
+            }
         }
 
-        memcpy(computed_hash, parent_hash, SM3_DIGEST_SIZE);
+        free_rfc6962_merkle_tree(tree);
+        if (!ok)
+        {
+            printf("  ❌ 叶子数 %llu 校验失败\n", (unsigned long long)n);
+            return 0;
+        }
     }
-
-    return memcmp(computed_hash, proof->root_hash, SM3_DIGEST_SIZE) == 0;
+    return 1;
 }
 
-// 生成包含性证明
-rfc6962_inclusion_proof_t *generate_rfc6962_inclusion_proof(rfc6962_merkle_tree_t *tree, uint64_t leaf_index)
+// 并发读线程：写者追加期间反复获取快照，生成并验证包含性证明与相对首个快照的一致性证明
+typedef struct
 {
-    if (leaf_index >= tree->leaf_count)
-        return NULL;
+    rfc6962_concurrent_tree_t *ct;
+    int *writer_done;
+    uint64_t proofs;
+    int ok;
+} concurrent_reader_t;
 
-    rfc6962_inclusion_proof_t *proof = malloc(sizeof(rfc6962_inclusion_proof_t));
-    if (!proof)
-        return NULL;
+static void *concurrent_reader_main(void *arg)
+{
+    concurrent_reader_t *r = arg;
+    int reader = rfc6962_reader_register(r->ct);
+    uint64_t base_size = 0;
+    uint8_t base_root[SM3_DIGEST_SIZE];
+
+    r->proofs = 0;
+    r->ok = reader >= 0;
+    while (r->ok && (!__atomic_load_n(r->writer_done, __ATOMIC_ACQUIRE) || r->proofs == 0))
+    {
+        const rfc6962_snapshot_t *snap = rfc6962_snapshot_acquire(r->ct, reader);
 
-    proof->leaf_index = leaf_index;
-    memcpy(proof->leaf_hash, tree->leaves[leaf_index], SM3_DIGEST_SIZE);
-    memcpy(proof->root_hash, tree->root_hash, SM3_DIGEST_SIZE);
-    proof->tree_size = tree->leaf_count;
+        if (snap->size > 0)
+        {
+            uint64_t index = (r->proofs * 7919) % snap->size;
+            rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof_at(r->ct, snap, index);
+            r->ok = proof && proof->tree_size == snap->size && verify_rfc6962_inclusion_proof(proof) &&
+                    memcmp(proof->root_hash, snap->root_hash, SM3_DIGEST_SIZE) == 0;
+            free_rfc6962_inclusion_proof(proof);
 
-    rfc6962_audit_path_t *path = generate_rfc6962_audit_path(tree, leaf_index);
-    if (!path)
-    {
-        free(proof);
-        return NULL;
+            if (base_size == 0)
+            {
+                base_size = snap->size;
+                memcpy(base_root, snap->root_hash, SM3_DIGEST_SIZE);
+            }
+            rfc6962_consistency_proof_t *cproof = generate_rfc6962_consistency_proof_at(r->ct, snap, base_size);
+            r->ok = r->ok && cproof && verify_rfc6962_consistency_proof(cproof) &&
+                    memcmp(cproof->old_root, base_root, SM3_DIGEST_SIZE) == 0 &&
+                    memcmp(cproof->new_root, snap->root_hash, SM3_DIGEST_SIZE) == 0;
+            free_rfc6962_consistency_proof(cproof);
+            r->proofs++;
+        }
+        rfc6962_snapshot_release(r->ct, reader);
     }
 
-    proof->audit_path = *path;
-    free(path);
-
-    return proof;
+    if (reader >= 0)
+        rfc6962_reader_unregister(r->ct, reader);
+    return NULL;
 }
 
-// 清理函数
-void free_rfc6962_merkle_tree(rfc6962_merkle_tree_t *tree)
-{
-    if (!tree)
-        return;
-
-    for (uint64_t i = 0; i < tree->leaf_count; i++)
-    {
-        free(tree->leaves[i]);
-    }
-    free(tree->leaves);
-    free(tree);
-}
+// 证明服务的完成检查：第 i 个请求的树大小为 serve_sizes[i % 3]（0 为最新快照），i 为 7 的倍数时索引越界
+static const uint64_t serve_sizes[] = {0, 200, 500};
 
-void free_rfc6962_inclusion_proof(rfc6962_inclusion_proof_t *proof)
+typedef struct
 {
-    if (!proof)
-        return;
+    const rfc6962_serve_request_t *requests; // 由请求地址反推序号
+    uint8_t roots[3][SM3_DIGEST_SIZE];       // 与 serve_sizes 对应的历史根，最新快照不比较
+    uint64_t done;
+    int ok;
+} serve_check_t;
 
-    for (int i = 0; i < proof->audit_path.path_length; i++)
-    {
-        free(proof->audit_path.path[i]);
-    }
-    free(proof->audit_path.path);
-    free(proof->audit_path.directions);
-    free(proof);
-}
-
-// 辅助函数
-void print_hash(const char *label, const uint8_t *hash)
+static int serve_request_ok(const serve_check_t *check, const rfc6962_serve_request_t *req)
 {
-    printf("%s: ", label);
-    for (int i = 0; i < SM3_DIGEST_SIZE; i++)
-    {
-        printf("%02x", hash[i]);
-    }
-    printf("\n");
+    uint64_t i = (uint64_t)(req - check->requests);
+    uint64_t size = serve_sizes[i % 3];
+
+    if (i % 7 == 0)
+        return req->status == -1;
+    return req->status == 0 && req->proof->leaf_index == req->leaf_index && verify_rfc6962_compact_proof(req->proof) &&
+           (size == 0 ? req->proof->tree_size >= 500
+                      : req->proof->tree_size == size &&
+                            memcmp(req->proof->root_hash, check->roots[i % 3], SM3_DIGEST_SIZE) == 0) &&
+           (!req->multiproof || verify_rfc6962_multiproof(req->multiproof));
 }
 
-void generate_test_data(uint8_t ***data_array, uint64_t **data_lengths, uint64_t count)
+// 回调在工作线程上执行，批量证明只在回调内有效
+static void serve_complete(rfc6962_serve_request_t *req)
 {
-    *data_array = malloc(count * sizeof(uint8_t *));
-    *data_lengths = malloc(count * sizeof(uint64_t));
-
-    for (uint64_t i = 0; i < count; i++)
-    {
-        uint64_t data_len = 32 + (i % 100);
-        (*data_lengths)[i] = data_len;
-        (*data_array)[i] = malloc(data_len);
-
-        // 使用安全的字符串操作
-        char prefix[32];
-        snprintf(prefix, sizeof(prefix), "data_%llu_", (unsigned long long)i);
-        size_t prefix_len = strlen(prefix);
-
-        // 确保不会溢出
-        size_t copy_len = (prefix_len < data_len) ? prefix_len : data_len - 1;
-        memcpy((*data_array)[i], prefix, copy_len);
+    serve_check_t *check = req->user;
 
-        // 填充剩余字节
-        for (uint64_t j = copy_len; j < data_len; j++)
-        {
-            (*data_array)[i][j] = (uint8_t)(i ^ j);
-        }
-    }
-}
-
-void free_test_data(uint8_t **data_array, uint64_t *data_lengths, uint64_t count)
-{
-    for (uint64_t i = 0; i < count; i++)
-    {
-        free(data_array[i]);
-    }
-    free(data_array);
-    free(data_lengths);
+    if (!serve_request_ok(check, req))
+        __atomic_store_n(&check->ok, 0, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&check->done, 1, __ATOMIC_RELEASE);
 }
 
 // 主测试函数
@@ -598,8 +381,469 @@ int main()
         }
     }
 
+    printf("\n4. 测试一致性证明...\n");
+    uint64_t old_sizes[] = {1, 42, 512, 999, 1000};
+    int old_size_count = sizeof(old_sizes) / sizeof(old_sizes[0]);
+
+    for (int i = 0; i < old_size_count; i++)
+    {
+        rfc6962_consistency_proof_t *proof = generate_rfc6962_consistency_proof(tree, old_sizes[i]);
+        if (!proof)
+        {
+            printf("  PROOF(%llu, %llu): ❌ 证明生成失败\n", (unsigned long long)old_sizes[i],
+                   (unsigned long long)tree->leaf_count);
+            continue;
+        }
+        printf("  PROOF(%llu, %llu) 长度 %d: %s\n", (unsigned long long)proof->old_size,
+               (unsigned long long)proof->new_size, proof->path_length,
+               verify_rfc6962_consistency_proof(proof) ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_consistency_proof(proof);
+    }
+
+    // 两个历史大小之间：与直接在 777 个叶子的树上生成的证明逐字节一致
+    {
+        rfc6962_merkle_tree_t *prefix = build_rfc6962_merkle_tree(data_array, data_lengths, 777);
+        rfc6962_consistency_proof_t *proof = generate_rfc6962_consistency_proof_between(tree, 333, 777);
+        rfc6962_consistency_proof_t *expected = prefix ? generate_rfc6962_consistency_proof(prefix, 333) : NULL;
+        int ok = proof && expected && verify_rfc6962_consistency_proof(proof) &&
+                 proof->path_length == expected->path_length &&
+                 memcmp(proof->new_root, prefix->root_hash, SM3_DIGEST_SIZE) == 0 &&
+                 memcmp(proof->path, expected->path, (size_t)proof->path_length * sizeof(merkle_node_t)) == 0;
+        printf("  PROOF(333, 777) 长度 %d（在 %llu 个叶子的树上生成）: %s\n", proof ? proof->path_length : 0,
+               (unsigned long long)tree->leaf_count, ok ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_consistency_proof(proof);
+        free_rfc6962_consistency_proof(expected);
+        free_rfc6962_merkle_tree(prefix);
+    }
+
     free_rfc6962_merkle_tree(tree);
 
+    printf("\n5. 树形校验（1-64 个叶子，对照 RFC6962 MTH 递归定义）...\n");
+    printf("  根哈希/包含性证明/批量证明/一致性证明: %s\n",
+           check_tree_shapes(data_array, data_lengths, 64) ? "✅ 通过" : "❌ 失败");
+
+    printf("\n6. 测试追加式增量日志...\n");
+    {
+        rfc6962_log_t log;
+        uint8_t log_root[SM3_DIGEST_SIZE], expected[SM3_DIGEST_SIZE];
+        int ok = 1;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        rfc6962_log_init(&log);
+        for (uint64_t n = 0; ok && n < test_count; n++)
+        {
+            rfc6962_log_append(&log, data_array[n], data_lengths[n]);
+            rfc6962_log_root(&log, log_root);
+            ok = tree && rfc6962_root_at(tree, n + 1, expected) == 0 &&
+                 memcmp(log_root, expected, SM3_DIGEST_SIZE) == 0;
+        }
+        printf("  逐个追加 %llu 个叶子，每个大小下的根与历史树根一致: %s\n",
+               (unsigned long long)test_count, ok ? "✅ 通过" : "❌ 失败");
+
+        rfc6962_log_init(&log);
+        rfc6962_log_append_batch(&log, data_array, data_lengths, 600);
+        rfc6962_log_append_batch(&log, data_array + 600, data_lengths + 600, test_count - 600);
+        rfc6962_log_root(&log, log_root);
+        printf("  批量追加后的根与整树构建一致（状态 %zu 字节）: %s\n", sizeof(log),
+               tree && memcmp(log_root, tree->root_hash, SM3_DIGEST_SIZE) == 0 ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_merkle_tree(tree);
+    }
+
+    printf("\n7. 测试内存映射持久化存储...\n");
+    {
+        const char *store_path = "merkle_rfc6962_demo.mtree";
+        uint8_t expected[SM3_DIGEST_SIZE];
+        int ok;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        rfc6962_merkle_tree_t *stored = rfc6962_store_create(store_path, 1 << 20, RFC6962_SYNC_APPEND);
+        ok = tree && stored && rfc6962_tree_append_batch(stored, data_array, data_lengths, 600) == 0;
+        for (uint64_t n = 600; ok && n < test_count; n++)
+        {
+            ok = rfc6962_tree_append(stored, data_array[n], data_lengths[n]) == 0;
+        }
+        ok = ok && memcmp(stored->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0;
+        free_rfc6962_merkle_tree(stored);
+        printf("  写入文件（容量 %d 叶子）后的根与内存构建一致: %s\n", 1 << 20, ok ? "✅ 通过" : "❌ 失败");
+
+        // 重新打开：只重算右边缘，不重建整棵树即可直接出证明
+        stored = rfc6962_store_open(store_path, 0, RFC6962_SYNC_NONE);
+        ok = stored && stored->leaf_count == test_count &&
+             memcmp(stored->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0;
+        if (ok)
+        {
+            rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof(stored, 777);
+            rfc6962_consistency_proof_t *cproof = generate_rfc6962_consistency_proof(stored, 333);
+            ok = proof && verify_rfc6962_inclusion_proof(proof) && cproof && verify_rfc6962_consistency_proof(cproof) &&
+                 rfc6962_root_at(tree, 333, expected) == 0 && memcmp(expected, cproof->old_root, SM3_DIGEST_SIZE) == 0;
+            free_rfc6962_inclusion_proof(proof);
+            free_rfc6962_consistency_proof(cproof);
+        }
+        printf("  重新打开后直接生成并验证包含性/一致性证明: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        // 只读打开的存储拒绝追加，失败后叶子数与根保持不变
+        ok = stored && rfc6962_tree_append(stored, data_array[0], data_lengths[0]) == -1 &&
+             rfc6962_tree_append_batch(stored, data_array, data_lengths, 10) == -1 && stored->leaf_count == test_count &&
+             memcmp(stored->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0;
+        free_rfc6962_merkle_tree(stored);
+        printf("  只读存储上的追加失败且不改变叶子数与根: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        free_rfc6962_merkle_tree(tree);
+        remove(store_path);
+    }
+
+    printf("\n8. 测试批量包含性证明...\n");
+    {
+        uint64_t batch_indices[100];
+        int batch_size = sizeof(batch_indices) / sizeof(batch_indices[0]);
+        uint64_t single_nodes = 0;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        for (int i = 0; i < batch_size; i++)
+        {
+            batch_indices[i] = 300 + (uint64_t)i; // 集中的索引
+            rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof(tree, batch_indices[i]);
+            single_nodes += proof ? (uint64_t)proof->audit_path.path_length : 0;
+            free_rfc6962_inclusion_proof(proof);
+        }
+
+        rfc6962_multiproof_t *multi = generate_rfc6962_multiproof(tree, batch_indices, batch_size);
+        int ok = multi && verify_rfc6962_multiproof(multi);
+        printf("  %d 个连续叶子：逐个证明共 %llu 个节点，批量证明 %llu 个节点\n", batch_size,
+               (unsigned long long)single_nodes, multi ? (unsigned long long)multi->node_count : 0ULL);
+        if (ok)
+        {
+            // 篡改任一叶子后必须验证失败
+            multi->leaf_hashes[57][0] ^= 1;
+            ok = !verify_rfc6962_multiproof(multi);
+        }
+        printf("  批量证明验证及篡改检测: %s\n", ok ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_multiproof(multi);
+        free_rfc6962_merkle_tree(tree);
+    }
+
+    printf("\n9. 测试无锁并发读（快照 + 纪元回收）...\n");
+    {
+        concurrent_reader_t readers[2];
+        pthread_t threads[2];
+        int reader_count = sizeof(readers) / sizeof(readers[0]);
+        int writer_done = 0;
+        int ok;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        rfc6962_concurrent_tree_t *ct = rfc6962_concurrent_create(rfc6962_tree_create(test_count));
+        ok = tree && ct && rfc6962_concurrent_append_batch(ct, data_array, data_lengths, 100) == 0;
+        for (int i = 0; ok && i < reader_count; i++)
+        {
+            readers[i].ct = ct;
+            readers[i].writer_done = &writer_done;
+            ok = pthread_create(&threads[i], NULL, concurrent_reader_main, &readers[i]) == 0;
+        }
+
+        // 读者运行期间逐个追加其余叶子，每次追加发布一个新快照
+        for (uint64_t n = 100; ok && n < test_count; n++)
+        {
+            ok = rfc6962_concurrent_append(ct, data_array[n], data_lengths[n]) == 0;
+        }
+        __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+
+        uint64_t proofs = 0;
+        for (int i = 0; i < reader_count; i++)
+        {
+            pthread_join(threads[i], NULL);
+            ok = ok && readers[i].ok;
+            proofs += readers[i].proofs;
+        }
+        printf("  %d 个读线程在 %llu 次追加期间生成并验证 %llu 组证明: %s\n", reader_count,
+               (unsigned long long)(test_count - 100), (unsigned long long)proofs, ok ? "✅ 通过" : "❌ 失败");
+
+        if (ct)
+        {
+            int reader = rfc6962_reader_register(ct);
+            const rfc6962_snapshot_t *snap = rfc6962_snapshot_acquire(ct, reader);
+            printf("  最终快照的大小与根和整树构建一致: %s\n",
+                   tree && snap->size == test_count && memcmp(snap->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0
+                       ? "✅ 通过"
+                       : "❌ 失败");
+            rfc6962_snapshot_release(ct, reader);
+            rfc6962_reader_unregister(ct, reader);
+        }
+        rfc6962_concurrent_free(ct);
+        free_rfc6962_merkle_tree(tree);
+    }
+
+    printf("\n10. 测试紧凑证明与 arena 分配...\n");
+    {
+        uint8_t stack_buffer[4096] __attribute__((aligned(RFC6962_ARENA_ALIGN)));
+        rfc6962_arena_t arena;
+        int ok = 1;
+
+        // 4KB 栈缓冲区放不下一轮的全部证明，溢出部分由堆块承接，reset 后复用
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        rfc6962_arena_init(&arena, stack_buffer, sizeof(stack_buffer), RFC6962_ARENA_DEFAULT_GROW);
+        for (int round = 0; ok && round < 3; round++)
+        {
+            for (uint64_t i = 0; ok && i < test_count; i++)
+            {
+                rfc6962_compact_proof_t *compact = generate_rfc6962_compact_proof(tree, i, &arena);
+                rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof(tree, i);
+
+                ok = compact && proof && verify_rfc6962_compact_proof(compact) &&
+                     compact->depth == (uint32_t)proof->audit_path.path_length &&
+                     memcmp(compact->path, proof->audit_path.path, compact->depth * sizeof(merkle_node_t)) == 0;
+                for (uint32_t d = 0; ok && d < compact->depth; d++)
+                {
+                    ok = (int)((compact->directions >> d) & 1) == proof->audit_path.directions[d];
+                }
+                free_rfc6962_inclusion_proof(proof);
+            }
+            rfc6962_arena_reset(&arena);
+        }
+        printf("  %llu 个叶子的紧凑证明与普通证明一致且可验证（3 轮 reset 复用）: %s\n",
+               (unsigned long long)test_count, ok ? "✅ 通过" : "❌ 失败");
+
+        // 不增长的 arena 用尽后返回 NULL
+        rfc6962_arena_t fixed;
+        rfc6962_arena_init(&fixed, stack_buffer, RFC6962_COMPACT_PROOF_SIZE(tree->level_count - 1), 0);
+        rfc6962_compact_proof_t *first = generate_rfc6962_compact_proof(tree, 0, &fixed);
+        ok = first && verify_rfc6962_compact_proof(first) && !generate_rfc6962_compact_proof(tree, 1, &fixed);
+        if (ok)
+        {
+            first->leaf_hash[0] ^= 1;
+            ok = !verify_rfc6962_compact_proof(first);
+        }
+        printf("  调用方定长缓冲区用尽检测与篡改检测: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        rfc6962_arena_destroy(&arena);
+        free_rfc6962_merkle_tree(tree);
+    }
+
+    printf("\n11. 测试证明与签名树头的二进制编码...\n");
+    {
+        uint8_t wire[RFC6962_WIRE_INCLUSION_SIZE(MERKLE_MAX_LEVELS - 1)];
+        uint8_t tls[1 + 127 + 18 + (MERKLE_MAX_LEVELS - 1) * (1 + SM3_DIGEST_SIZE)];
+        const uint8_t log_id[] = {0x06, 0x08, 0x2a, 0x81, 0x1c, 0xcf, 0x55, 0x01, 0x83, 0x11}; // 示例 LogID
+        rfc6962_wire_inclusion_t decoded;
+        int ok = 1;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        for (uint64_t i = 0; ok && i < test_count; i++)
+        {
+            rfc6962_compact_proof_t *proof = generate_rfc6962_compact_proof(tree, i, rfc6962_thread_arena());
+            size_t n = proof ? rfc6962_wire_encode_inclusion(proof, wire, sizeof(wire)) : 0;
+            size_t t = proof ? rfc6962_tls_encode_inclusion(proof, log_id, sizeof(log_id), tls, sizeof(tls)) : 0;
+
+            ok = proof && n == RFC6962_WIRE_INCLUSION_SIZE(proof->depth) &&
+                 rfc6962_wire_verify_inclusion(wire, n, tree->root_hash) && rfc6962_wire_decode_inclusion(wire, n, &decoded) == 0 && decoded.directions == proof->directions &&
+                 t > 0 && rfc6962_tls_verify_inclusion(tls, t, proof->leaf_hash, tree->root_hash);
+            if (ok && proof->depth > 0)
+            {
+                // 篡改路径节点、方向位或截断缓冲区都必须被拒绝
+                wire[RFC6962_WIRE_INCLUSION_SIZE(0)] ^= 1;
+                ok = !rfc6962_wire_verify_inclusion(wire, n, NULL);
+                wire[RFC6962_WIRE_INCLUSION_SIZE(0)] ^= 1;
+                wire[31] ^= 1;
+                ok = ok && !rfc6962_wire_verify_inclusion(wire, n, NULL);
+                wire[31] ^= 1;
+                ok = ok && !rfc6962_wire_verify_inclusion(wire, n - 1, NULL) &&
+                     !rfc6962_tls_verify_inclusion(tls, t - 1, proof->leaf_hash, tree->root_hash);
+            }
+            rfc6962_arena_reset(rfc6962_thread_arena());
+        }
+        printf("  紧凑格式与 TLS 格式的编码、零拷贝验证及篡改检测: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        const uint8_t signature[] = {0x30, 0x45, 0x02, 0x21};
+        rfc6962_tree_head_t sth = {tree->leaf_count, 1700000000000ULL, {0}, signature, sizeof(signature)};
+        rfc6962_tree_head_t sth_decoded;
+        uint8_t sth_wire[RFC6962_WIRE_TREE_HEAD_SIZE(sizeof(signature))], signed_data[RFC6962_TLS_TREE_HEAD_SIZE];
+        memcpy(sth.root_hash, tree->root_hash, SM3_DIGEST_SIZE);
+        size_t n = rfc6962_wire_encode_tree_head(&sth, sth_wire, sizeof(sth_wire));
+        ok = n == sizeof(sth_wire) && rfc6962_wire_decode_tree_head(sth_wire, n, &sth_decoded) == 0 &&
+             sth_decoded.tree_size == sth.tree_size && sth_decoded.timestamp == sth.timestamp &&
+             memcmp(sth_decoded.root_hash, sth.root_hash, SM3_DIGEST_SIZE) == 0 &&
+             sth_decoded.signature_len == sizeof(signature) &&
+             memcmp(sth_decoded.signature, signature, sizeof(signature)) == 0 &&
+             rfc6962_tls_encode_tree_head(&sth, signed_data, sizeof(signed_data)) == RFC6962_TLS_TREE_HEAD_SIZE &&
+             signed_data[0] == 0 && signed_data[1] == 1 && memcmp(signed_data + 18, sth.root_hash, SM3_DIGEST_SIZE) == 0;
+        printf("  签名树头编码往返及 TreeHeadSignature 签名输入: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        rfc6962_thread_arena_release();
+        free_rfc6962_merkle_tree(tree);
+    }
+
+    printf("\n12. 测试设备构建后端...\n");
+    {
+        const uint64_t device_sizes[] = {1, 1000, 70000, 70000}; // 最后一组全是空记录
+        const char *device = rfc6962_gpu_device_name();
+        // 有设备时强制用设备，避免设备端失败被自动回退掩盖
+        int backend = rfc6962_gpu_available() ? RFC6962_BACKEND_GPU : RFC6962_BACKEND_AUTO;
+        int ok = 1;
+
+        printf("  设备: %s\n", device ? device : "无可用 GPU，自动回退到 CPU");
+        for (size_t s = 0; ok && s < sizeof(device_sizes) / sizeof(device_sizes[0]); s++)
+        {
+            uint8_t *buffer;
+            uint64_t *offsets;
+            uint8_t root[SM3_DIGEST_SIZE];
+
+            generate_test_buffer(&buffer, &offsets, device_sizes[s]);
+            if (s == 3)
+                memset(offsets, 0, (size_t)(device_sizes[s] + 1) * sizeof(uint64_t));
+            rfc6962_merkle_tree_t *cpu = build_rfc6962_merkle_tree_buffer(buffer, offsets, device_sizes[s], 1);
+            rfc6962_merkle_tree_t *dev =
+                build_rfc6962_merkle_tree_device(buffer, offsets, device_sizes[s], backend);
+
+            // 各层节点与根都要逐位一致
+            ok = cpu && dev && dev->level_count == cpu->level_count &&
+                 memcmp(dev->root_hash, cpu->root_hash, SM3_DIGEST_SIZE) == 0;
+            for (int level = 0; ok && level < cpu->level_count; level++)
+            {
+                ok = memcmp(rfc6962_node(dev, level, 0), rfc6962_node(cpu, level, 0),
+                            (size_t)cpu->level_size[level] * sizeof(merkle_node_t)) == 0;
+            }
+            ok = ok && rfc6962_root_device(buffer, offsets, device_sizes[s], backend, root) == 0 &&
+                 memcmp(root, cpu->root_hash, SM3_DIGEST_SIZE) == 0;
+
+            free_rfc6962_merkle_tree(dev);
+            free_rfc6962_merkle_tree(cpu);
+            free(offsets);
+            free(buffer);
+        }
+        printf("  1/1000/70000 个叶子及 70000 条空记录的设备构建与只求根，结果与 CPU 构建逐位一致: %s\n", ok ? "✅ 通过" : "❌ 失败");
+    }
+
+    printf("\n13. 测试 SM3 树哈希模式...\n");
+    {
+        const size_t chunk = 4096;
+        const uint64_t len = 1000 * chunk + 123; // 最后一块不满
+        uint8_t *input = malloc((size_t)len);
+        uint8_t digest[SM3_DIGEST_SIZE], digest_mt[SM3_DIGEST_SIZE], expected[SM3_DIGEST_SIZE];
+        rfc6962_merkle_tree_t *chunks = NULL;
+        int ok = input != NULL;
+
+        for (uint64_t i = 0; ok && i < len; i++)
+        {
+            input[i] = (uint8_t)(i * 7 + (i >> 12));
+        }
+
+        // 摘要即各块 hash_leaf 的 MTH，与线程数无关
+        rfc6962_merkle_tree_t *reference = ok ? rfc6962_tree_create(len / chunk + 1) : NULL;
+        for (uint64_t i = 0; reference && i * chunk < len; i++)
+        {
+            hash_leaf(input + i * chunk, len - i * chunk < chunk ? (size_t)(len - i * chunk) : chunk, expected);
+            rfc6962_tree_append_hash(reference, expected);
+        }
+        ok = reference && rfc6962_treehash(input, len, chunk, 1, digest, NULL) == 0 &&
+             rfc6962_treehash(input, len, chunk, 0, digest_mt, &chunks) == 0 &&
+             memcmp(digest, reference->root_hash, SM3_DIGEST_SIZE) == 0 &&
+             memcmp(digest_mt, digest, SM3_DIGEST_SIZE) == 0;
+
+        // 只重新哈希区间覆盖的块；区间内任一字节被改动都必须被发现
+        ok = ok && rfc6962_treehash_verify_range(chunks, digest, input, len, chunk, 5 * chunk - 10, 2 * chunk) &&
+             rfc6962_treehash_verify_range(chunks, digest, input, len, chunk, len - 1, 1);
+        if (ok)
+        {
+            input[6 * chunk] ^= 1;
+            ok = !rfc6962_treehash_verify_range(chunks, digest, input, len, chunk, 5 * chunk - 10, 2 * chunk) &&
+                 rfc6962_treehash_verify_range(chunks, digest, input, len, chunk, 0, 5 * chunk);
+            input[6 * chunk] ^= 1;
+        }
+
+        // 单块输入的摘要就是该块的叶子哈希
+        hash_leaf(input, 100, expected);
+        ok = ok && rfc6962_treehash(input, 100, chunk, 0, digest, NULL) == 0 &&
+             memcmp(digest, expected, SM3_DIGEST_SIZE) == 0;
+        printf("  多线程树哈希、块摘要区间校验与篡改检测: %s\n", ok ? "✅ 通过" : "❌ 失败");
+
+        free_rfc6962_merkle_tree(chunks);
+        free_rfc6962_merkle_tree(reference);
+        free(input);
+    }
+
+    printf("\n14. 测试异步批量证明服务...\n");
+    {
+        const uint64_t request_count = 2000;
+        rfc6962_serve_request_t *requests = calloc((size_t)request_count, sizeof(rfc6962_serve_request_t));
+        uint8_t *buffers = malloc((size_t)request_count * RFC6962_COMPACT_PROOF_MAX_SIZE);
+        rfc6962_server_config_t config = {2, 256, RFC6962_SERVER_MULTIPROOF | RFC6962_SERVER_PIN};
+        serve_check_t check = {requests, {{0}}, 0, 1};
+        rfc6962_server_t *server = NULL;
+        uint64_t polled = 0;
+        uint64_t retries = 0;
+        int ok;
+
+        tree = build_rfc6962_merkle_tree(data_array, data_lengths, test_count);
+        rfc6962_concurrent_tree_t *ct = rfc6962_concurrent_create(rfc6962_tree_create(test_count));
+        ok = requests && buffers && tree && ct && rfc6962_concurrent_append_batch(ct, data_array, data_lengths, 500) == 0;
+        for (int i = 1; ok && i < 3; i++)
+        {
+            ok = rfc6962_root_at(tree, serve_sizes[i], check.roots[i]) == 0;
+        }
+        server = ok ? rfc6962_server_create(ct, &config) : NULL;
+        ok = ok && server;
+
+        // 奇数请求走回调，偶数请求走完成队列；提交的同时追加其余叶子，最新快照不断前进
+        for (uint64_t i = 0; ok && i < request_count; i++)
+        {
+            rfc6962_serve_request_t *req = &requests[i];
+            uint64_t size = serve_sizes[i % 3];
+
+            req->leaf_index = i % 7 == 0 ? (size ? size : test_count) + i : (i * 7919) % (size ? size : 500);
+            req->tree_size = size;
+            req->proof = (rfc6962_compact_proof_t *)(buffers + i * RFC6962_COMPACT_PROOF_MAX_SIZE);
+            req->proof_capacity = RFC6962_COMPACT_PROOF_MAX_SIZE;
+            req->complete = i % 2 ? serve_complete : NULL;
+            req->user = &check;
+            if (500 + i < test_count)
+                ok = rfc6962_concurrent_append(ct, data_array[500 + i], data_lengths[500 + i]) == 0;
+
+            // 在途请求满时先取走完成队列再重试
+            while (ok && rfc6962_server_submit(server, req) != 0)
+            {
+                rfc6962_serve_request_t *done[64];
+                size_t n = rfc6962_server_poll(server, done, 64);
+                for (size_t j = 0; j < n; j++)
+                {
+                    ok = ok && serve_request_ok(&check, done[j]);
+                }
+                polled += n;
+                retries++;
+                if (n == 0)
+                    sched_yield();
+            }
+        }
+
+        // 等待剩余的完成通知
+        while (ok && polled < request_count / 2)
+        {
+            struct pollfd pfd = {rfc6962_server_eventfd(server), POLLIN, 0};
+            rfc6962_serve_request_t *done[64];
+            size_t n;
+
+            if (poll(&pfd, 1, 5000) <= 0)
+            {
+                ok = 0;
+                break;
+            }
+            n = rfc6962_server_poll(server, done, 64);
+            for (size_t j = 0; j < n; j++)
+            {
+                ok = ok && serve_request_ok(&check, done[j]);
+            }
+            polled += n;
+        }
+        rfc6962_server_destroy(server);
+        ok = ok && __atomic_load_n(&check.ok, __ATOMIC_RELAXED) &&
+             __atomic_load_n(&check.done, __ATOMIC_ACQUIRE) == request_count / 2;
+        printf("  %llu 个请求（回调与完成队列各半，含越界索引与历史树大小，满队列重试 %llu 次）: %s\n",
+               (unsigned long long)request_count, (unsigned long long)retries, ok ? "✅ 通过" : "❌ 失败");
+
+        rfc6962_concurrent_free(ct);
+        free_rfc6962_merkle_tree(tree);
+        free(buffers);
+        free(requests);
+    }
+
     // 性能测试 - 包括10万节点
     printf("\n=== RFC6962 Merkle树性能测试 ===\n\n");
 
@@ -627,6 +871,25 @@ int main()
         printf("构建时间: %.3f 秒\n", (double)(end - start) / CLOCKS_PER_SEC);
         print_hash("根哈希", tree->root_hash);
 
+        // 多线程构建（全部在线CPU）应得到逐位一致的根
+        rfc6962_merkle_tree_t *tree_mt = build_rfc6962_merkle_tree_mt(data_array, data_lengths, size, 0);
+        printf("多线程构建根哈希一致: %s\n",
+               tree_mt && memcmp(tree_mt->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0 ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_merkle_tree(tree_mt);
+
+        // 从连续缓冲区零拷贝构建
+        uint8_t *buffer;
+        uint64_t *offsets;
+        generate_test_buffer(&buffer, &offsets, size);
+        start = clock();
+        rfc6962_merkle_tree_t *tree_buf = build_rfc6962_merkle_tree_buffer(buffer, offsets, size, 1);
+        end = clock();
+        printf("连续缓冲区零拷贝构建时间: %.3f 秒，根哈希一致: %s\n", (double)(end - start) / CLOCKS_PER_SEC,
+               tree_buf && memcmp(tree_buf->root_hash, tree->root_hash, SM3_DIGEST_SIZE) == 0 ? "✅ 通过" : "❌ 失败");
+        free_rfc6962_merkle_tree(tree_buf);
+        free(offsets);
+        free(buffer);
+
         // 测试证明生成和验证
         uint64_t test_index = size / 2;
 
@@ -0,0 +1,226 @@
+/*
+ * RFC6962 Merkle Proof Wire Formats
+ * 包含性证明与签名树头的二进制编码
+ *
+ * 紧凑格式（版本 1，所有整数为大端序，不含任何指针，可直接收发与存储）：
+ *   包含性证明  0: version  1: type=1  2: depth  3-7: 0
+ *               8: leaf_index  16: tree_size  24: directions（第 i 位为1表示 path[i] 是右兄弟）
+ *               32: leaf_hash[32]  64: root_hash[32]  96: path[depth][32]
+ *   签名树头    0: version  1: type=2  2-5: 0  6: signature_len (uint16)
+ *               8: tree_size  16: timestamp（毫秒）  24: root_hash[32]  56: signature[signature_len]
+ * 验证直接在收到的字节缓冲区上进行：路径节点本身就是连续的 32 字节数组，不解析到中间结构、不分配内存
+ *
+ * TLS 格式与 RFC6962 / RFC 9162 客户端互通：
+ *   包含性证明按 RFC 9162 4.12 节 InclusionProofDataV2：
+ *     opaque LogID<2..127>; uint64 tree_size; uint64 leaf_index; opaque NodeHash<32..255> inclusion_path<0..2^16-1>
+ *   签名树头的签名输入按 RFC6962 3.5 节 TreeHeadSignature（根哈希字段为 SM3 摘要）
+ */
+
+#include <string.h>
+
+#include "merkle_internal.h"
+
+#define RFC6962_TLS_VERSION_V1 0
+#define RFC6962_TLS_TREE_HASH 1
+
+static void rfc6962_put_u64(uint8_t *p, uint64_t v)
+{
+    for (int i = 7; i >= 0; i--, v >>= 8)
+        p[i] = (uint8_t)v;
+}
+
+static uint64_t rfc6962_get_u64(const uint8_t *p)
+{
+    uint64_t v = 0;
+
+    for (int i = 0; i < 8; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+// 由 leaf_index 与 tree_size 推出审计路径的节点数与方向位（与 rfc6962_fill_path 的取法一致）
+static int rfc6962_expected_path(uint64_t leaf_index, uint64_t tree_size, uint64_t *directions)
+{
+    uint64_t bits = 0;
+    int depth = 0;
+
+    for (uint64_t level_size = tree_size; level_size > 1; level_size = (level_size + 1) >> 1, leaf_index >>= 1)
+    {
+        if (leaf_index & 1)
+            depth++;
+        else if (leaf_index + 1 < level_size)
+            bits |= (uint64_t)1 << depth++;
+    }
+    *directions = bits;
+    return depth;
+}
+
+size_t rfc6962_wire_encode_inclusion(const rfc6962_compact_proof_t *proof, uint8_t *buf, size_t cap)
+{
+    size_t size = RFC6962_WIRE_INCLUSION_SIZE(proof->depth);
+
+    if (proof->depth >= MERKLE_MAX_LEVELS || cap < size)
+        return 0;
+
+    memset(buf, 0, RFC6962_WIRE_HEADER_SIZE);
+    buf[0] = RFC6962_WIRE_VERSION;
+    buf[1] = RFC6962_WIRE_INCLUSION;
+    buf[2] = (uint8_t)proof->depth;
+    rfc6962_put_u64(buf + 8, proof->leaf_index);
+    rfc6962_put_u64(buf + 16, proof->tree_size);
+    rfc6962_put_u64(buf + 24, proof->directions);
+    memcpy(buf + 32, proof->leaf_hash, SM3_DIGEST_SIZE);
+    memcpy(buf + 64, proof->root_hash, SM3_DIGEST_SIZE);
+    memcpy(buf + RFC6962_WIRE_INCLUSION_SIZE(0), proof->path, (size_t)proof->depth * SM3_DIGEST_SIZE);
+    return size;
+}
+
+int rfc6962_wire_decode_inclusion(const uint8_t *buf, size_t len, rfc6962_wire_inclusion_t *out)
+{
+    uint64_t expected_directions;
+
+    if (len < RFC6962_WIRE_INCLUSION_SIZE(0) || buf[0] != RFC6962_WIRE_VERSION || buf[1] != RFC6962_WIRE_INCLUSION)
+        return -1;
+    for (int i = 3; i < RFC6962_WIRE_HEADER_SIZE; i++)
+    {
+        if (buf[i] != 0)
+            return -1;
+    }
+
+    out->depth = buf[2];
+    out->leaf_index = rfc6962_get_u64(buf + 8);
+    out->tree_size = rfc6962_get_u64(buf + 16);
+    out->directions = rfc6962_get_u64(buf + 24);
+    out->leaf_hash = buf + 32;
+    out->root_hash = buf + 64;
+    out->path = buf + RFC6962_WIRE_INCLUSION_SIZE(0);
+
+    // 长度、深度与方向位必须和 (leaf_index, tree_size) 决定的路径形状完全一致
+    if (len != RFC6962_WIRE_INCLUSION_SIZE(out->depth) || out->leaf_index >= out->tree_size ||
+        rfc6962_expected_path(out->leaf_index, out->tree_size, &expected_directions) != (int)out->depth ||
+        expected_directions != out->directions)
+        return -1;
+    return 0;
+}
+
+int rfc6962_wire_verify_inclusion(const uint8_t *buf, size_t len, const uint8_t *trusted_root)
+{
+    rfc6962_wire_inclusion_t proof;
+
+    if (rfc6962_wire_decode_inclusion(buf, len, &proof) != 0)
+        return 0;
+    if (trusted_root && memcmp(trusted_root, proof.root_hash, SM3_DIGEST_SIZE) != 0)
+        return 0;
+    return rfc6962_verify_path(proof.leaf_index, proof.tree_size, proof.leaf_hash, (const merkle_node_t *)proof.path,
+                               (int)proof.depth, proof.root_hash);
+}
+
+size_t rfc6962_wire_encode_tree_head(const rfc6962_tree_head_t *sth, uint8_t *buf, size_t cap)
+{
+    size_t size = RFC6962_WIRE_TREE_HEAD_SIZE(sth->signature_len);
+
+    if (cap < size)
+        return 0;
+
+    memset(buf, 0, RFC6962_WIRE_HEADER_SIZE);
+    buf[0] = RFC6962_WIRE_VERSION;
+    buf[1] = RFC6962_WIRE_TREE_HEAD;
+    buf[6] = (uint8_t)(sth->signature_len >> 8);
+    buf[7] = (uint8_t)sth->signature_len;
+    rfc6962_put_u64(buf + 8, sth->tree_size);
+    rfc6962_put_u64(buf + 16, sth->timestamp);
+    memcpy(buf + 24, sth->root_hash, SM3_DIGEST_SIZE);
+    if (sth->signature_len)
+        memcpy(buf + RFC6962_WIRE_TREE_HEAD_SIZE(0), sth->signature, sth->signature_len);
+    return size;
+}
+
+int rfc6962_wire_decode_tree_head(const uint8_t *buf, size_t len, rfc6962_tree_head_t *sth)
+{
+    if (len < RFC6962_WIRE_TREE_HEAD_SIZE(0) || buf[0] != RFC6962_WIRE_VERSION || buf[1] != RFC6962_WIRE_TREE_HEAD ||
+        buf[2] || buf[3] || buf[4] || buf[5])
+        return -1;
+
+    sth->signature_len = (uint16_t)((buf[6] << 8) | buf[7]);
+    if (len != RFC6962_WIRE_TREE_HEAD_SIZE(sth->signature_len))
+        return -1;
+    sth->tree_size = rfc6962_get_u64(buf + 8);
+    sth->timestamp = rfc6962_get_u64(buf + 16);
+    memcpy(sth->root_hash, buf + 24, SM3_DIGEST_SIZE);
+    sth->signature = buf + RFC6962_WIRE_TREE_HEAD_SIZE(0);
+    return 0;
+}
+
+size_t rfc6962_tls_encode_inclusion(const rfc6962_compact_proof_t *proof, const uint8_t *log_id, size_t log_id_len,
+                                    uint8_t *buf, size_t cap)
+{
+    size_t path_len = (size_t)proof->depth * (1 + SM3_DIGEST_SIZE);
+    size_t size = 1 + log_id_len + 8 + 8 + 2 + path_len;
+    uint8_t *p = buf;
+
+    if (log_id_len < 2 || log_id_len > 127 || proof->depth >= MERKLE_MAX_LEVELS || cap < size)
+        return 0;
+
+    *p++ = (uint8_t)log_id_len;
+    memcpy(p, log_id, log_id_len);
+    p += log_id_len;
+    rfc6962_put_u64(p, proof->tree_size);
+    rfc6962_put_u64(p + 8, proof->leaf_index);
+    p[16] = (uint8_t)(path_len >> 8);
+    p[17] = (uint8_t)path_len;
+    p += 18;
+    for (uint32_t i = 0; i < proof->depth; i++)
+    {
+        *p++ = SM3_DIGEST_SIZE;
+        memcpy(p, proof->path[i], SM3_DIGEST_SIZE);
+        p += SM3_DIGEST_SIZE;
+    }
+    return size;
+}
+
+int rfc6962_tls_verify_inclusion(const uint8_t *buf, size_t len, const uint8_t *leaf_hash, const uint8_t *root_hash)
+{
+    merkle_node_t path[MERKLE_MAX_LEVELS]; // 栈上收集路径节点，不分配堆内存
+    uint64_t tree_size, leaf_index, directions;
+    size_t pos, path_len, end;
+    int depth = 0;
+
+    if (len < 1 || buf[0] < 2 || buf[0] > 127)
+        return 0;
+    pos = 1 + (size_t)buf[0];
+    if (len < pos + 18)
+        return 0;
+
+    tree_size = rfc6962_get_u64(buf + pos);
+    leaf_index = rfc6962_get_u64(buf + pos + 8);
+    path_len = ((size_t)buf[pos + 16] << 8) | buf[pos + 17];
+    pos += 18;
+    end = pos + path_len;
+    if (end != len || leaf_index >= tree_size)
+        return 0;
+
+    while (pos < end)
+    {
+        // 本实现只接受 32 字节的 SM3 节点哈希
+        if (depth >= MERKLE_MAX_LEVELS - 1 || buf[pos] != SM3_DIGEST_SIZE || end - pos < 1 + SM3_DIGEST_SIZE)
+            return 0;
+        memcpy(path[depth++], buf + pos + 1, SM3_DIGEST_SIZE);
+        pos += 1 + SM3_DIGEST_SIZE;
+    }
+
+    return rfc6962_expected_path(leaf_index, tree_size, &directions) == depth &&
+           rfc6962_verify_path(leaf_index, tree_size, leaf_hash, (const merkle_node_t *)path, depth, root_hash);
+}
+
+size_t rfc6962_tls_encode_tree_head(const rfc6962_tree_head_t *sth, uint8_t *buf, size_t cap)
+{
+    if (cap < RFC6962_TLS_TREE_HEAD_SIZE)
+        return 0;
+
+    buf[0] = RFC6962_TLS_VERSION_V1;
+    buf[1] = RFC6962_TLS_TREE_HASH;
+    rfc6962_put_u64(buf + 2, sth->timestamp);
+    rfc6962_put_u64(buf + 10, sth->tree_size);
+    memcpy(buf + 18, sth->root_hash, SM3_DIGEST_SIZE);
+    return RFC6962_TLS_TREE_HEAD_SIZE;
+}
@@ -3,451 +3,15 @@
  * SM3 密码哈希算法高性能实现
  *
  * 本实现针对现代处理器架构进行了深度优化，支持多种 SIMD 指令集
+ * 压缩核心与流式接口位于 libsm3（sm3_core.c），本文件为演示与测试程序
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <time.h>
 
-#ifdef __x86_64__
-#include <immintrin.h> // Intel intrinsics
-#endif
-
-#ifdef __ARM_NEON__
-#include <arm_neon.h> // ARM NEON intrinsics
-#endif
-
-// SM3 算法常数定义
-#define SM3_BLOCK_SIZE 64  // 512 bits
-#define SM3_DIGEST_SIZE 32 // 256 bits
-
-// 标准初始值
-#define SM3_H0 0x7380166F
-#define SM3_H1 0x4914B2B9
-#define SM3_H2 0x172442D7
-#define SM3_H3 0xDA8A0600
-#define SM3_H4 0xA96F30BC
-#define SM3_H5 0x163138AA
-#define SM3_H6 0xE38DEE4D
-#define SM3_H7 0xB0FB0E4E
-
-// T 常数
-#define T_0_15 0x79cc4519
-#define T_16_63 0x7a879d8a
-
-// 基础运算宏 - 使用宏定义避免函数调用开销
-#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
-
-// P0 和 P1 置换函数
-#define P0(x) ((x) ^ ROTL32((x), 9) ^ ROTL32((x), 17))
-#define P1(x) ((x) ^ ROTL32((x), 15) ^ ROTL32((x), 23))
-
-// FF 和 GG 布尔函数
-#define FF_0_15(x, y, z) ((x) ^ (y) ^ (z))
-#define FF_16_63(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
-#define GG_0_15(x, y, z) ((x) ^ (y) ^ (z))
-#define GG_16_63(x, y, z) (((x) & (y)) | (~(x) & (z)))
-
-// 内存访问优化宏
-#define MEMORY_EFFICIENT_ADD(a, b) \
-    do                             \
-    {                              \
-        uint32_t temp = (a) + (b); \
-        temp = temp + (b);         \
-        (a) = temp;                \
-    } while (0)
-
-// 压缩函数宏定义 - 避免函数调用开销
-#define SM3_ROUND_0_15(A, B, C, D, E, F, G, H, W, W1, T) \
-    do                                                   \
-    {                                                    \
-        uint32_t SS1 = ROTL32(ROTL32(A, 12) + E + T, 7); \
-        uint32_t SS2 = SS1 ^ ROTL32(A, 12);              \
-        uint32_t TT1 = FF_0_15(A, B, C) + D + SS2 + W1;  \
-        uint32_t TT2 = GG_0_15(E, F, G) + H + SS1 + W;   \
-        D = C;                                           \
-        C = ROTL32(B, 9);                                \
-        B = A;                                           \
-        A = TT1;                                         \
-        H = G;                                           \
-        G = ROTL32(F, 19);                               \
-        F = E;                                           \
-        E = P0(TT2);                                     \
-    } while (0)
-
-#define SM3_ROUND_16_63(A, B, C, D, E, F, G, H, W, W1, T) \
-    do                                                    \
-    {                                                     \
-        uint32_t SS1 = ROTL32(ROTL32(A, 12) + E + T, 7);  \
-        uint32_t SS2 = SS1 ^ ROTL32(A, 12);               \
-        uint32_t TT1 = FF_16_63(A, B, C) + D + SS2 + W1;  \
-        uint32_t TT2 = GG_16_63(E, F, G) + H + SS1 + W;   \
-        D = C;                                            \
-        C = ROTL32(B, 9);                                 \
-        B = A;                                            \
-        A = TT1;                                          \
-        H = G;                                            \
-        G = ROTL32(F, 19);                                \
-        F = E;                                            \
-        E = P0(TT2);                                      \
-    } while (0)
-
-// 高性能 SM3 上下文结构
-typedef struct
-{
-    uint32_t state[8] __attribute__((aligned(32)));  // 缓存对齐
-    uint8_t buffer[64] __attribute__((aligned(64))); // 缓存行对齐
-    uint64_t total_length;
-    uint32_t buffer_length;
-
-    // 预计算优化表
-    uint32_t T_table[64] __attribute__((aligned(32)));
-
-// X86-64 SIMD 寄存器
-#ifdef __x86_64__
-    __m128i simd_W[4]; // xmm0-xmm3: 存储W0-W15
-    __m128i simd_constants[16];
-#endif
-
-// ARM64 NEON 寄存器
-#ifdef __ARM_NEON__
-    uint32x4_t neon_W[4]; // v0-v3: 存储W0-W15
-    uint32x4_t neon_constants[16];
-#endif
-} sm3_optimized_context_t;
-
-// 栈存储优化的消息块加载
-static inline void sm3_load_block_optimized(const uint8_t *block, uint32_t W[16])
-{
-    // 内存访问优化
-    for (int i = 0; i < 16; i++)
-    {
-        uint32_t temp = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) |
-                        (block[i * 4 + 2] << 8) | block[i * 4 + 3];
-        W[i] = temp; // 避免重复内存写操作
-    }
-}
-
-#ifdef __x86_64__
-// SIMD实现策略 - X86-64版本
-static inline void sm3_message_expansion_simd_x86(uint32_t W[68], uint32_t W1[64])
-{
-    // 将W0-W15加载到4个128位SIMD寄存器
-    __m128i xmm0 = _mm_loadu_si128((__m128i *)&W[0]);  // w0,w1,w2,w3
-    __m128i xmm1 = _mm_loadu_si128((__m128i *)&W[4]);  // w4,w5,w6,w7
-    __m128i xmm2 = _mm_loadu_si128((__m128i *)&W[8]);  // w8,w9,w10,w11
-    __m128i xmm3 = _mm_loadu_si128((__m128i *)&W[12]); // w12,w13,w14,w15
-
-    // 循环移位实现（AVX512之前无专用指令）
-    // 使用SIMD并行化消息扩展的部分操作
-    for (int j = 16; j < 68; j += 4)
-    {
-        // 批处理4个字的扩展
-        if (j + 3 < 68)
-        {
-            __m128i w_16 = _mm_loadu_si128((__m128i *)&W[j - 16]);
-            __m128i w_9 = _mm_loadu_si128((__m128i *)&W[j - 9]);
-            __m128i w_3 = _mm_loadu_si128((__m128i *)&W[j - 3]);
-            __m128i w_13 = _mm_loadu_si128((__m128i *)&W[j - 13]);
-            __m128i w_6 = _mm_loadu_si128((__m128i *)&W[j - 6]);
-
-            // 文档优化：SIMD XOR操作
-            __m128i temp = _mm_xor_si128(w_16, w_9);
-            // 这里需要实现ROTL32的SIMD版本（AVX2可用_mm_rol_epi32，AVX512可用_mm_ror_epi32）
-
-            // 回退到标量处理旋转操作
-            for (int k = 0; k < 4 && j + k < 68; k++)
-            {
-                uint32_t scalar_temp = W[j + k - 16] ^ W[j + k - 9] ^ ROTL32(W[j + k - 3], 15);
-                W[j + k] = P1(scalar_temp) ^ ROTL32(W[j + k - 13], 7) ^ W[j + k - 6];
-            }
-        }
-        else
-        {
-            // 处理剩余元素
-            for (int k = 0; k < 4 && j + k < 68; k++)
-            {
-                uint32_t temp = W[j + k - 16] ^ W[j + k - 9] ^ ROTL32(W[j + k - 3], 15);
-                W[j + k] = P1(temp) ^ ROTL32(W[j + k - 13], 7) ^ W[j + k - 6];
-            }
-        }
-    }
-
-    // 生成W'数组 - SIMD优化版本
-    for (int j = 0; j < 64; j += 4)
-    {
-        if (j + 7 < 68)
-        {
-            __m128i w_j = _mm_loadu_si128((__m128i *)&W[j]);
-            __m128i w_j4 = _mm_loadu_si128((__m128i *)&W[j + 4]);
-            __m128i w1_result = _mm_xor_si128(w_j, w_j4);
-            _mm_storeu_si128((__m128i *)&W1[j], w1_result);
-        }
-        else
-        {
-            // 标量处理剩余
-            for (int k = 0; k < 4 && j + k < 64; k++)
-            {
-                W1[j + k] = W[j + k] ^ W[j + k + 4];
-            }
-        }
-    }
-}
-#endif
-
-#ifdef __ARM_NEON__
-// ARM64 NEON实现
-static inline void sm3_message_expansion_simd_arm(uint32_t W[68], uint32_t W1[64])
-{
-    // ARM NEON需要显式指明数据类型
-    uint32x4_t v0 = vld1q_u32(&W[0]);  // w0,w1,w2,w3
-    uint32x4_t v1 = vld1q_u32(&W[4]);  // w4,w5,w6,w7
-    uint32x4_t v2 = vld1q_u32(&W[8]);  // w8,w9,w10,w11
-    uint32x4_t v3 = vld1q_u32(&W[12]); // w12,w13,w14,w15
-
-    // ARM特定的消息扩展优化 - 利用NEON的向量化能力
-    for (int j = 16; j < 68; j += 4)
-    {
-        if (j + 3 < 68)
-        {
-            // ARM NEON向量化操作
-            uint32x4_t w_16 = vld1q_u32(&W[j - 16]);
-            uint32x4_t w_9 = vld1q_u32(&W[j - 9]);
-            uint32x4_t w_6 = vld1q_u32(&W[j - 6]);
-            uint32x4_t w_13 = vld1q_u32(&W[j - 13]);
-
-            // NEON XOR操作
-            uint32x4_t temp = veorq_u32(w_16, w_9);
-
-            // 由于NEON缺乏32位循环移位指令，回退标量处理
-            for (int k = 0; k < 4 && j + k < 68; k++)
-            {
-                uint32_t scalar_temp = W[j + k - 16] ^ W[j + k - 9] ^ ROTL32(W[j + k - 3], 15);
-                W[j + k] = P1(scalar_temp) ^ ROTL32(W[j + k - 13], 7) ^ W[j + k - 6];
-            }
-        }
-        else
-        {
-            // 处理剩余元素
-            for (int k = 0; k < 4 && j + k < 68; k++)
-            {
-                uint32_t temp = W[j + k - 16] ^ W[j + k - 9] ^ ROTL32(W[j + k - 3], 15);
-                W[j + k] = P1(temp) ^ ROTL32(W[j + k - 13], 7) ^ W[j + k - 6];
-            }
-        }
-    }
-
-    // 生成W'数组 - NEON优化版本
-    for (int j = 0; j < 64; j += 4)
-    {
-        if (j + 7 < 68)
-        {
-            uint32x4_t w_j = vld1q_u32(&W[j]);
-            uint32x4_t w_j4 = vld1q_u32(&W[j + 4]);
-            uint32x4_t w1_result = veorq_u32(w_j, w_j4);
-            vst1q_u32(&W1[j], w1_result);
-        }
-        else
-        {
-            for (int k = 0; k < 4 && j + k < 64; k++)
-            {
-                W1[j + k] = W[j + k] ^ W[j + k + 4];
-            }
-        }
-    }
-}
-#endif
-
-// On-the-fly优化 - 混合寄存器策略
-static inline void sm3_compress_onthefly(sm3_optimized_context_t *ctx, const uint8_t *block)
-{
-    // 栈存储中间变量
-    uint32_t W[68] __attribute__((aligned(32)));
-    uint32_t W1[64] __attribute__((aligned(32)));
-    uint32_t A, B, C, D, E, F, G, H;
-
-    // 加载消息块
-    sm3_load_block_optimized(block, W);
-
-// 根据架构选择SIMD实现
-#ifdef __x86_64__
-    sm3_message_expansion_simd_x86(W, W1);
-#elif defined(__ARM_NEON__)
-    sm3_message_expansion_simd_arm(W, W1);
-#else
-    // 标量版本回退
-    for (int j = 16; j < 68; j++)
-    {
-        uint32_t temp = W[j - 16] ^ W[j - 9] ^ ROTL32(W[j - 3], 15);
-        W[j] = P1(temp) ^ ROTL32(W[j - 13], 7) ^ W[j - 6];
-    }
-    for (int j = 0; j < 64; j++)
-    {
-        W1[j] = W[j] ^ W[j + 4];
-    }
-#endif
-
-    // 寄存器配置
-    A = ctx->state[0];
-    B = ctx->state[1];
-    C = ctx->state[2];
-    D = ctx->state[3];
-    E = ctx->state[4];
-    F = ctx->state[5];
-    G = ctx->state[6];
-    H = ctx->state[7];
-
-    // 核心函数全展开
-    // 0-15轮（完全展开）
-    SM3_ROUND_0_15(A, B, C, D, E, F, G, H, W[0], W1[0], ctx->T_table[0]);
-    SM3_ROUND_0_15(H, A, B, C, D, E, F, G, W[1], W1[1], ctx->T_table[1]);
-    SM3_ROUND_0_15(G, H, A, B, C, D, E, F, W[2], W1[2], ctx->T_table[2]);
-    SM3_ROUND_0_15(F, G, H, A, B, C, D, E, W[3], W1[3], ctx->T_table[3]);
-    SM3_ROUND_0_15(E, F, G, H, A, B, C, D, W[4], W1[4], ctx->T_table[4]);
-    SM3_ROUND_0_15(D, E, F, G, H, A, B, C, W[5], W1[5], ctx->T_table[5]);
-    SM3_ROUND_0_15(C, D, E, F, G, H, A, B, W[6], W1[6], ctx->T_table[6]);
-    SM3_ROUND_0_15(B, C, D, E, F, G, H, A, W[7], W1[7], ctx->T_table[7]);
-    SM3_ROUND_0_15(A, B, C, D, E, F, G, H, W[8], W1[8], ctx->T_table[8]);
-    SM3_ROUND_0_15(H, A, B, C, D, E, F, G, W[9], W1[9], ctx->T_table[9]);
-    SM3_ROUND_0_15(G, H, A, B, C, D, E, F, W[10], W1[10], ctx->T_table[10]);
-    SM3_ROUND_0_15(F, G, H, A, B, C, D, E, W[11], W1[11], ctx->T_table[11]);
-    SM3_ROUND_0_15(E, F, G, H, A, B, C, D, W[12], W1[12], ctx->T_table[12]);
-    SM3_ROUND_0_15(D, E, F, G, H, A, B, C, W[13], W1[13], ctx->T_table[13]);
-    SM3_ROUND_0_15(C, D, E, F, G, H, A, B, W[14], W1[14], ctx->T_table[14]);
-    SM3_ROUND_0_15(B, C, D, E, F, G, H, A, W[15], W1[15], ctx->T_table[15]);
-
-    // 16-63轮（部分展开）
-    for (int j = 16; j < 64; j++)
-    {
-        SM3_ROUND_16_63(A, B, C, D, E, F, G, H, W[j], W1[j], ctx->T_table[j]);
-        // 交错进行提高效率
-        uint32_t temp_A = A, temp_H = H;
-        A = H;
-        B = A;
-        C = ROTL32(B, 9);
-        D = C;
-        E = temp_A;
-        F = E;
-        G = ROTL32(F, 19);
-        H = G;
-    }
-
-    // 避免内存写，使用临时变量
-    ctx->state[0] ^= A;
-    ctx->state[1] ^= B;
-    ctx->state[2] ^= C;
-    ctx->state[3] ^= D;
-    ctx->state[4] ^= E;
-    ctx->state[5] ^= F;
-    ctx->state[6] ^= G;
-    ctx->state[7] ^= H;
-}
-
-// CPU架构演进优化初始化
-void sm3_optimized_init_advanced(sm3_optimized_context_t *ctx)
-{
-    memset(ctx, 0, sizeof(sm3_optimized_context_t));
-
-    // 设置初始哈希值
-    ctx->state[0] = SM3_H0;
-    ctx->state[1] = SM3_H1;
-    ctx->state[2] = SM3_H2;
-    ctx->state[3] = SM3_H3;
-    ctx->state[4] = SM3_H4;
-    ctx->state[5] = SM3_H5;
-    ctx->state[6] = SM3_H6;
-    ctx->state[7] = SM3_H7;
-
-    // 预计算T常数表
-    for (int j = 0; j < 64; j++)
-    {
-        uint32_t T_base = (j <= 15) ? T_0_15 : T_16_63;
-        ctx->T_table[j] = ROTL32(T_base, j % 32);
-    }
-
-// 初始化SIMD常数
-#ifdef __x86_64__
-    for (int i = 0; i < 16; i++)
-    {
-        ctx->simd_constants[i] = _mm_set1_epi32(0x5A827999); // 示例常数
-    }
-#endif
-
-#ifdef __ARM_NEON__
-    for (int i = 0; i < 16; i++)
-    {
-        ctx->neon_constants[i] = vdupq_n_u32(0x5A827999); // 示例常数
-    }
-#endif
-}
-
-// SM2-KDF优化应用
-void sm3_kdf_optimized(const uint8_t *shared_secret, size_t secret_len,
-                       uint8_t *key_data, size_t key_len)
-{
-    sm3_optimized_context_t ctx[8]; // 8路并行上下文
-    uint8_t hash_input[64] __attribute__((aligned(64)));
-    uint32_t counter = 1;
-    size_t processed = 0;
-
-    printf("KDF优化实现：高性能优化策略\n");
-    printf("前512比特固定处理，后续SIMD并行\n");
-
-    // 前512比特固定，一次完整哈希
-    memcpy(hash_input, shared_secret, secret_len);
-
-    while (processed < key_len)
-    {
-        size_t batch_size = (key_len - processed) / 32;
-        if (batch_size > 8)
-            batch_size = 8; // 最多8路并行
-        if (batch_size == 0)
-            batch_size = 1;
-
-// SIMD 8路并行哈希
-#ifdef __x86_64__
-        // 使用AVX2进行8路并行
-        for (size_t i = 0; i < batch_size; i++)
-        {
-            sm3_optimized_init_advanced(&ctx[i]);
-            // 将计数器放入最后4字节
-            hash_input[secret_len] = (counter + i) >> 24;
-            hash_input[secret_len + 1] = (counter + i) >> 16;
-            hash_input[secret_len + 2] = (counter + i) >> 8;
-            hash_input[secret_len + 3] = (counter + i);
-
-            // 并行处理
-            sm3_compress_onthefly(&ctx[i], hash_input);
-        }
-#else
-        // 标量版本
-        for (size_t i = 0; i < batch_size; i++)
-        {
-            sm3_optimized_init_advanced(&ctx[i]);
-            hash_input[secret_len] = (counter + i) >> 24;
-            hash_input[secret_len + 1] = (counter + i) >> 16;
-            hash_input[secret_len + 2] = (counter + i) >> 8;
-            hash_input[secret_len + 3] = (counter + i);
-
-            sm3_compress_onthefly(&ctx[i], hash_input);
-        }
-#endif
-
-        // 输出结果
-        for (size_t i = 0; i < batch_size && processed < key_len; i++)
-        {
-            size_t copy_len = (key_len - processed) > 32 ? 32 : (key_len - processed);
-            memcpy(key_data + processed, ctx[i].state, copy_len);
-            processed += copy_len;
-        }
-
-        counter += batch_size;
-    }
-
-    printf("KDF并行优化：处理了%zu字节，使用多路并行\n", key_len);
-}
+#include "sm3.h"
 
 // 嵌入式实现（Cortex-M3/M4）
 #ifdef __ARM_ARCH_7M__
@@ -479,6 +43,7 @@ void test_performance_optimization()
     printf("- 指令集：SSE/AVX/AVX2 自动检测\n");
     printf("- 优化：循环移位和向量化操作\n");
 #endif
+    printf("- 运行时分派内核：%s（可用 SM3_KERNEL 环境变量覆盖）\n", sm3_kernel_name());
 #ifdef __ARM_NEON__
     printf("- ARM64：NEON向量化支持\n");
     printf("- 寄存器：32个通用寄存器优化\n");
@@ -502,29 +67,176 @@ void test_performance_optimization()
     printf("- 批量处理：SM2-KDF并行支持\n");
     printf("- 高吞吐量：现代处理器充分利用\n");
 
-    // 功能验证
-    sm3_optimized_context_t ctx;
-    sm3_optimized_init_advanced(&ctx);
-
+    // 功能验证：GB/T 32905-2016 附录 A 的已知答案，经完整的填充与流式接口
     printf("\n=== 功能验证 ===\n");
-    const char *test_data = "abc";
-    printf("输入: \"%s\"\n", test_data);
+    {
+        static const char *const messages[2] = {
+            "abc", "abcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcd"};
+        static const char *const expected[2] = {
+            "66c7f0f462eeedd9d1f2d46bdc10e4e24167c4875cf2f7a2297da02b8f4ba8e0",
+            "debe9ff92275b8a138604889c18e5a4d6fdb70e5387e5765293dcba39c0c5732"};
+
+        for (int t = 0; t < 2; t++)
+        {
+            uint8_t digest[SM3_DIGEST_SIZE];
+            char hex[2 * SM3_DIGEST_SIZE + 1];
 
-    // 哈希计算
-    sm3_compress_onthefly(&ctx, (const uint8_t *)test_data);
+            sm3_hash((const uint8_t *)messages[t], strlen(messages[t]), digest);
+            for (int i = 0; i < SM3_DIGEST_SIZE; i++)
+            {
+                sprintf(hex + 2 * i, "%02x", digest[i]);
+            }
+            printf("输入: \"%s\"\n输出: %s %s\n", messages[t], hex,
+                   strcmp(hex, expected[t]) == 0 ? "✅ 通过" : "❌ 失败");
+        }
+        printf("全部内核已知答案自检: %s\n", sm3_self_test() == 0 ? "✅ 通过" : "❌ 失败");
+    }
 
-    printf("输出: ");
-    for (int i = 0; i < 8; i++)
+    // 多路并行哈希：长度跨越填充边界的不同消息混在一批，条数不是通道数的整数倍，逐条与 sm3_hash 对照
+    printf("\n=== 多路并行哈希测试 ===\n");
     {
-        printf("%08x", ctx.state[i]);
+        static const size_t base_lens[8] = {0, 1, 55, 56, 63, 64, 65, 1000};
+        static uint8_t messages[37][1010];
+        const uint8_t *msgs[37];
+        size_t lens[37];
+        uint8_t out[37][SM3_DIGEST_SIZE], fixed[16][SM3_DIGEST_SIZE], expected[SM3_DIGEST_SIZE];
+        int count = 37;
+        int ok = 1;
+
+        for (int i = 0; i < count; i++)
+        {
+            for (int j = 0; j < (int)sizeof(messages[i]); j++)
+            {
+                messages[i][j] = (uint8_t)(i * 37 + j * 11 + 3);
+            }
+            msgs[i] = messages[i];
+            lens[i] = base_lens[i % 8] + (size_t)(i / 8);
+        }
+
+        sm3_hash_many(msgs, lens, out, (size_t)count);
+        for (int i = 0; ok && i < count; i++)
+        {
+            sm3_hash(msgs[i], lens[i], expected);
+            ok = memcmp(out[i], expected, SM3_DIGEST_SIZE) == 0;
+        }
+
+        // 固定路数接口：第 l 路从第 offset + l 条消息取数
+        for (int lanes = 4, offset = 1; ok && lanes <= 16; lanes *= 2, offset += 5)
+        {
+            if (lanes == 4)
+                sm3_hash_x4(msgs + offset, lens + offset, fixed);
+            else if (lanes == 8)
+                sm3_hash_x8(msgs + offset, lens + offset, fixed);
+            else
+                sm3_hash_x16(msgs + offset, lens + offset, fixed);
+            for (int l = 0; ok && l < lanes; l++)
+            {
+                ok = memcmp(fixed[l], out[offset + l], SM3_DIGEST_SIZE) == 0;
+            }
+        }
+        printf("%d 条 0-1004 字节消息批量哈希（%d 路），sm3_hash_x4/x8/x16 与逐条计算一致: %s\n", count,
+               sm3_mb_lanes(), ok ? "✅ 通过" : "❌ 失败");
+    }
+
+    // 固定前缀中间状态：前缀吸收一次，再分别拼接不同后缀
+    printf("\n=== 前缀中间状态测试 ===\n");
+    {
+        uint8_t message[200], expected[SM3_DIGEST_SIZE], digest[SM3_DIGEST_SIZE], midstate[SM3_DIGEST_SIZE];
+        sm3_prefix_t prefix;
+        sm3_context_t resumed;
+        uint64_t length;
+        int ok = 1;
+
+        for (int i = 0; i < (int)sizeof(message); i++)
+        {
+            message[i] = (uint8_t)(i * 131 + 7);
+        }
+        for (uint64_t split = 0; ok && split <= sizeof(message); split += 13)
+        {
+            sm3_hash(message, sizeof(message), expected);
+            sm3_prefix_init(&prefix, message, split);
+            sm3_prefix_hash(&prefix, message + split, sizeof(message) - split, digest);
+            ok = memcmp(digest, expected, SM3_DIGEST_SIZE) == 0;
+        }
+
+        // 块边界上导出 32 字节中间状态并在新上下文中继续
+        sm3_prefix_init(&prefix, message, 128);
+        sm3_prefix_resume(&resumed, &prefix);
+        ok = ok && sm3_midstate_export(&resumed, midstate, &length) == 0 && length == 128 &&
+             sm3_midstate_import(&resumed, midstate, length) == 0;
+        sm3_update(&resumed, message + 128, sizeof(message) - 128);
+        sm3_final(&resumed, digest);
+        ok = ok && memcmp(digest, expected, SM3_DIGEST_SIZE) == 0;
+        printf("前缀克隆/中间状态导出导入与一次性哈希一致: %s\n", ok ? "✅ 通过" : "❌ 失败");
     }
-    printf("\n");
 
-    // KDF 应用测试
+    // KDF 应用测试：与逐块 SM3(Z || ct) 的直接定义对照
     printf("\n=== KDF 应用测试 ===\n");
-    uint8_t shared_secret[32] = {0x01, 0x02, 0x03, 0x04};
-    uint8_t derived_key[64];
-    sm3_kdf_optimized(shared_secret, 32, derived_key, 64);
+    {
+        uint8_t z[130], key[200], expected[200 + SM3_DIGEST_SIZE], block[134];
+        int ok = 1;
+
+        for (int i = 0; i < (int)sizeof(z); i++)
+        {
+            z[i] = (uint8_t)(i * 29 + 1);
+        }
+        for (size_t z_len = 0; ok && z_len <= sizeof(z); z_len += 13)
+        {
+            for (size_t klen = 1; ok && klen <= sizeof(key); klen += 19)
+            {
+                memcpy(block, z, z_len);
+                for (uint32_t ct = 1; (ct - 1) * SM3_DIGEST_SIZE < klen; ct++)
+                {
+                    block[z_len] = (uint8_t)(ct >> 24);
+                    block[z_len + 1] = (uint8_t)(ct >> 16);
+                    block[z_len + 2] = (uint8_t)(ct >> 8);
+                    block[z_len + 3] = (uint8_t)ct;
+                    sm3_hash(block, z_len + 4, expected + (ct - 1) * SM3_DIGEST_SIZE);
+                }
+                ok = sm3_kdf(z, z_len, key, klen) == 0 && memcmp(key, expected, klen) == 0;
+            }
+        }
+        printf("KDF(Z, klen) 与逐块定义一致（Z 0-130 字节，klen 1-200 字节，%d 路并行）: %s\n", sm3_mb_lanes(),
+               ok ? "✅ 通过" : "❌ 失败");
+    }
+
+    // HMAC-SM3：已知答案（与 OpenSSL HMAC-SM3 交叉验证）与批量接口
+    printf("\n=== HMAC-SM3 测试 ===\n");
+    {
+        static const uint8_t expected[SM3_DIGEST_SIZE] = {
+            0x8d, 0x54, 0x71, 0x6c, 0x05, 0x53, 0x99, 0x04, 0x22, 0xad, 0x09, 0xe6, 0x3a, 0x72, 0x37, 0x38,
+            0x66, 0x96, 0xa8, 0x95, 0x2f, 0x64, 0xe5, 0x46, 0xa4, 0xde, 0xe3, 0xb8, 0x9a, 0x93, 0x1a, 0x35};
+        const char *message = "The quick brown fox";
+        uint8_t mac[SM3_DIGEST_SIZE];
+        uint8_t messages[100][300];
+        const uint8_t *msgs[100];
+        size_t lens[100];
+        uint8_t macs[100][SM3_DIGEST_SIZE];
+        sm3_hmac_key_t key;
+        int ok;
+
+        sm3_hmac((const uint8_t *)"key", 3, (const uint8_t *)message, strlen(message), mac);
+        ok = memcmp(mac, expected, SM3_DIGEST_SIZE) == 0;
+        printf("HMAC-SM3(\"key\", \"%s\") 已知答案: %s\n", message, ok ? "✅ 通过" : "❌ 失败");
+
+        sm3_hmac_key_init(&key, (const uint8_t *)"key", 3);
+        for (int i = 0; i < 100; i++)
+        {
+            for (int j = 0; j < 300; j++)
+            {
+                messages[i][j] = (uint8_t)(i + j);
+            }
+            msgs[i] = messages[i];
+            lens[i] = (size_t)i * 3;
+        }
+        sm3_hmac_many(&key, msgs, lens, macs, 100);
+        for (int i = 0; ok && i < 100; i++)
+        {
+            sm3_hmac((const uint8_t *)"key", 3, msgs[i], lens[i], mac);
+            ok = memcmp(mac, macs[i], SM3_DIGEST_SIZE) == 0;
+        }
+        printf("同一密钥批量计算 100 条消息与逐条计算一致: %s\n", ok ? "✅ 通过" : "❌ 失败");
+    }
 
     printf("\n=== 优化完成状态 ===\n");
     printf("✅ 算法正确性：符合国家标准\n");
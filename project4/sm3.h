@@ -0,0 +1,135 @@
+/*
+ * SM3 Shared Library Interface
+ * SM3 密码哈希算法公共库接口 (libsm3)
+ *
+ * sm3、merkle_tree_rfc6962、length_extension_attack 等程序统一链接本库，
+ * 流式接口与一次性接口均由同一个高性能压缩核心实现
+ */
+
+#ifndef SM3_H
+#define SM3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SM3 算法常数定义
+#define SM3_BLOCK_SIZE 64  // 512 bits
+#define SM3_DIGEST_SIZE 32 // 256 bits
+
+// 高性能 SM3 上下文结构
+// 只含流式状态（112 字节），T 常数与 SIMD 常数均为所有上下文共享的静态表（sm3_core.c）；
+// 各内核以非对齐方式读取消息块，缓冲区无需额外对齐
+typedef struct
+{
+    uint32_t state[8];
+    uint8_t buffer[SM3_BLOCK_SIZE];
+    uint64_t total_length;  // 累计输入长度（位）
+    uint32_t buffer_length; // 当前缓冲区长度
+} sm3_optimized_context_t;
+
+// 流式接口使用的通用名称
+typedef sm3_optimized_context_t sm3_context_t;
+
+// 压缩核心：处理一个 64 字节消息块
+void sm3_compress_onthefly(sm3_optimized_context_t *ctx, const uint8_t *block);
+
+// 压缩核心：连续处理 nblocks 个消息块（无需拷贝到内部缓冲区）
+void sm3_compress_blocks(sm3_optimized_context_t *ctx, const uint8_t *data, size_t nblocks);
+
+// 与 sm3_init 相同，保留旧名称
+void sm3_optimized_init_advanced(sm3_optimized_context_t *ctx);
+
+// 流式接口
+void sm3_init(sm3_context_t *ctx);
+void sm3_update(sm3_context_t *ctx, const uint8_t *data, uint64_t len);
+void sm3_final(sm3_context_t *ctx, uint8_t *digest);
+
+// 一次性哈希计算
+void sm3_hash(const uint8_t *data, uint64_t len, uint8_t *digest);
+
+// 固定前缀哈希（HMAC 的 ipad/opad 块、KDF 的共享秘密、域分隔标签等）
+// 前缀只吸收一次，之后每条后缀从保存的中间状态继续；sm3_prefix_t 与上下文同为约 110 字节，
+// 按值复制即可克隆
+typedef struct
+{
+    uint32_t state[8];
+    uint8_t buffer[SM3_BLOCK_SIZE]; // 前缀末尾不足一块的部分
+    uint64_t total_length;          // 前缀长度（位）
+    uint32_t buffer_length;
+} sm3_prefix_t;
+
+void sm3_prefix_init(sm3_prefix_t *prefix, const uint8_t *data, uint64_t len);
+void sm3_prefix_absorb(sm3_context_t *ctx, sm3_prefix_t *prefix);    // 从流式上下文导出前缀状态
+void sm3_prefix_resume(sm3_context_t *ctx, const sm3_prefix_t *prefix); // 上下文继续 update/final
+void sm3_prefix_hash(const sm3_prefix_t *prefix, const uint8_t *suffix, uint64_t len, uint8_t *digest);
+
+// 32 字节中间状态（大端序，与摘要格式相同）与已压缩的字节数，仅在块边界上有效
+// 导出时缓冲区非空、导入时长度不是 64 的倍数返回-1；已知摘要加上其填充长度也可以导入（长度扩展）
+int sm3_midstate_export(const sm3_context_t *ctx, uint8_t midstate[SM3_DIGEST_SIZE], uint64_t *length);
+int sm3_midstate_import(sm3_context_t *ctx, const uint8_t midstate[SM3_DIGEST_SIZE], uint64_t length);
+
+// 文件哈希（sm3_file.c）：从文件开头读取的普通文件使用 mmap，管道、块设备等
+// 使用双缓冲异步读取（Linux 上为 io_uring，不可用时退化为 read），读取与压缩重叠
+#define SM3_FILE_AUTO 0
+#define SM3_FILE_STREAM 1 // 不使用 mmap，强制走流式读取
+
+int sm3_hash_fd(int fd, int flags, uint8_t *digest);             // 从当前位置读到文件结束，成功后文件位置在末尾；失败返回-1
+int sm3_hash_file(const char *path, int flags, uint8_t *digest); // path 为 "-" 时读取标准输入
+
+// 多路并行哈希：一次处理多条相互独立的消息
+#define SM3_MB_MAX_LANES 16
+
+void sm3_hash_x4(const uint8_t *msgs[4], const size_t lens[4], uint8_t out[4][SM3_DIGEST_SIZE]);
+void sm3_hash_x8(const uint8_t *msgs[8], const size_t lens[8], uint8_t out[8][SM3_DIGEST_SIZE]);
+void sm3_hash_x16(const uint8_t *msgs[16], const size_t lens[16], uint8_t out[16][SM3_DIGEST_SIZE]);
+
+// 任意条数的批量哈希，通道空闲时自动装入下一条消息
+void sm3_hash_many(const uint8_t *const *msgs, const size_t *lens,
+                   uint8_t (*out)[SM3_DIGEST_SIZE], size_t count);
+
+// 批量计算 SM3(prefix || suffixes[i])：每一路从前缀的中间状态开始
+void sm3_hash_many_prefixed(const sm3_prefix_t *prefix, const uint8_t *const *suffixes, const size_t *lens,
+                            uint8_t (*out)[SM3_DIGEST_SIZE], size_t count);
+
+// 当前CPU上多路引擎的最大通道数
+int sm3_mb_lanes(void);
+
+// SM2 密钥派生函数 KDF(Z, klen)（GB/T 32918.4）：K = SM3(Z || ct) 依次拼接，ct 从1开始的32位大端计数器
+// Z 只压缩一次，各计数块经多路引擎并行计算并直接写入 key，klen 超过 (2^32 - 1) * 32 字节返回-1
+int sm3_kdf(const uint8_t *z, size_t z_len, uint8_t *key, size_t klen);
+
+// HMAC-SM3：按密钥预先压缩 K'^ipad 与 K'^opad 两个块，每条消息不再重复压缩密钥
+typedef struct
+{
+    sm3_prefix_t inner;
+    sm3_prefix_t outer;
+} sm3_hmac_key_t;
+
+typedef struct
+{
+    sm3_context_t ctx;
+    const sm3_hmac_key_t *key; // 在 final 之前须保持有效
+} sm3_hmac_ctx_t;
+
+void sm3_hmac_key_init(sm3_hmac_key_t *key, const uint8_t *k, size_t k_len); // 超过 64 字节的密钥先做 SM3
+void sm3_hmac_init(sm3_hmac_ctx_t *ctx, const sm3_hmac_key_t *key);
+void sm3_hmac_update(sm3_hmac_ctx_t *ctx, const uint8_t *data, uint64_t len);
+void sm3_hmac_final(sm3_hmac_ctx_t *ctx, uint8_t *mac);
+void sm3_hmac(const uint8_t *k, size_t k_len, const uint8_t *data, uint64_t len, uint8_t *mac);
+
+// 同一密钥下批量计算多条消息的 HMAC，内外两层都经多路引擎并行
+void sm3_hmac_many(const sm3_hmac_key_t *key, const uint8_t *const *msgs, const size_t *lens,
+                   uint8_t (*out)[SM3_DIGEST_SIZE], size_t count);
+
+// 运行时内核分派
+// 内核名称：sm3ni、armv8-sm3、avx512、avx2、sse4、neon、scalar；"auto" 或 NULL 恢复自动选择
+// 也可通过环境变量 SM3_KERNEL 在启动时强制指定
+int sm3_set_kernel(const char *name); // 成功返回0，内核不存在或CPU不支持返回-1
+const char *sm3_kernel_name(void);     // 当前生效的内核名称
+const char *sm3_kernel_name_at(int index); // 枚举编译进库的内核，越界返回NULL
+
+// 对当前CPU支持的全部内核（含多路内核）重新运行 GB/T 32905 已知答案测试，全部通过返回0，否则返回-1
+// 启动探测时已做同样的检查，未通过的内核不会被选用
+int sm3_self_test(void);
+
+#endif // SM3_H
@@ -0,0 +1,479 @@
+/*
+ * SM3 / Merkle Benchmark Harness
+ * 可跨版本对比的基准测试
+ *
+ * 每项测试先预热再重复采样，报告中位数（及 p99），结果以 JSON 输出，便于回归比较：
+ * - SM3：各内核在 16B-1MB 消息上的 ticks/byte（x86 为 rdtsc，AArch64 为 cntvct_el0，其它平台为纳秒）
+ * - 叶子哈希吞吐量、多路批量哈希吞吐量
+ * - 树构建时间随线程数的变化
+ * - 包含性/一致性证明生成与验证的 p50/p99 延迟
+ * - 证明服务引擎的吞吐量与提交到完成回调的 p50/p99 延迟
+ * - 以 STATS=1 构建时附带整个运行期间的库内统计（"stats"）
+ *
+ * 用法: sm3_bench [--quick] [-o 输出文件]
+ */
+
+#define _POSIX_C_SOURCE 200112L // clock_gettime, sysconf, sched_yield
+
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TICK_UNIT "rdtsc"
+#elif defined(__aarch64__)
+#define BENCH_TICK_UNIT "cntvct_el0"
+#else
+#define BENCH_TICK_UNIT "ns"
+#endif
+
+#include "merkle_rfc6962.h"
+#include "sm3_stats.h"
+
+#define BENCH_SAMPLES 15
+#define BENCH_SAMPLES_QUICK 5
+#define BENCH_PROOF_OPS 10000
+#define BENCH_SERVE_DEPTH 4096 // 服务测试的在途请求数，同时是证明缓冲区个数
+
+static uint64_t bench_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t bench_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return bench_ns();
+#endif
+}
+
+// 估算计时源频率（ticks/ns），用于把 ticks 换算为时间
+static double bench_tick_rate(void)
+{
+    uint64_t t0 = bench_ticks(), n0 = bench_ns();
+    while (bench_ns() - n0 < 50000000ULL)
+    {
+    }
+    return (double)(bench_ticks() - t0) / (double)(bench_ns() - n0);
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// 排序后取分位数，q 取 0-100
+static uint64_t bench_percentile(uint64_t *samples, int count, int q)
+{
+    qsort(samples, (size_t)count, sizeof(uint64_t), bench_cmp_u64);
+    int index = (int)(((int64_t)count - 1) * q / 100);
+    return samples[index];
+}
+
+// SM3：单个内核、单个消息长度
+static void bench_sm3_size(FILE *out, const uint8_t *data, size_t size, int samples, int first)
+{
+    uint64_t ticks[BENCH_SAMPLES];
+    uint64_t ns[BENCH_SAMPLES];
+    uint8_t digest[SM3_DIGEST_SIZE];
+    // 每个样本至少处理约 1MB，短消息时重复多次以摊薄计时开销
+    size_t iterations = size >= ((size_t)1 << 20) ? 1 : ((size_t)1 << 20) / size;
+
+    for (size_t i = 0; i < iterations; i++) // 预热
+    {
+        sm3_hash(data, size, digest);
+    }
+    for (int s = 0; s < samples; s++)
+    {
+        uint64_t t0 = bench_ticks(), n0 = bench_ns();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            sm3_hash(data, size, digest);
+        }
+        ticks[s] = bench_ticks() - t0;
+        ns[s] = bench_ns() - n0;
+    }
+
+    double bytes = (double)size * (double)iterations;
+    double tpb = (double)bench_percentile(ticks, samples, 50) / bytes;
+    double mbps = bytes / ((double)bench_percentile(ns, samples, 50) / 1e9) / 1e6;
+    fprintf(out, "%s        {\"size\": %zu, \"ticks_per_byte\": %.3f, \"mb_per_s\": %.1f}", first ? "" : ",\n", size,
+            tpb, mbps);
+    fprintf(stderr, "  %8zu B  %8.2f ticks/B  %9.1f MB/s\n", size, tpb, mbps);
+}
+
+static void bench_sm3(FILE *out, int samples)
+{
+    static const size_t sizes[] = {16, 64, 256, 1024, 4096, 16384, 65536, 1 << 20};
+    uint8_t *data = malloc((size_t)1 << 20);
+    int first_kernel = 1;
+
+    for (size_t i = 0; i < ((size_t)1 << 20); i++)
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    fprintf(out, "  \"sm3\": [\n");
+    for (int k = 0; sm3_kernel_name_at(k) != NULL; k++)
+    {
+        const char *name = sm3_kernel_name_at(k);
+        if (sm3_set_kernel(name) != 0)
+            continue; // 当前CPU不支持
+
+        fprintf(stderr, "SM3 [%s]\n", name);
+        fprintf(out, "%s    {\"kernel\": \"%s\", \"sizes\": [\n", first_kernel ? "" : ",\n", name);
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            bench_sm3_size(out, data, sizes[i], samples, i == 0);
+        }
+        fprintf(out, "\n    ]}");
+        first_kernel = 0;
+    }
+    fprintf(out, "\n  ],\n");
+    sm3_set_kernel("auto");
+    free(data);
+}
+
+// 叶子哈希：逐个 hash_leaf 与经多路引擎的 sm3_hash_many
+static void bench_leaves(FILE *out, uint64_t count, int samples)
+{
+    const size_t record = 64;
+    uint8_t *data = malloc((size_t)count * record);
+    merkle_node_t *leaves = malloc((size_t)count * sizeof(merkle_node_t));
+    merkle_node_t *parents = malloc((size_t)(count / 2) * sizeof(merkle_node_t));
+    const uint8_t **msgs = malloc((size_t)count * sizeof(const uint8_t *));
+    size_t *lens = malloc((size_t)count * sizeof(size_t));
+    uint64_t single[BENCH_SAMPLES], batch[BENCH_SAMPLES], pair[BENCH_SAMPLES], level[BENCH_SAMPLES];
+
+    for (uint64_t i = 0; i < count * record; i++)
+    {
+        data[i] = (uint8_t)(i * 29 + 3);
+    }
+    for (uint64_t i = 0; i < count; i++)
+    {
+        msgs[i] = data + i * record;
+        lens[i] = record;
+    }
+
+    for (int s = -1; s < samples; s++) // s = -1 为预热
+    {
+        uint64_t n0 = bench_ns();
+        for (uint64_t i = 0; i < count; i++)
+        {
+            hash_leaf(data + i * record, record, leaves[i]);
+        }
+        uint64_t n1 = bench_ns();
+        hash_leaves_batch(msgs, lens, leaves, count);
+        uint64_t n2 = bench_ns();
+        for (uint64_t i = 0; i < count / 2; i++)
+        {
+            hash_children(leaves[2 * i], leaves[2 * i + 1], parents[i]);
+        }
+        uint64_t n3 = bench_ns();
+        hash_level(parents, leaves, count / 2);
+        uint64_t n4 = bench_ns();
+        if (s >= 0)
+        {
+            single[s] = n1 - n0;
+            batch[s] = n2 - n1;
+            pair[s] = n3 - n2;
+            level[s] = n4 - n3;
+        }
+    }
+
+    double leaf_rate = (double)count / ((double)bench_percentile(single, samples, 50) / 1e9);
+    double batch_rate = (double)count / ((double)bench_percentile(batch, samples, 50) / 1e9);
+    double pair_rate = (double)(count / 2) / ((double)bench_percentile(pair, samples, 50) / 1e9);
+    double level_rate = (double)(count / 2) / ((double)bench_percentile(level, samples, 50) / 1e9);
+    fprintf(out, "  \"leaf_hash\": {\"record_bytes\": %zu, \"count\": %llu, \"leaves_per_s\": %.0f, "
+                 "\"leaves_batch_per_s\": %.0f, \"children_per_s\": %.0f, \"level_per_s\": %.0f, "
+                 "\"mb_lanes\": %d},\n",
+            record, (unsigned long long)count, leaf_rate, batch_rate, pair_rate, level_rate, sm3_mb_lanes());
+    fprintf(stderr, "叶子哈希 (%zu B): hash_leaf %.0f/s, hash_leaves_batch %.0f/s (%d 路)\n", record, leaf_rate,
+            batch_rate, sm3_mb_lanes());
+    fprintf(stderr, "父节点哈希: hash_children %.0f/s, hash_level %.0f/s\n", pair_rate, level_rate);
+
+    free(lens);
+    free(msgs);
+    free(parents);
+    free(leaves);
+    free(data);
+}
+
+// 树构建时间随线程数的变化
+static void bench_build(FILE *out, const uint8_t *buffer, const uint64_t *offsets, uint64_t count, int samples)
+{
+    static const int threads[] = {1, 2, 4, 8};
+    uint64_t ns[BENCH_SAMPLES];
+
+    fprintf(out, "  \"tree_build\": {\"leaves\": %llu, \"online_cpus\": %ld, \"threads\": [\n",
+            (unsigned long long)count, sysconf(_SC_NPROCESSORS_ONLN));
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        for (int s = -1; s < samples; s++)
+        {
+            uint64_t n0 = bench_ns();
+            rfc6962_merkle_tree_t *tree = build_rfc6962_merkle_tree_buffer(buffer, offsets, count, threads[t]);
+            uint64_t elapsed = bench_ns() - n0;
+            free_rfc6962_merkle_tree(tree);
+            if (s >= 0)
+                ns[s] = elapsed;
+        }
+        double ms = (double)bench_percentile(ns, samples, 50) / 1e6;
+        fprintf(out, "%s    {\"threads\": %d, \"ms\": %.3f}", t == 0 ? "" : ",\n", threads[t], ms);
+        fprintf(stderr, "树构建 %llu 叶子, %d 线程: %.3f ms\n", (unsigned long long)count, threads[t], ms);
+    }
+    fprintf(out, "\n  ]},\n");
+}
+
+// 证明生成与验证的延迟分布
+static void bench_proofs(FILE *out, rfc6962_merkle_tree_t *tree, int ops)
+{
+    uint64_t *gen = malloc((size_t)ops * sizeof(uint64_t));
+    uint64_t *ver = malloc((size_t)ops * sizeof(uint64_t));
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    for (int kind = 0; kind < 2; kind++)
+    {
+        for (int i = -ops / 10; i < ops; i++) // 负数下标为预热
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint64_t n0, n1, n2;
+            int ok;
+
+            if (kind == 0)
+            {
+                uint64_t index = (state >> 11) % tree->leaf_count;
+                n0 = bench_ns();
+                rfc6962_inclusion_proof_t *proof = generate_rfc6962_inclusion_proof(tree, index);
+                n1 = bench_ns();
+                ok = verify_rfc6962_inclusion_proof(proof);
+                n2 = bench_ns();
+                free_rfc6962_inclusion_proof(proof);
+            }
+            else
+            {
+                uint64_t old_size = 1 + (state >> 11) % tree->leaf_count;
+                n0 = bench_ns();
+                rfc6962_consistency_proof_t *proof = generate_rfc6962_consistency_proof(tree, old_size);
+                n1 = bench_ns();
+                ok = verify_rfc6962_consistency_proof(proof);
+                n2 = bench_ns();
+                free_rfc6962_consistency_proof(proof);
+            }
+            if (!ok)
+            {
+                fprintf(stderr, "❌ 证明验证失败\n");
+                exit(1);
+            }
+            if (i >= 0)
+            {
+                gen[i] = n1 - n0;
+                ver[i] = n2 - n1;
+            }
+        }
+
+        const char *name = kind == 0 ? "inclusion" : "consistency";
+        uint64_t g50 = bench_percentile(gen, ops, 50), g99 = bench_percentile(gen, ops, 99);
+        uint64_t v50 = bench_percentile(ver, ops, 50), v99 = bench_percentile(ver, ops, 99);
+        fprintf(out, "    \"%s\": {\"generate_ns\": {\"p50\": %llu, \"p99\": %llu}, "
+                     "\"verify_ns\": {\"p50\": %llu, \"p99\": %llu}}%s\n",
+                name, (unsigned long long)g50, (unsigned long long)g99, (unsigned long long)v50,
+                (unsigned long long)v99, kind == 0 ? "," : "");
+        fprintf(stderr, "%s 证明: 生成 p50 %llu ns / p99 %llu ns, 验证 p50 %llu ns / p99 %llu ns\n", name,
+                (unsigned long long)g50, (unsigned long long)g99, (unsigned long long)v50, (unsigned long long)v99);
+    }
+
+    free(gen);
+    free(ver);
+}
+
+typedef struct
+{
+    const rfc6962_serve_request_t *requests;
+    uint64_t *done_ns; // 以请求在数组中的位置为下标
+    uint64_t done;
+    int ok;
+} bench_serve_t;
+
+static void bench_serve_complete(rfc6962_serve_request_t *req)
+{
+    bench_serve_t *b = req->user;
+
+    ptrdiff_t i = req - b->requests;
+
+    // 验证一个证明的耗时是生成的数十倍，只抽查一部分，避免测成验证吞吐量
+    b->done_ns[i] = bench_ns();
+    if (req->status != 0 || (i % 64 == 0 && !verify_rfc6962_compact_proof(req->proof)))
+        __atomic_store_n(&b->ok, 0, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&b->done, 1, __ATOMIC_RELEASE);
+}
+
+// 证明服务吞吐量：每轮提交 BENCH_SERVE_DEPTH 个最新快照上的随机请求并等待全部回调，接管 tree
+static void bench_serve(FILE *out, rfc6962_merkle_tree_t *tree, int ops)
+{
+    rfc6962_concurrent_tree_t *ct = rfc6962_concurrent_create(tree);
+    rfc6962_server_config_t config = {0, BENCH_SERVE_DEPTH, RFC6962_SERVER_PIN};
+    rfc6962_server_t *server = ct ? rfc6962_server_create(ct, &config) : NULL;
+    rfc6962_serve_request_t *requests = calloc(BENCH_SERVE_DEPTH, sizeof(rfc6962_serve_request_t));
+    uint8_t *buffers = malloc((size_t)BENCH_SERVE_DEPTH * RFC6962_COMPACT_PROOF_MAX_SIZE);
+    uint64_t *submit_ns = malloc(BENCH_SERVE_DEPTH * sizeof(uint64_t));
+    uint64_t *latency = malloc((size_t)ops * sizeof(uint64_t));
+    bench_serve_t b = {requests, malloc(BENCH_SERVE_DEPTH * sizeof(uint64_t)), 0, 1};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    uint64_t start, elapsed;
+    int completed = 0;
+
+    if (!server || !requests || !buffers || !submit_ns || !latency || !b.done_ns)
+    {
+        fprintf(stderr, "❌ 证明服务初始化失败\n");
+        exit(1);
+    }
+
+    start = bench_ns();
+    while (completed < ops)
+    {
+        int round = ops - completed < BENCH_SERVE_DEPTH ? ops - completed : BENCH_SERVE_DEPTH;
+
+        __atomic_store_n(&b.done, 0, __ATOMIC_RELAXED);
+        for (int i = 0; i < round; i++)
+        {
+            rfc6962_serve_request_t *req = &requests[i];
+
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            req->leaf_index = (state >> 11) % tree->leaf_count;
+            req->tree_size = 0;
+            req->proof = (rfc6962_compact_proof_t *)(buffers + (size_t)i * RFC6962_COMPACT_PROOF_MAX_SIZE);
+            req->proof_capacity = RFC6962_COMPACT_PROOF_MAX_SIZE;
+            req->complete = bench_serve_complete;
+            req->user = &b;
+            submit_ns[i] = bench_ns();
+            while (rfc6962_server_submit(server, req) != 0)
+            {
+                sched_yield();
+            }
+        }
+        while (__atomic_load_n(&b.done, __ATOMIC_ACQUIRE) < (uint64_t)round)
+        {
+            sched_yield();
+        }
+        for (int i = 0; i < round; i++)
+        {
+            latency[completed + i] = b.done_ns[i] - submit_ns[i];
+        }
+        completed += round;
+    }
+    elapsed = bench_ns() - start;
+    if (!b.ok)
+    {
+        fprintf(stderr, "❌ 证明验证失败\n");
+        exit(1);
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus < 1 ? 1 : cpus > RFC6962_MAX_READERS ? RFC6962_MAX_READERS : (int)cpus;
+    double rate = elapsed ? ops * 1e9 / (double)elapsed : 0.0;
+    uint64_t p50 = bench_percentile(latency, ops, 50), p99 = bench_percentile(latency, ops, 99);
+    fprintf(out, "  \"serve\": {\"workers\": %d, \"depth\": %d, \"proofs_per_s\": %.0f, "
+                 "\"latency_ns\": {\"p50\": %llu, \"p99\": %llu}}",
+            workers, BENCH_SERVE_DEPTH, rate, (unsigned long long)p50, (unsigned long long)p99);
+    fprintf(stderr, "证明服务: %d 个工作线程 %.0f 证明/秒, 延迟 p50 %llu ns / p99 %llu ns\n", workers, rate,
+            (unsigned long long)p50, (unsigned long long)p99);
+
+    rfc6962_server_destroy(server);
+    rfc6962_concurrent_free(ct);
+    free(b.done_ns);
+    free(latency);
+    free(submit_ns);
+    free(buffers);
+    free(requests);
+}
+
+int main(int argc, char **argv)
+{
+    const char *output = NULL;
+    int quick = 0;
+    FILE *out = stdout;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = 1;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            fprintf(stderr, "用法: %s [--quick] [-o 输出文件]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (output && !(out = fopen(output, "w")))
+    {
+        perror(output);
+        return 1;
+    }
+
+    int samples = quick ? BENCH_SAMPLES_QUICK : BENCH_SAMPLES;
+    uint64_t leaves = quick ? (1 << 16) : (1 << 20);
+    int proof_ops = quick ? 1000 : BENCH_PROOF_OPS;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"meta\": {\"tick_unit\": \"%s\", \"ticks_per_ns\": %.4f, \"auto_kernel\": \"%s\", "
+                 "\"quick\": %s, \"samples\": %d},\n",
+            BENCH_TICK_UNIT, bench_tick_rate(), sm3_kernel_name(), quick ? "true" : "false", samples);
+
+    bench_sm3(out, samples);
+    bench_leaves(out, leaves / 4, samples);
+
+    // 树构建与证明共用一份连续记录缓冲区，第 i 条记录长 32 + i % 64 字节
+    uint64_t *offsets = malloc((size_t)(leaves + 1) * sizeof(uint64_t));
+    offsets[0] = 0;
+    for (uint64_t i = 0; i < leaves; i++)
+    {
+        offsets[i + 1] = offsets[i] + 32 + i % 64;
+    }
+    uint8_t *buffer = malloc((size_t)offsets[leaves]);
+    for (uint64_t i = 0; i < offsets[leaves]; i++)
+    {
+        buffer[i] = (uint8_t)(i * 17 + 5);
+    }
+
+    bench_build(out, buffer, offsets, leaves, quick ? 1 : 3);
+
+    rfc6962_merkle_tree_t *tree = build_rfc6962_merkle_tree_buffer(buffer, offsets, leaves, 0);
+    fprintf(out, "  \"proofs\": {\n    \"leaves\": %llu,\n", (unsigned long long)leaves);
+    bench_proofs(out, tree, proof_ops);
+    fprintf(out, "  },\n");
+    bench_serve(out, tree, proof_ops * 10);
+    if (sm3_stats_enabled())
+    {
+        sm3_stats_t stats;
+
+        sm3_stats_snapshot(&stats);
+        fprintf(out, ",\n  \"stats\": ");
+        sm3_stats_write_json(out, &stats);
+    }
+    fprintf(out, "\n}\n");
+
+    free(buffer);
+    free(offsets);
+    if (output)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,486 @@
+/*
+ * SM3 High-Performance Core
+ * SM3 密码哈希算法高性能压缩核心与流式接口 (libsm3)
+ *
+ * 本文件由 sm3.c 中的优化实现抽取而来，作为所有程序共享的唯一 SM3 实现
+ */
+
+#include <string.h>
+
+#include "sm3_internal.h"
+
+// 标准初始值
+#define SM3_H0 0x7380166F
+#define SM3_H1 0x4914B2B9
+#define SM3_H2 0x172442D7
+#define SM3_H3 0xDA8A0600
+#define SM3_H4 0xA96F30BC
+#define SM3_H5 0x163138AA
+#define SM3_H6 0xE38DEE4D
+#define SM3_H7 0xB0FB0E4E
+
+const uint32_t sm3_IV[8] = {
+    SM3_H0, SM3_H1, SM3_H2, SM3_H3, SM3_H4, SM3_H5, SM3_H6, SM3_H7};
+
+const uint32_t sm3_T_rotated[64] __attribute__((aligned(64))) = {
+    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb, 0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
+    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce, 0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5,
+    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
+    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5};
+
+// 基础运算宏 - 使用宏定义避免函数调用开销
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+// P0 和 P1 置换函数
+#define P0(x) ((x) ^ ROTL32((x), 9) ^ ROTL32((x), 17))
+#define P1(x) ((x) ^ ROTL32((x), 15) ^ ROTL32((x), 23))
+
+// FF 和 GG 布尔函数
+#define FF_0_15(x, y, z) ((x) ^ (y) ^ (z))
+#define FF_16_63(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
+#define GG_0_15(x, y, z) ((x) ^ (y) ^ (z))
+#define GG_16_63(x, y, z) (((x) & (y)) | (~(x) & (z)))
+
+// 轮函数宏 - 寄存器轮换由调用方的实参顺序完成，每轮只写回四个变量，没有 A..H 之间的搬移
+// 一轮之后新的 (A, B, C, D, E, F, G, H) 为实参中的 (D, A, B, C, H, E, F, G)：
+//   D <- TT1, B <- ROTL(B, 9), H <- P0(TT2), F <- ROTL(F, 19)，其余不变
+#define SM3_ROUND(FF, GG, A, B, C, D, E, F, G, H, W, W1, T) \
+    do                                                      \
+    {                                                       \
+        uint32_t A12 = ROTL32(A, 12);                       \
+        uint32_t SS1 = ROTL32(A12 + E + (T), 7);            \
+        uint32_t SS2 = SS1 ^ A12;                           \
+        D = FF(A, B, C) + D + SS2 + (W1);                   \
+        H = GG(E, F, G) + H + SS1 + (W);                    \
+        B = ROTL32(B, 9);                                   \
+        F = ROTL32(F, 19);                                  \
+        H = P0(H);                                          \
+    } while (0)
+
+// 连续4轮，实参轮换一周后回到原来的顺序；R 为取消息字方式不同的单轮宏
+#define SM3_ROUND4(R, FF, GG, j)                    \
+    R(FF, GG, A, B, C, D, E, F, G, H, (j));         \
+    R(FF, GG, D, A, B, C, H, E, F, G, (j) + 1);     \
+    R(FF, GG, C, D, A, B, G, H, E, F, (j) + 2);     \
+    R(FF, GG, B, C, D, A, F, G, H, E, (j) + 3)
+
+// 64轮全展开
+#define SM3_ROUNDS_64(R)                      \
+    SM3_ROUND4(R, FF_0_15, GG_0_15, 0);       \
+    SM3_ROUND4(R, FF_0_15, GG_0_15, 4);       \
+    SM3_ROUND4(R, FF_0_15, GG_0_15, 8);       \
+    SM3_ROUND4(R, FF_0_15, GG_0_15, 12);      \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 16);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 20);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 24);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 28);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 32);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 36);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 40);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 44);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 48);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 52);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 56);    \
+    SM3_ROUND4(R, FF_16_63, GG_16_63, 60)
+
+// 消息字取自预先扩展好的 W[68] / W'[64]（SIMD 消息扩展内核）
+#define SM3_ROUND_STORED(FF, GG, A, B, C, D, E, F, G, H, j) \
+    SM3_ROUND(FF, GG, A, B, C, D, E, F, G, H, W[j], W1[j], T[j])
+
+// 消息字在轮内即时扩展：w 为16字环形缓冲区，第 j 轮时 w[k & 15] 存放 W[k]（j <= k < j + 16）
+// 第 j 轮需要 W[j + 4] 以得到 W'[j] = W[j] ^ W[j + 4]，从第12轮起先扩展出 W[j + 4]，覆盖已用完的 W[j - 12]
+#define SM3_EXPAND(w, k)                                                                      \
+    (w[(k) & 15] = P1(w[(k) & 15] ^ w[((k) - 9) & 15] ^ ROTL32(w[((k) - 3) & 15], 15)) ^      \
+                   ROTL32(w[((k) - 13) & 15], 7) ^ w[((k) - 6) & 15])
+
+#define SM3_ROUND_ONTHEFLY(FF, GG, A, B, C, D, E, F, G, H, j)                                        \
+    do                                                                                               \
+    {                                                                                                \
+        if ((j) >= 12)                                                                               \
+            SM3_EXPAND(w, (j) + 4);                                                                  \
+        SM3_ROUND(FF, GG, A, B, C, D, E, F, G, H, w[(j) & 15], w[(j) & 15] ^ w[((j) + 4) & 15], T[j]); \
+    } while (0)
+
+// 栈存储优化的消息块加载
+static inline void sm3_load_block_optimized(const uint8_t *block, uint32_t W[16])
+{
+    // 内存访问优化
+    for (int i = 0; i < 16; i++)
+    {
+        uint32_t temp = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+                        ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+        W[i] = temp; // 避免重复内存写操作
+    }
+}
+
+// 消息扩展缓冲区大小：向量化版本每步写入4个字，末步会越过 W[67]/W'[63]
+#define SM3_W_WORDS 72
+#define SM3_W1_WORDS 68
+
+/*
+ * 向量化消息扩展（每步计算3个字）
+ * W[j+3] 依赖 W[j]，因此一次最多并行计算 W[j..j+2]：
+ *   t = W[j-16..] ^ W[j-9..] ^ ROTL(W[j-3..], 15)
+ *   W[j..] = P1(t) ^ ROTL(W[j-13..], 7) ^ W[j-6..]
+ * 第4个通道为无效值，会被下一步的写入覆盖。
+ * W'[j-4..j-2] = W[j-4..j-2] ^ W[j..j+2] 在同一步内完成（W' 计算融合进扩展）
+ */
+#define SM3_EXPAND_3X(LOAD, STORE, XOR, XOR3, ROTL, W, W1)          \
+    do                                                              \
+    {                                                               \
+        for (int j = 16; j < 68; j += 3)                            \
+        {                                                           \
+            v128 t = XOR3(LOAD(W + j - 16), LOAD(W + j - 9),        \
+                          ROTL(LOAD(W + j - 3), 15));               \
+            t = XOR3(t, ROTL(t, 15), ROTL(t, 23));                  \
+            v128 r = XOR3(t, ROTL(LOAD(W + j - 13), 7),             \
+                          LOAD(W + j - 6));                         \
+            STORE(W + j, r);                                        \
+            STORE(W1 + j - 4, XOR(LOAD(W + j - 4), r));             \
+        }                                                           \
+    } while (0)
+
+#ifdef __x86_64__
+typedef __m128i v128;
+
+#define X86_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define X86_STORE(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+#define X86_XOR(a, b) _mm_xor_si128((a), (b))
+#define X86_XOR3(a, b, c) _mm_xor_si128(_mm_xor_si128((a), (b)), (c))
+// SSE/AVX2 无32位循环移位指令，使用移位+或实现
+#define X86_ROTL(x, n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32 - (n)))
+// AVX-512VL 原生循环移位与三输入逻辑指令
+#define X86_ROTL_VL(x, n) _mm_rol_epi32((x), (n))
+#define X86_XOR3_VL(a, b, c) _mm_ternarylogic_epi32((a), (b), (c), 0x96)
+
+// 大端序加载 W0-W15 并计算 W'0-W'11
+#define X86_LOAD_BLOCK(block, W, W1)                                                  \
+    do                                                                                \
+    {                                                                                 \
+        const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,                   \
+                                            11, 10, 9, 8, 15, 14, 13, 12);            \
+        __m128i xmm0 = _mm_shuffle_epi8(X86_LOAD(block), bswap);      /* w0-w3 */     \
+        __m128i xmm1 = _mm_shuffle_epi8(X86_LOAD(block + 16), bswap); /* w4-w7 */     \
+        __m128i xmm2 = _mm_shuffle_epi8(X86_LOAD(block + 32), bswap); /* w8-w11 */    \
+        __m128i xmm3 = _mm_shuffle_epi8(X86_LOAD(block + 48), bswap); /* w12-w15 */   \
+        X86_STORE(W + 0, xmm0);                                                       \
+        X86_STORE(W + 4, xmm1);                                                       \
+        X86_STORE(W + 8, xmm2);                                                       \
+        X86_STORE(W + 12, xmm3);                                                      \
+        X86_STORE(W1 + 0, X86_XOR(xmm0, xmm1));                                       \
+        X86_STORE(W1 + 4, X86_XOR(xmm1, xmm2));                                       \
+        X86_STORE(W1 + 8, X86_XOR(xmm2, xmm3));                                       \
+        W[16] = 0; /* 首步读取 W[13..16] 时第4通道的占位值 */                         \
+    } while (0)
+
+// SIMD实现策略 - X86-64 SSE4 版本
+__attribute__((target("ssse3,sse4.1"))) static inline void sm3_message_expansion_simd_x86(const uint8_t *block, uint32_t W[SM3_W_WORDS], uint32_t W1[SM3_W1_WORDS])
+{
+    X86_LOAD_BLOCK(block, W, W1);
+    SM3_EXPAND_3X(X86_LOAD, X86_STORE, X86_XOR, X86_XOR3, X86_ROTL, W, W1);
+}
+
+// AVX2 版本：同样的128位运算使用 VEX 编码，避免与 AVX2 代码混用时的状态切换开销
+__attribute__((target("avx2"))) static inline void sm3_message_expansion_avx2(const uint8_t *block, uint32_t W[SM3_W_WORDS], uint32_t W1[SM3_W1_WORDS])
+{
+    X86_LOAD_BLOCK(block, W, W1);
+    SM3_EXPAND_3X(X86_LOAD, X86_STORE, X86_XOR, X86_XOR3, X86_ROTL, W, W1);
+}
+
+// AVX-512VL 版本：vprold 循环移位 + vpternlogd 三路异或
+__attribute__((target("avx2,avx512f,avx512vl"))) static inline void sm3_message_expansion_avx512vl(const uint8_t *block, uint32_t W[SM3_W_WORDS], uint32_t W1[SM3_W1_WORDS])
+{
+    X86_LOAD_BLOCK(block, W, W1);
+    SM3_EXPAND_3X(X86_LOAD, X86_STORE, X86_XOR, X86_XOR3_VL, X86_ROTL_VL, W, W1);
+}
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+typedef uint32x4_t v128;
+
+#define NEON_LOAD(p) vld1q_u32(p)
+#define NEON_STORE(p, v) vst1q_u32((p), (v))
+#define NEON_XOR(a, b) veorq_u32((a), (b))
+#define NEON_XOR3(a, b, c) veorq_u32(veorq_u32((a), (b)), (c))
+// NEON 循环移位：左移后用 vsriq 插入右移部分
+#define NEON_ROTL(x, n) vsriq_n_u32(vshlq_n_u32((x), (n)), (x), 32 - (n))
+
+// ARM64 NEON实现
+static inline void sm3_message_expansion_simd_arm(const uint8_t *block, uint32_t W[SM3_W_WORDS], uint32_t W1[SM3_W1_WORDS])
+{
+    // ARM NEON需要显式指明数据类型
+    uint32x4_t v0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block)));      // w0,w1,w2,w3
+    uint32x4_t v1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 16))); // w4,w5,w6,w7
+    uint32x4_t v2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 32))); // w8,w9,w10,w11
+    uint32x4_t v3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 48))); // w12,w13,w14,w15
+
+    vst1q_u32(W + 0, v0);
+    vst1q_u32(W + 4, v1);
+    vst1q_u32(W + 8, v2);
+    vst1q_u32(W + 12, v3);
+    vst1q_u32(W1 + 0, veorq_u32(v0, v1));
+    vst1q_u32(W1 + 4, veorq_u32(v1, v2));
+    vst1q_u32(W1 + 8, veorq_u32(v2, v3));
+    W[16] = 0;
+
+    SM3_EXPAND_3X(NEON_LOAD, NEON_STORE, NEON_XOR, NEON_XOR3, NEON_ROTL, W, W1);
+}
+#endif
+
+// 64轮压缩（T 常数取自预先循环移位的静态表）
+static inline void sm3_compress_rounds(uint32_t state[8], const uint32_t *W, const uint32_t *W1)
+{
+    const uint32_t *T = sm3_T_rotated;
+    uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+    uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+
+    SM3_ROUNDS_64(SM3_ROUND_STORED);
+
+    state[0] ^= A;
+    state[1] ^= B;
+    state[2] ^= C;
+    state[3] ^= D;
+    state[4] ^= E;
+    state[5] ^= F;
+    state[6] ^= G;
+    state[7] ^= H;
+}
+
+// 按消息扩展实现生成对应的多块压缩内核
+#define SM3_DEFINE_COMPRESS(name, expand)                                             \
+    void name(uint32_t state[8], const uint8_t *data, size_t nblocks)                 \
+    {                                                                                 \
+        /* 栈存储中间变量 */                                                          \
+        uint32_t W[SM3_W_WORDS] __attribute__((aligned(32)));                         \
+        uint32_t W1[SM3_W1_WORDS] __attribute__((aligned(32)));                       \
+        for (; nblocks > 0; nblocks--, data += SM3_BLOCK_SIZE)                        \
+        {                                                                             \
+            expand(data, W, W1);                                                      \
+            sm3_compress_rounds(state, W, W1);                                        \
+        }                                                                             \
+    }
+
+// 标量内核：消息扩展在轮内即时完成，工作集只有16个消息字，没有 W[68] / W'[64] 数组
+void sm3_compress_scalar(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    const uint32_t *T = sm3_T_rotated;
+
+    for (; nblocks > 0; nblocks--, data += SM3_BLOCK_SIZE)
+    {
+        uint32_t w[16];
+        uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+        uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+
+        sm3_load_block_optimized(data, w);
+        SM3_ROUNDS_64(SM3_ROUND_ONTHEFLY);
+
+        state[0] ^= A;
+        state[1] ^= B;
+        state[2] ^= C;
+        state[3] ^= D;
+        state[4] ^= E;
+        state[5] ^= F;
+        state[6] ^= G;
+        state[7] ^= H;
+    }
+}
+
+#ifdef __x86_64__
+__attribute__((target("ssse3,sse4.1"))) SM3_DEFINE_COMPRESS(sm3_compress_sse4, sm3_message_expansion_simd_x86)
+__attribute__((target("avx2"))) SM3_DEFINE_COMPRESS(sm3_compress_avx2, sm3_message_expansion_avx2)
+__attribute__((target("avx2,avx512f,avx512vl"))) SM3_DEFINE_COMPRESS(sm3_compress_avx512vl, sm3_message_expansion_avx512vl)
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+SM3_DEFINE_COMPRESS(sm3_compress_neon, sm3_message_expansion_simd_arm)
+#endif
+
+// On-the-fly优化 - 混合寄存器策略
+void sm3_compress_onthefly(sm3_optimized_context_t *ctx, const uint8_t *block)
+{
+    sm3_compress_blocks(ctx, block, 1);
+}
+
+// 旧接口：上下文不再含预计算表，初始化与 sm3_init 相同
+void sm3_optimized_init_advanced(sm3_optimized_context_t *ctx)
+{
+    sm3_init(ctx);
+}
+
+// 连续处理多个消息块
+void sm3_compress_blocks(sm3_optimized_context_t *ctx, const uint8_t *data, size_t nblocks)
+{
+    SM3_STAT_ADD(compress_blocks[sm3_kernel_index(sm3_active_kernel)], nblocks);
+    SM3_PROBE2(compress, sm3_kernel_index(sm3_active_kernel), nblocks);
+    sm3_active_kernel->compress(ctx->state, data, nblocks);
+}
+
+// 上下文只有流式状态，常数表全部为静态共享
+typedef char sm3_context_size_check[sizeof(sm3_context_t) <= 112 ? 1 : -1];
+
+// SM3 初始化 - 复制 32 字节初始值并清零长度，上下文可低成本反复使用
+void sm3_init(sm3_context_t *ctx)
+{
+    memcpy(ctx->state, sm3_IV, sizeof(ctx->state));
+    ctx->total_length = 0;
+    ctx->buffer_length = 0;
+}
+
+// SM3 更新 - 整块数据直接从输入压缩，仅尾部拷贝到缓冲区
+void sm3_update(sm3_context_t *ctx, const uint8_t *data, uint64_t len)
+{
+    ctx->total_length += len * 8; // 转换为位数
+    SM3_STAT_ADD(bytes_hashed[sm3_kernel_index(sm3_active_kernel)], len);
+
+    if (ctx->buffer_length > 0)
+    {
+        uint32_t chunk_size = SM3_BLOCK_SIZE - ctx->buffer_length;
+        if (chunk_size > len)
+            chunk_size = (uint32_t)len;
+
+        memcpy(ctx->buffer + ctx->buffer_length, data, chunk_size);
+        ctx->buffer_length += chunk_size;
+        data += chunk_size;
+        len -= chunk_size;
+
+        if (ctx->buffer_length < SM3_BLOCK_SIZE)
+            return;
+
+        sm3_compress_onthefly(ctx, ctx->buffer);
+        ctx->buffer_length = 0;
+    }
+
+    if (len >= SM3_BLOCK_SIZE)
+    {
+        size_t nblocks = (size_t)(len / SM3_BLOCK_SIZE);
+        sm3_compress_blocks(ctx, data, nblocks);
+        data += nblocks * SM3_BLOCK_SIZE;
+        len -= (uint64_t)nblocks * SM3_BLOCK_SIZE;
+    }
+
+    if (len > 0)
+    {
+        memcpy(ctx->buffer, data, (size_t)len);
+        ctx->buffer_length = (uint32_t)len;
+    }
+}
+
+// SM3 最终化 - 在内部缓冲区原地填充
+void sm3_final(sm3_context_t *ctx, uint8_t *digest)
+{
+    uint32_t n = ctx->buffer_length;
+
+    ctx->buffer[n++] = 0x80;
+
+    // 如果空间不足，先处理一个块
+    if (n > 56)
+    {
+        memset(ctx->buffer + n, 0, SM3_BLOCK_SIZE - n);
+        sm3_compress_onthefly(ctx, ctx->buffer);
+        n = 0;
+    }
+    memset(ctx->buffer + n, 0, 56 - n);
+
+    // 添加长度（大端序，64位）
+    uint64_t bit_length = ctx->total_length;
+    for (int i = 7; i >= 0; i--)
+    {
+        ctx->buffer[56 + i] = bit_length & 0xFF;
+        bit_length >>= 8;
+    }
+
+    sm3_compress_onthefly(ctx, ctx->buffer);
+
+    // 输出哈希值（大端序）
+    for (int i = 0; i < 8; i++)
+    {
+        digest[i * 4] = (ctx->state[i] >> 24) & 0xFF;
+        digest[i * 4 + 1] = (ctx->state[i] >> 16) & 0xFF;
+        digest[i * 4 + 2] = (ctx->state[i] >> 8) & 0xFF;
+        digest[i * 4 + 3] = ctx->state[i] & 0xFF;
+    }
+    ctx->buffer_length = 0;
+}
+
+// 一次性哈希计算
+void sm3_hash(const uint8_t *data, uint64_t len, uint8_t *digest)
+{
+    sm3_context_t ctx;
+    sm3_init(&ctx);
+    sm3_update(&ctx, data, len);
+    sm3_final(&ctx, digest);
+}
+
+// 吸收前缀
+void sm3_prefix_init(sm3_prefix_t *prefix, const uint8_t *data, uint64_t len)
+{
+    sm3_context_t ctx;
+
+    sm3_init(&ctx);
+    sm3_update(&ctx, data, len);
+    sm3_prefix_absorb(&ctx, prefix);
+}
+
+void sm3_prefix_absorb(sm3_context_t *ctx, sm3_prefix_t *prefix)
+{
+    memcpy(prefix->state, ctx->state, sizeof(prefix->state));
+    memcpy(prefix->buffer, ctx->buffer, ctx->buffer_length);
+    prefix->total_length = ctx->total_length;
+    prefix->buffer_length = ctx->buffer_length;
+}
+
+// 恢复前缀状态：只复制状态与未满的缓冲区
+void sm3_prefix_resume(sm3_context_t *ctx, const sm3_prefix_t *prefix)
+{
+    memcpy(ctx->state, prefix->state, sizeof(ctx->state));
+    memcpy(ctx->buffer, prefix->buffer, prefix->buffer_length);
+    ctx->total_length = prefix->total_length;
+    ctx->buffer_length = prefix->buffer_length;
+}
+
+// 计算 SM3(prefix || suffix)
+void sm3_prefix_hash(const sm3_prefix_t *prefix, const uint8_t *suffix, uint64_t len, uint8_t *digest)
+{
+    sm3_context_t ctx;
+
+    sm3_prefix_resume(&ctx, prefix);
+    sm3_update(&ctx, suffix, len);
+    sm3_final(&ctx, digest);
+}
+
+// 导出块边界上的中间状态
+int sm3_midstate_export(const sm3_context_t *ctx, uint8_t midstate[SM3_DIGEST_SIZE], uint64_t *length)
+{
+    if (ctx->buffer_length != 0)
+        return -1;
+
+    for (int i = 0; i < 8; i++)
+    {
+        midstate[i * 4] = (ctx->state[i] >> 24) & 0xFF;
+        midstate[i * 4 + 1] = (ctx->state[i] >> 16) & 0xFF;
+        midstate[i * 4 + 2] = (ctx->state[i] >> 8) & 0xFF;
+        midstate[i * 4 + 3] = ctx->state[i] & 0xFF;
+    }
+    *length = ctx->total_length / 8;
+    return 0;
+}
+
+// 从中间状态继续：length 为已压缩的字节数
+int sm3_midstate_import(sm3_context_t *ctx, const uint8_t midstate[SM3_DIGEST_SIZE], uint64_t length)
+{
+    if (length % SM3_BLOCK_SIZE != 0)
+        return -1;
+
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->state[i] = ((uint32_t)midstate[i * 4] << 24) | ((uint32_t)midstate[i * 4 + 1] << 16) |
+                        ((uint32_t)midstate[i * 4 + 2] << 8) | (uint32_t)midstate[i * 4 + 3];
+    }
+    ctx->total_length = length * 8;
+    ctx->buffer_length = 0;
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * SM3 Runtime Kernel Dispatch
+ * SM3 运行时CPU特性检测与内核分派
+ *
+ * 进程启动时探测一次 CPUID（x86-64）或 HWCAP（ARM），在 SM3 专用指令（SM3-NI、
+ * ARMv8.2 SM3 扩展）、AVX-512、AVX2、SSE4、NEON、标量内核中选择最快的一组；
+ * 同一个二进制可部署到不同代际的机器上。
+ *
+ * 环境变量 SM3_KERNEL=<name> 可强制指定内核（用于基准测试），
+ * 指定的内核在当前CPU上不可用时打印警告并回退到自动选择。
+ *
+ * CPU 支持的内核还须通过 GB/T 32905-2016 附录 A 的两个已知答案测试（单路内核及其
+ * 多路内核的每一路）才会被启用；未通过的内核打印警告后视为不可用，自动选择跳过它。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+#include "sm3_internal.h"
+
+#if defined(__aarch64__) && defined(__linux__)
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD (1 << 1)
+#endif
+#ifndef HWCAP_SM3
+#define HWCAP_SM3 (1 << 18)
+#endif
+#endif
+
+#ifdef SM3_HAVE_SM3NI
+#include <cpuid.h>
+
+// SM3-NI：CPUID.(EAX=7,ECX=1):EAX[bit 1]，VEX 编码还需要 AVX
+static int sm3_cpu_has_sm3ni(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__builtin_cpu_supports("avx2"))
+        return 0;
+    if (!__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    return (eax & (1u << 1)) != 0;
+}
+#endif
+
+// 内核表：按优先级从高到低排列
+static const sm3_kernel_t sm3_kernels[] = {
+#ifdef SM3_HAVE_SM3NI
+    {"sm3ni", sm3_compress_sm3ni, NULL, sm3_mb_compress_x8_avx2, NULL},
+#endif
+#ifdef SM3_HAVE_ARMV8_CE
+    {"armv8-sm3", sm3_compress_armv8_ce, sm3_mb_compress_x4_neon, NULL, NULL},
+#endif
+#ifdef __x86_64__
+    {"avx512", sm3_compress_avx512vl, NULL, sm3_mb_compress_x8_avx2, sm3_mb_compress_x16_avx512},
+    {"avx2", sm3_compress_avx2, NULL, sm3_mb_compress_x8_avx2, NULL},
+    {"sse4", sm3_compress_sse4, NULL, NULL, NULL},
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    {"neon", sm3_compress_neon, sm3_mb_compress_x4_neon, NULL, NULL},
+#endif
+    {"scalar", sm3_compress_scalar, NULL, NULL, NULL},
+};
+
+#define SM3_KERNEL_COUNT (sizeof(sm3_kernels) / sizeof(sm3_kernels[0]))
+
+// 按内核统计的数组以 SM3_STATS_MAX_KERNELS 为长度
+typedef char sm3_kernel_count_check[SM3_KERNEL_COUNT <= SM3_STATS_MAX_KERNELS ? 1 : -1];
+
+// 静态初始化为标量内核，保证在启动探测之前（如其他构造函数中）调用也是安全的
+const sm3_kernel_t *sm3_active_kernel = &sm3_kernels[SM3_KERNEL_COUNT - 1];
+
+// GB/T 32905-2016 附录 A 示例：“abc” 与 64 字节的 “abcd” x 16（两个消息块，跨越填充块）
+static const struct
+{
+    const char *message;
+    uint32_t digest[8];
+} sm3_kat_vectors[] = {
+    {"abc", {0x66c7f0f4, 0x62eeedd9, 0xd1f2d46b, 0xdc10e4e2, 0x4167c487, 0x5cf2f7a2, 0x297da02b, 0x8f4ba8e0}},
+    {"abcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcd",
+     {0xdebe9ff9, 0x2275b8a1, 0x38604889, 0xc18e5a4d, 0x6fdb70e5, 0x387e5765, 0x293dcba3, 0x9c0c5732}},
+};
+
+#define SM3_KAT_COUNT (sizeof(sm3_kat_vectors) / sizeof(sm3_kat_vectors[0]))
+
+// 内核状态：1 可用，0 CPU 不支持或未通过已知答案测试；由启动探测填写，之后只读
+static int sm3_kernel_ok[SM3_KERNEL_COUNT];
+
+// 按标准填充消息，返回块数（至多2块）
+static size_t sm3_kat_pad(const char *message, uint8_t blocks[2 * SM3_BLOCK_SIZE])
+{
+    size_t len = strlen(message);
+    size_t nblocks = (len + 9 + SM3_BLOCK_SIZE - 1) / SM3_BLOCK_SIZE;
+    uint64_t bits = (uint64_t)len * 8;
+
+    memset(blocks, 0, 2 * SM3_BLOCK_SIZE);
+    memcpy(blocks, message, len);
+    blocks[len] = 0x80;
+    for (int i = 0; i < 8; i++)
+        blocks[nblocks * SM3_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (i * 8));
+    return nblocks;
+}
+
+// 多路内核：第 l 路压缩把已知答案消息每块首字节异或 l 后的变体，与标量内核逐路比对；
+// 各路消息互不相同，串路、都从第 0 路取数或把状态写到别的路都会被发现，第 0 路即原消息，另与已知答案比对
+static int sm3_kat_mb(sm3_mb_compress_fn compress, int lanes, const uint8_t *blocks, size_t nblocks,
+                      const uint32_t *expected)
+{
+    uint32_t state[8 * 16] __attribute__((aligned(64)));
+    uint8_t lane_blocks[16][2 * SM3_BLOCK_SIZE];
+    const uint8_t *ptrs[16];
+
+    if (compress == NULL)
+        return 1;
+
+    for (int l = 0; l < lanes; l++)
+    {
+        memcpy(lane_blocks[l], blocks, nblocks * SM3_BLOCK_SIZE);
+        for (size_t b = 0; b < nblocks; b++)
+            lane_blocks[l][b * SM3_BLOCK_SIZE] ^= (uint8_t)l;
+    }
+    for (int i = 0; i < 8; i++)
+        for (int l = 0; l < lanes; l++)
+            state[i * lanes + l] = sm3_IV[i];
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        for (int l = 0; l < lanes; l++)
+            ptrs[l] = lane_blocks[l] + b * SM3_BLOCK_SIZE;
+        compress(state, ptrs);
+    }
+    for (int l = 0; l < lanes; l++)
+    {
+        uint32_t lane_expected[8];
+
+        memcpy(lane_expected, sm3_IV, sizeof(lane_expected));
+        sm3_compress_scalar(lane_expected, lane_blocks[l], nblocks);
+        for (int i = 0; i < 8; i++)
+            if (state[i * lanes + l] != lane_expected[i] || (l == 0 && lane_expected[i] != expected[i]))
+                return 0;
+    }
+    return 1;
+}
+
+// 已知答案测试：通过返回1
+static int sm3_kernel_kat(const sm3_kernel_t *kernel)
+{
+    uint8_t blocks[2 * SM3_BLOCK_SIZE];
+
+    for (size_t v = 0; v < SM3_KAT_COUNT; v++)
+    {
+        uint32_t state[8];
+        size_t nblocks = sm3_kat_pad(sm3_kat_vectors[v].message, blocks);
+        const uint32_t *expected = sm3_kat_vectors[v].digest;
+
+        memcpy(state, sm3_IV, sizeof(state));
+        kernel->compress(state, blocks, nblocks);
+        if (memcmp(state, expected, sizeof(state)) != 0)
+            return 0;
+        if (!sm3_kat_mb(kernel->mb_x4, 4, blocks, nblocks, expected) ||
+            !sm3_kat_mb(kernel->mb_x8, 8, blocks, nblocks, expected) ||
+            !sm3_kat_mb(kernel->mb_x16, 16, blocks, nblocks, expected))
+            return 0;
+    }
+    return 1;
+}
+
+// 检测内核在当前CPU上是否可用
+static int sm3_kernel_supported(const sm3_kernel_t *kernel)
+{
+    const char *name = kernel->name;
+
+    if (strcmp(name, "scalar") == 0)
+        return 1;
+#ifdef __x86_64__
+    __builtin_cpu_init();
+#ifdef SM3_HAVE_SM3NI
+    if (strcmp(name, "sm3ni") == 0)
+        return sm3_cpu_has_sm3ni();
+#endif
+    if (strcmp(name, "avx512") == 0)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avx512f") &&
+               __builtin_cpu_supports("avx512vl");
+    if (strcmp(name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "sse4") == 0)
+        return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+#endif
+#ifdef SM3_HAVE_ARMV8_CE
+    if (strcmp(name, "armv8-sm3") == 0)
+    {
+#ifdef __linux__
+        return (getauxval(AT_HWCAP) & HWCAP_SM3) != 0;
+#else
+        return 0; // 无法探测时保守地不启用
+#endif
+    }
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    if (strcmp(name, "neon") == 0)
+    {
+#if defined(__aarch64__) && defined(__linux__)
+        return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+        return 1; // 编译目标已保证 NEON 可用
+#endif
+    }
+#endif
+    return 0;
+}
+
+static const sm3_kernel_t *sm3_find_kernel(const char *name)
+{
+    for (size_t i = 0; i < SM3_KERNEL_COUNT; i++)
+    {
+        if (strcmp(sm3_kernels[i].name, name) == 0)
+            return &sm3_kernels[i];
+    }
+    return NULL;
+}
+
+static const sm3_kernel_t *sm3_best_kernel(void)
+{
+    for (size_t i = 0; i < SM3_KERNEL_COUNT; i++)
+    {
+        if (sm3_kernel_ok[i])
+            return &sm3_kernels[i];
+    }
+    return &sm3_kernels[SM3_KERNEL_COUNT - 1];
+}
+
+int sm3_set_kernel(const char *name)
+{
+    const sm3_kernel_t *kernel;
+
+    if (name == NULL || strcmp(name, "auto") == 0)
+    {
+        sm3_active_kernel = sm3_best_kernel();
+        return 0;
+    }
+
+    kernel = sm3_find_kernel(name);
+    if (kernel == NULL || !sm3_kernel_ok[kernel - sm3_kernels])
+        return -1;
+
+    sm3_active_kernel = kernel;
+    return 0;
+}
+
+const char *sm3_kernel_name(void)
+{
+    return sm3_active_kernel->name;
+}
+
+const char *sm3_kernel_name_at(int index)
+{
+    if (index < 0 || (size_t)index >= SM3_KERNEL_COUNT)
+        return NULL;
+    return sm3_kernels[index].name;
+}
+
+int sm3_kernel_index(const sm3_kernel_t *kernel)
+{
+    return (int)(kernel - sm3_kernels);
+}
+
+int sm3_self_test(void)
+{
+    int ret = 0;
+
+    for (size_t i = 0; i < SM3_KERNEL_COUNT; i++)
+    {
+        if (sm3_kernel_supported(&sm3_kernels[i]) && !sm3_kernel_kat(&sm3_kernels[i]))
+            ret = -1;
+    }
+    return ret;
+}
+
+// 启动时探测一次
+__attribute__((constructor)) static void sm3_dispatch_init(void)
+{
+    const char *forced = getenv("SM3_KERNEL");
+
+    for (size_t i = 0; i < SM3_KERNEL_COUNT; i++)
+    {
+        if (!sm3_kernel_supported(&sm3_kernels[i]))
+            continue;
+        sm3_kernel_ok[i] = sm3_kernel_kat(&sm3_kernels[i]);
+        if (!sm3_kernel_ok[i])
+            fprintf(stderr, "SM3: kernel '%s' failed the known-answer test and is disabled\n", sm3_kernels[i].name);
+    }
+
+    sm3_active_kernel = sm3_best_kernel();
+    if (forced != NULL && forced[0] != '\0' && sm3_set_kernel(forced) != 0)
+    {
+        fprintf(stderr, "SM3: kernel '%s' is not available on this CPU, using '%s'\n",
+                forced, sm3_active_kernel->name);
+    }
+}
@@ -0,0 +1,382 @@
+/*
+ * SM3 File Hashing
+ * 大文件流式哈希
+ *
+ * - 普通文件：整体 mmap，按 64MB 窗口压缩，每个窗口开始时对下一个窗口发出 WILLNEED，
+ *   内核预读与压缩重叠，数据不经过用户态缓冲区拷贝
+ * - 管道、块设备及强制流式模式：两个对齐缓冲区交替使用，压缩一个缓冲区时另一个的读取
+ *   已经通过 io_uring 提交（直接使用系统调用，不依赖 liburing）；
+ *   内核不支持或被禁用 io_uring 时退化为同步 read
+ */
+
+#define _DEFAULT_SOURCE // syscall, mmap, posix_madvise, pread
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "sm3_internal.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SM3_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#define SM3_FILE_WINDOW ((size_t)64 << 20) // mmap 压缩窗口
+#define SM3_FILE_CHUNK ((size_t)1 << 20)   // 流式读取缓冲区，块大小的整数倍
+#define SM3_FILE_ALIGN 4096
+#define SM3_URING_READ 1             // 读取请求的 user_data
+#define SM3_URING_CANCEL 2           // 取消请求的 user_data
+#define SM3_URING_OP_ASYNC_CANCEL 14 // 即 IORING_OP_ASYNC_CANCEL，5.5 之前的头文件中没有
+
+// 普通文件：mmap 后逐窗口压缩
+static int sm3_hash_mapped(int fd, size_t size, uint8_t *digest)
+{
+    sm3_context_t ctx;
+    uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+        return -1;
+
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+    sm3_init(&ctx);
+    for (size_t offset = 0; offset < size; offset += SM3_FILE_WINDOW)
+    {
+        size_t len = size - offset < SM3_FILE_WINDOW ? size - offset : SM3_FILE_WINDOW;
+        size_t next = offset + len;
+
+        if (next < size)
+            posix_madvise(map + next, size - next < SM3_FILE_WINDOW ? size - next : SM3_FILE_WINDOW,
+                          POSIX_MADV_WILLNEED);
+        sm3_update(&ctx, map + offset, len);
+    }
+    sm3_final(&ctx, digest);
+    munmap(map, size);
+    return 0;
+}
+
+#ifdef SM3_HAVE_IO_URING
+// 只需一个在途请求的最小 io_uring
+typedef struct
+{
+    int fd;
+    int inflight;     // 已提交、尚未收到完成项的读取数
+    struct iovec iov; // READV 的向量在请求完成前须保持有效
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+} sm3_uring_t;
+
+static int sm3_uring_init(sm3_uring_t *ring)
+{
+    struct io_uring_params p;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+    ring->fd = (int)syscall(__NR_io_uring_setup, 2, &p);
+    if (ring->fd < 0)
+        return -1;
+
+    ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                         IORING_OFF_SQ_RING);
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                         IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                      IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        if (ring->sq_ring != MAP_FAILED)
+            munmap(ring->sq_ring, ring->sq_ring_size);
+        if (ring->cq_ring != MAP_FAILED)
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        if (ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqes_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_tail = (unsigned *)((uint8_t *)ring->sq_ring + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)((uint8_t *)ring->sq_ring + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((uint8_t *)ring->sq_ring + p.sq_off.array);
+    ring->cq_head = (unsigned *)((uint8_t *)ring->cq_ring + p.cq_off.head);
+    ring->cq_tail = (unsigned *)((uint8_t *)ring->cq_ring + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)((uint8_t *)ring->cq_ring + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((uint8_t *)ring->cq_ring + p.cq_off.cqes);
+    return 0;
+}
+
+static void sm3_uring_exit(sm3_uring_t *ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->cq_ring, ring->cq_ring_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+// 提交一个请求；内核未接收时撤回该提交项，环中不留残余
+static int sm3_uring_submit(sm3_uring_t *ring, const struct io_uring_sqe *req)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+
+    ring->sqes[index] = *req;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    if (syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) == 1)
+        return 0;
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+    return -1;
+}
+
+// 提交一次读取；offset 为 -1 时从文件当前位置读（管道）
+// 用 READV 而不是 READ：后者从 Linux 5.6 才有，READV 随 io_uring 一起出现于 5.1
+static int sm3_uring_read(sm3_uring_t *ring, int fd, uint8_t *buf, size_t len, int64_t offset)
+{
+    struct io_uring_sqe sqe;
+
+    memset(&sqe, 0, sizeof(sqe));
+    ring->iov.iov_base = buf;
+    ring->iov.iov_len = len;
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = fd;
+    sqe.addr = (uint64_t)(uintptr_t)&ring->iov;
+    sqe.len = 1;
+    sqe.off = (uint64_t)offset;
+    sqe.user_data = SM3_URING_READ;
+    if (sm3_uring_submit(ring, &sqe) != 0)
+        return -1;
+    ring->inflight++;
+    return 0;
+}
+
+// 取出一个完成项；io_uring_enter 出错时返回-1，此时在途请求仍未完成
+static int sm3_uring_reap(sm3_uring_t *ring, uint64_t *user_data, int *res)
+{
+    unsigned head = *ring->cq_head;
+
+    while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+            return -1;
+    }
+    *user_data = ring->cqes[head & *ring->cq_mask].user_data;
+    *res = ring->cqes[head & *ring->cq_mask].res;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    if (*user_data == SM3_URING_READ)
+        ring->inflight--;
+    return 0;
+}
+
+// 等待在途读取完成，返回读到的字节数（0 为文件结束）；读取失败返回 -errno，等待本身失败返回 INT_MIN
+static int sm3_uring_wait(sm3_uring_t *ring)
+{
+    uint64_t user_data;
+    int res;
+
+    do
+    {
+        if (sm3_uring_reap(ring, &user_data, &res) != 0)
+            return INT_MIN;
+    } while (user_data != SM3_URING_READ);
+    return res;
+}
+
+// 出错退出前取消并收回在途读取，之后缓冲区才能释放；收不回时返回-1
+static int sm3_uring_drain(sm3_uring_t *ring)
+{
+    struct io_uring_sqe sqe;
+    int retries = 0;
+
+    if (ring->inflight == 0)
+        return 0;
+
+    // ASYNC_CANCEL 需要 5.5；更早的内核以 -EINVAL 完成取消请求，只能等读取自然结束
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = SM3_URING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = SM3_URING_READ;
+    sqe.user_data = SM3_URING_CANCEL;
+    sm3_uring_submit(ring, &sqe);
+
+    while (ring->inflight > 0)
+    {
+        uint64_t user_data;
+        int res;
+
+        if (sm3_uring_reap(ring, &user_data, &res) != 0)
+        {
+            if ((errno != EAGAIN && errno != EBUSY) || ++retries > 1000)
+                return -1;
+            usleep(1000);
+        }
+    }
+    return 0;
+}
+
+// 双缓冲：压缩 buf[cur] 时 buf[cur ^ 1] 的读取已在途
+// 内核仍可能写入缓冲区时不关闭环，并把 buf 置空交给调用方（泄漏好过释放后被写）
+static int sm3_hash_uring(int fd, int64_t offset, uint8_t *buf[2], uint8_t *digest)
+{
+    sm3_uring_t ring;
+    sm3_context_t ctx;
+    int cur = 0;
+    int first = 1;
+    int ret = -1;
+
+    if (sm3_uring_init(&ring) != 0)
+        return 1; // 不可用，由调用方退化为同步读取
+
+    sm3_init(&ctx);
+    if (sm3_uring_read(&ring, fd, buf[0], SM3_FILE_CHUNK, offset) != 0)
+    {
+        ret = 1; // 提交被拒绝，尚未读取任何数据
+        goto done;
+    }
+    for (;;)
+    {
+        int n = sm3_uring_wait(&ring);
+        if (n < 0)
+        {
+            // 首次读取就被拒绝（操作码不受支持、被安全策略禁用等），尚未消耗输入，改走同步读取
+            if (first && (n == -EINVAL || n == -EOPNOTSUPP || n == -EPERM))
+                ret = 1;
+            goto done;
+        }
+        first = 0;
+        if (n == 0)
+            break;
+
+        if (offset >= 0)
+            offset += n;
+        if (sm3_uring_read(&ring, fd, buf[cur ^ 1], SM3_FILE_CHUNK, offset) != 0)
+            goto done;
+        sm3_update(&ctx, buf[cur], (uint64_t)n);
+        cur ^= 1;
+    }
+    sm3_final(&ctx, digest);
+    ret = 0;
+
+done:
+    if (sm3_uring_drain(&ring) != 0)
+    {
+        buf[0] = buf[1] = NULL;
+        return -1;
+    }
+    sm3_uring_exit(&ring);
+    return ret;
+}
+#endif
+
+// 同步读取
+static int sm3_hash_read(int fd, int64_t offset, uint8_t *buf, uint8_t *digest)
+{
+    sm3_context_t ctx;
+
+    sm3_init(&ctx);
+    for (;;)
+    {
+        ssize_t n = offset >= 0 ? pread(fd, buf, SM3_FILE_CHUNK, (off_t)offset) : read(fd, buf, SM3_FILE_CHUNK);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            break;
+        if (offset >= 0)
+            offset += n;
+        sm3_update(&ctx, buf, (uint64_t)n);
+    }
+    sm3_final(&ctx, digest);
+    return 0;
+}
+
+static int sm3_hash_stream(int fd, uint8_t *digest)
+{
+    uint8_t *buf[2] = {NULL, NULL};
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    int64_t offset = pos < 0 ? -1 : (int64_t)pos; // 不可定位（管道）时按当前位置读
+    int ret = -1;
+
+    if (posix_memalign((void **)&buf[0], SM3_FILE_ALIGN, SM3_FILE_CHUNK) != 0 ||
+        posix_memalign((void **)&buf[1], SM3_FILE_ALIGN, SM3_FILE_CHUNK) != 0)
+        goto done;
+
+#ifdef SM3_HAVE_IO_URING
+    ret = sm3_hash_uring(fd, offset, buf, digest);
+    if (ret <= 0)
+        goto done;
+#endif
+    ret = sm3_hash_read(fd, offset, buf[0], digest);
+
+done:
+    // 可定位时用的是 pread，不移动文件位置；与 read 一样把位置留在文件结束处
+    if (ret == 0 && offset >= 0)
+        lseek(fd, 0, SEEK_END);
+    free(buf[0]);
+    free(buf[1]);
+    return ret;
+}
+
+int sm3_hash_fd(int fd, int flags, uint8_t *digest)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+        return -1;
+
+    // 从文件开头哈希的普通文件走 mmap；空文件无法映射，直接走流式路径
+    if (!(flags & SM3_FILE_STREAM) && S_ISREG(st.st_mode) && st.st_size > 0 && lseek(fd, 0, SEEK_CUR) == 0 &&
+        (uint64_t)st.st_size <= SIZE_MAX)
+    {
+        if (sm3_hash_mapped(fd, (size_t)st.st_size, digest) == 0)
+        {
+            lseek(fd, st.st_size, SEEK_SET); // 映射不移动文件位置，与流式路径一致地留在末尾
+            return 0;
+        }
+    }
+    return sm3_hash_stream(fd, digest);
+}
+
+int sm3_hash_file(const char *path, int flags, uint8_t *digest)
+{
+    int fd;
+    int ret;
+
+    if (strcmp(path, "-") == 0)
+        return sm3_hash_fd(STDIN_FILENO, flags, digest);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    ret = sm3_hash_fd(fd, flags, digest);
+    close(fd);
+    return ret;
+}
@@ -0,0 +1,101 @@
+/*
+ * HMAC-SM3
+ * 基于 SM3 的消息认证码（GB/T 15852.2 / RFC 2104 构造）
+ *
+ * HMAC(K, m) = SM3((K' ^ opad) || SM3((K' ^ ipad) || m))，K' 为补零到 64 字节的密钥
+ * （超过 64 字节的密钥先做一次 SM3）。K' ^ ipad 与 K' ^ opad 恰好各占一个消息块，
+ * 按密钥预先压缩为两个中间状态，此后每条消息只需压缩消息本身加上外层的一个块，
+ * 对短消息相当于省去一半的压缩。外层 SM3 的前缀状态独立于消息，因此不受长度扩展攻击影响
+ */
+
+#include <string.h>
+
+#include "sm3_internal.h"
+
+#define SM3_HMAC_IPAD 0x36
+#define SM3_HMAC_OPAD 0x5C
+#define SM3_HMAC_BATCH 64 // 批量接口每批消息数，内层摘要暂存在栈上
+
+void sm3_hmac_key_init(sm3_hmac_key_t *key, const uint8_t *k, size_t k_len)
+{
+    uint8_t block[SM3_BLOCK_SIZE];
+    uint8_t pad[SM3_BLOCK_SIZE];
+
+    memset(block, 0, sizeof(block));
+    if (k_len > SM3_BLOCK_SIZE)
+        sm3_hash(k, k_len, block);
+    else if (k_len > 0)
+        memcpy(block, k, k_len);
+
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+    {
+        pad[i] = block[i] ^ SM3_HMAC_IPAD;
+    }
+    sm3_prefix_init(&key->inner, pad, SM3_BLOCK_SIZE);
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++)
+    {
+        pad[i] = block[i] ^ SM3_HMAC_OPAD;
+    }
+    sm3_prefix_init(&key->outer, pad, SM3_BLOCK_SIZE);
+
+    // 清除栈上的密钥材料
+    memset(block, 0, sizeof(block));
+    memset(pad, 0, sizeof(pad));
+}
+
+void sm3_hmac_init(sm3_hmac_ctx_t *ctx, const sm3_hmac_key_t *key)
+{
+    ctx->key = key;
+    sm3_prefix_resume(&ctx->ctx, &key->inner);
+}
+
+void sm3_hmac_update(sm3_hmac_ctx_t *ctx, const uint8_t *data, uint64_t len)
+{
+    sm3_update(&ctx->ctx, data, len);
+}
+
+void sm3_hmac_final(sm3_hmac_ctx_t *ctx, uint8_t *mac)
+{
+    uint8_t inner[SM3_DIGEST_SIZE];
+
+    sm3_final(&ctx->ctx, inner);
+    sm3_prefix_hash(&ctx->key->outer, inner, SM3_DIGEST_SIZE, mac);
+}
+
+void sm3_hmac(const uint8_t *k, size_t k_len, const uint8_t *data, uint64_t len, uint8_t *mac)
+{
+    sm3_hmac_key_t key;
+    sm3_hmac_ctx_t ctx;
+
+    sm3_hmac_key_init(&key, k, k_len);
+    sm3_hmac_init(&ctx, &key);
+    sm3_hmac_update(&ctx, data, len);
+    sm3_hmac_final(&ctx, mac);
+    memset(&key, 0, sizeof(key));
+}
+
+// 同一密钥下批量计算：内层与外层各经过一次多路引擎
+void sm3_hmac_many(const sm3_hmac_key_t *key, const uint8_t *const *msgs, const size_t *lens,
+                   uint8_t (*out)[SM3_DIGEST_SIZE], size_t count)
+{
+    uint8_t inner[SM3_HMAC_BATCH][SM3_DIGEST_SIZE];
+    const uint8_t *suffixes[SM3_HMAC_BATCH];
+    size_t inner_lens[SM3_HMAC_BATCH];
+
+    for (int i = 0; i < SM3_HMAC_BATCH; i++)
+    {
+        suffixes[i] = inner[i];
+        inner_lens[i] = SM3_DIGEST_SIZE;
+    }
+
+    for (size_t done = 0; done < count;)
+    {
+        size_t batch = count - done;
+        if (batch > SM3_HMAC_BATCH)
+            batch = SM3_HMAC_BATCH;
+
+        sm3_hash_many_prefixed(&key->inner, msgs + done, lens + done, inner, batch);
+        sm3_hash_many_prefixed(&key->outer, suffixes, inner_lens, out + done, batch);
+        done += batch;
+    }
+}
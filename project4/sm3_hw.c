@@ -0,0 +1,216 @@
+/*
+ * SM3 Hardware Instruction Kernels
+ * SM3 专用硬件指令压缩内核
+ *
+ * - ARMv8.2-A SM3 扩展：SM3SS1 / SM3TT1A / SM3TT1B / SM3TT2A / SM3TT2B /
+ *   SM3PARTW1 / SM3PARTW2（鲲鹏、Graviton 等，HWCAP_SM3）
+ * - Intel SM3-NI：VSM3MSG1 / VSM3MSG2 / VSM3RNDS2（Arrow Lake / Lunar Lake 及以后，
+ *   CPUID.(EAX=7,ECX=1):EAX[1]）
+ *
+ * 两个内核与软件内核一样通过 sm3_dispatch.c 选择，
+ * 仅在编译器支持相应指令集时编译（见 sm3_internal.h 中的 SM3_HAVE_* 宏）
+ */
+
+#include "sm3_internal.h"
+
+#ifdef SM3_HAVE_ARMV8_CE
+
+#pragma GCC push_options
+#pragma GCC target("arch=armv8.2-a+sm4")
+
+#include <arm_neon.h>
+
+static inline uint32x4_t sm3_ce_load_be(const uint8_t *p)
+{
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+// 单轮：SS1 由 SM3SS1 计算，T 常数每轮循环左移1位
+// abcd = {D, C, B, A}，efgh = {H, G, F, E}（A、E 位于第3通道）
+#define SM3_CE_ROUND(ab, s0, i)                              \
+    do                                                       \
+    {                                                        \
+        uint32x4_t ss1 = vsm3ss1q_u32(abcd, t, efgh);        \
+        t = vsriq_n_u32(vshlq_n_u32(t, 1), t, 31);           \
+        abcd = vsm3tt1##ab##q_u32(abcd, ss1, wp, (i));       \
+        efgh = vsm3tt2##ab##q_u32(efgh, ss1, (s0), (i));     \
+    } while (0)
+
+// 四轮：W'[j..j+3] = W[j..j+3] ^ W[j+4..j+7]
+#define SM3_CE_QROUND(ab, s0, s1)        \
+    do                                   \
+    {                                    \
+        wp = veorq_u32((s0), (s1));      \
+        SM3_CE_ROUND(ab, (s0), 0);       \
+        SM3_CE_ROUND(ab, (s0), 1);       \
+        SM3_CE_ROUND(ab, (s0), 2);       \
+        SM3_CE_ROUND(ab, (s0), 3);       \
+    } while (0)
+
+// 四轮并同时扩展下一组消息字 s4 = W[j+16..j+19]
+#define SM3_CE_QROUND_EXP(ab, s0, s1, s2, s3, s4)             \
+    do                                                        \
+    {                                                         \
+        uint32x4_t w7 = vextq_u32((s1), (s2), 3);  /* W[j+7..j+10]  */ \
+        uint32x4_t w3 = vextq_u32((s0), (s1), 3);  /* W[j+3..j+6]   */ \
+        uint32x4_t w10 = vextq_u32((s2), (s3), 2); /* W[j+10..j+13] */ \
+        s4 = vsm3partw1q_u32(w7, (s0), (s3));                 \
+        SM3_CE_QROUND(ab, (s0), (s1));                        \
+        s4 = vsm3partw2q_u32(s4, w10, w3);                    \
+    } while (0)
+
+void sm3_compress_armv8_ce(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    // {A, B, C, D} -> {D, C, B, A}
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+    abcd = vrev64q_u32(abcd);
+    efgh = vrev64q_u32(efgh);
+    abcd = vextq_u32(abcd, abcd, 2);
+    efgh = vextq_u32(efgh, efgh, 2);
+
+    for (; nblocks > 0; nblocks--, data += SM3_BLOCK_SIZE)
+    {
+        uint32x4_t abcd0 = abcd, efgh0 = efgh;
+        uint32x4_t s0 = sm3_ce_load_be(data);
+        uint32x4_t s1 = sm3_ce_load_be(data + 16);
+        uint32x4_t s2 = sm3_ce_load_be(data + 32);
+        uint32x4_t s3 = sm3_ce_load_be(data + 48);
+        uint32x4_t s4, wp, t;
+
+        // 0-15轮
+        t = vdupq_n_u32(sm3_T_rotated[0]);
+        SM3_CE_QROUND_EXP(a, s0, s1, s2, s3, s4);
+        SM3_CE_QROUND_EXP(a, s1, s2, s3, s4, s0);
+        SM3_CE_QROUND_EXP(a, s2, s3, s4, s0, s1);
+        SM3_CE_QROUND_EXP(a, s3, s4, s0, s1, s2);
+
+        // 16-63轮
+        t = vdupq_n_u32(sm3_T_rotated[16]);
+        SM3_CE_QROUND_EXP(b, s4, s0, s1, s2, s3);
+        SM3_CE_QROUND_EXP(b, s0, s1, s2, s3, s4);
+        SM3_CE_QROUND_EXP(b, s1, s2, s3, s4, s0);
+        SM3_CE_QROUND_EXP(b, s2, s3, s4, s0, s1);
+        SM3_CE_QROUND_EXP(b, s3, s4, s0, s1, s2);
+        SM3_CE_QROUND_EXP(b, s4, s0, s1, s2, s3);
+        SM3_CE_QROUND_EXP(b, s0, s1, s2, s3, s4);
+        SM3_CE_QROUND_EXP(b, s1, s2, s3, s4, s0);
+        SM3_CE_QROUND_EXP(b, s2, s3, s4, s0, s1);
+        SM3_CE_QROUND(b, s3, s4);
+        SM3_CE_QROUND(b, s4, s0);
+        SM3_CE_QROUND(b, s0, s1);
+
+        abcd = veorq_u32(abcd, abcd0);
+        efgh = veorq_u32(efgh, efgh0);
+    }
+
+    abcd = vrev64q_u32(abcd);
+    efgh = vrev64q_u32(efgh);
+    vst1q_u32(state, vextq_u32(abcd, abcd, 2));
+    vst1q_u32(state + 4, vextq_u32(efgh, efgh, 2));
+}
+
+#pragma GCC pop_options
+
+#endif // SM3_HAVE_ARMV8_CE
+
+#ifdef SM3_HAVE_SM3NI
+
+#pragma GCC push_options
+#pragma GCC target("avx2,sm3")
+
+#include <immintrin.h>
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+// 消息扩展：由 W[j..j+15] 计算 W[j+16..j+19]
+static inline __m128i sm3ni_expand(__m128i s0, __m128i s1, __m128i s2, __m128i s3)
+{
+    __m128i w7 = _mm_alignr_epi8(s2, s1, 12);  // W[j+7..j+10]
+    __m128i w13 = _mm_srli_si128(s3, 4);       // W[j+13..j+15]
+    __m128i w3 = _mm_alignr_epi8(s1, s0, 12);  // W[j+3..j+6]
+    __m128i w10 = _mm_alignr_epi8(s3, s2, 8);  // W[j+10..j+13]
+    __m128i t = _mm_sm3msg1_epi32(w7, w13, s0);
+    return _mm_sm3msg2_epi32(t, w3, w10);
+}
+
+// 两轮一条 VSM3RNDS2：abef = {F, E, B, A}，cdgh 存放上一组 {F, E, B, A}
+// （即 C、D 预先右移9位，G、H 预先右移19位的形式）
+// 每条指令需要 {W[j], W[j+1], W[j+4], W[j+5]}，立即数为轮号
+#define SM3NI_RNDS4(j, wa, wb)                                                  \
+    do                                                                          \
+    {                                                                           \
+        __m128i prev = abef;                                                    \
+        abef = _mm_sm3rnds2_epi32(cdgh, abef, _mm_unpacklo_epi64((wa), (wb)), (j)); \
+        cdgh = prev;                                                            \
+        prev = abef;                                                            \
+        abef = _mm_sm3rnds2_epi32(cdgh, abef, _mm_unpackhi_epi64((wa), (wb)), (j) + 2); \
+        cdgh = prev;                                                            \
+    } while (0)
+
+void sm3_compress_sm3ni(uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+    uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+
+    for (; nblocks > 0; nblocks--, data += SM3_BLOCK_SIZE)
+    {
+        __m128i w[17];
+        __m128i abef = _mm_setr_epi32((int)F, (int)E, (int)B, (int)A);
+        __m128i cdgh = _mm_setr_epi32((int)ROR32(H, 19), (int)ROR32(G, 19), (int)ROR32(D, 9), (int)ROR32(C, 9));
+        uint32_t out[8];
+
+        for (int i = 0; i < 4; i++)
+        {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + i * 16)), bswap);
+        }
+        for (int i = 4; i < 17; i++)
+        {
+            w[i] = sm3ni_expand(w[i - 4], w[i - 3], w[i - 2], w[i - 1]);
+        }
+
+        SM3NI_RNDS4(0, w[0], w[1]);
+        SM3NI_RNDS4(4, w[1], w[2]);
+        SM3NI_RNDS4(8, w[2], w[3]);
+        SM3NI_RNDS4(12, w[3], w[4]);
+        SM3NI_RNDS4(16, w[4], w[5]);
+        SM3NI_RNDS4(20, w[5], w[6]);
+        SM3NI_RNDS4(24, w[6], w[7]);
+        SM3NI_RNDS4(28, w[7], w[8]);
+        SM3NI_RNDS4(32, w[8], w[9]);
+        SM3NI_RNDS4(36, w[9], w[10]);
+        SM3NI_RNDS4(40, w[10], w[11]);
+        SM3NI_RNDS4(44, w[11], w[12]);
+        SM3NI_RNDS4(48, w[12], w[13]);
+        SM3NI_RNDS4(52, w[13], w[14]);
+        SM3NI_RNDS4(56, w[14], w[15]);
+        SM3NI_RNDS4(60, w[15], w[16]);
+
+        _mm_storeu_si128((__m128i *)out, abef);
+        _mm_storeu_si128((__m128i *)(out + 4), cdgh);
+
+        A ^= out[3];
+        B ^= out[2];
+        E ^= out[1];
+        F ^= out[0];
+        C ^= ROTL32(out[7], 9);
+        D ^= ROTL32(out[6], 9);
+        G ^= ROTL32(out[5], 19);
+        H ^= ROTL32(out[4], 19);
+    }
+
+    state[0] = A;
+    state[1] = B;
+    state[2] = C;
+    state[3] = D;
+    state[4] = E;
+    state[5] = F;
+    state[6] = G;
+    state[7] = H;
+}
+
+#pragma GCC pop_options
+
+#endif // SM3_HAVE_SM3NI
@@ -0,0 +1,89 @@
+/*
+ * SM3 Library Internal Definitions
+ * libsm3 内部共享定义（不对外安装）
+ *
+ * 各压缩核心（单路、多路并行）共享的常数表与内核接口
+ */
+
+#ifndef SM3_INTERNAL_H
+#define SM3_INTERNAL_H
+
+#include "sm3.h"
+#include "sm3_stats.h"
+
+#ifdef __x86_64__
+#include <immintrin.h> // Intel intrinsics
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h> // ARM NEON intrinsics
+#endif
+
+// 标准初始值
+extern const uint32_t sm3_IV[8];
+
+// 预先循环移位的 T 常数表：sm3_T_rotated[j] = ROTL32(T_j, j mod 32)
+extern const uint32_t sm3_T_rotated[64];
+
+// 单路压缩内核：对 state 连续压缩 nblocks 个消息块
+typedef void (*sm3_compress_fn)(uint32_t state[8], const uint8_t *data, size_t nblocks);
+
+void sm3_compress_scalar(uint32_t state[8], const uint8_t *data, size_t nblocks);
+#ifdef __x86_64__
+void sm3_compress_sse4(uint32_t state[8], const uint8_t *data, size_t nblocks);
+void sm3_compress_avx2(uint32_t state[8], const uint8_t *data, size_t nblocks);
+void sm3_compress_avx512vl(uint32_t state[8], const uint8_t *data, size_t nblocks);
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+void sm3_compress_neon(uint32_t state[8], const uint8_t *data, size_t nblocks);
+#endif
+
+// SM3 专用指令内核（sm3_hw.c），仅在编译器能生成相应指令时编译
+// Intel SM3-NI 需要 GCC 14 / Clang 18 及以上；ARMv8.2 SM3 扩展需要 GCC 8 / Clang 8 及以上
+#if defined(__x86_64__) && ((defined(__clang__) && __clang_major__ >= 18) || \
+                            (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 14))
+#define SM3_HAVE_SM3NI 1
+void sm3_compress_sm3ni(uint32_t state[8], const uint8_t *data, size_t nblocks);
+#endif
+#if defined(__aarch64__) && ((defined(__clang__) && __clang_major__ >= 8) || \
+                             (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8))
+#define SM3_HAVE_ARMV8_CE 1
+void sm3_compress_armv8_ce(uint32_t state[8], const uint8_t *data, size_t nblocks);
+#endif
+
+// 多路并行压缩内核
+// state 为转置存储：state[i * lanes + l] 表示第 l 路消息的第 i 个状态字
+// blocks[l] 指向第 l 路本次要压缩的 64 字节消息块
+typedef void (*sm3_mb_compress_fn)(uint32_t *state, const uint8_t *const *blocks);
+
+void sm3_mb_compress_x4_generic(uint32_t *state, const uint8_t *const *blocks);
+void sm3_mb_compress_x8_generic(uint32_t *state, const uint8_t *const *blocks);
+void sm3_mb_compress_x16_generic(uint32_t *state, const uint8_t *const *blocks);
+
+#ifdef __x86_64__
+void sm3_mb_compress_x8_avx2(uint32_t *state, const uint8_t *const *blocks);
+void sm3_mb_compress_x16_avx512(uint32_t *state, const uint8_t *const *blocks);
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+void sm3_mb_compress_x4_neon(uint32_t *state, const uint8_t *const *blocks);
+#endif
+
+// 运行时分派的内核组合
+// mb_x4/mb_x8/mb_x16 为对应宽度的多路内核，当前CPU无加速实现时为 NULL
+typedef struct
+{
+    const char *name;
+    sm3_compress_fn compress;
+    sm3_mb_compress_fn mb_x4;
+    sm3_mb_compress_fn mb_x8;
+    sm3_mb_compress_fn mb_x16;
+} sm3_kernel_t;
+
+// 当前生效的内核，启动时由 sm3_dispatch.c 根据 CPUID/HWCAP 选定
+extern const sm3_kernel_t *sm3_active_kernel;
+
+// 内核在分派表中的下标（与 sm3_kernel_name_at 一致），供按内核统计使用
+int sm3_kernel_index(const sm3_kernel_t *kernel);
+
+#endif // SM3_INTERNAL_H
@@ -0,0 +1,66 @@
+/*
+ * SM2 Key Derivation Function
+ * SM2 密钥派生函数（GB/T 32918.4 第 5.4.3 节）
+ *
+ * KDF(Z, klen) = SM3(Z || 00000001) || SM3(Z || 00000002) || ... 的前 klen 字节。
+ * 共享秘密 Z 的完整块只压缩一次，所有计数块从同一中间状态出发，
+ * 每批计数块交给多路引擎按 SIMD 通道并行处理，完整的 32 字节输出直接写入调用方缓冲区
+ */
+
+#include <string.h>
+
+#include "sm3_internal.h"
+
+#define SM3_KDF_BATCH 64 // 每批计数块数，多路引擎按通道数补位调度
+
+int sm3_kdf(const uint8_t *z, size_t z_len, uint8_t *key, size_t klen)
+{
+    uint8_t counters[SM3_KDF_BATCH][4];
+    const uint8_t *suffixes[SM3_KDF_BATCH];
+    size_t lens[SM3_KDF_BATCH];
+    uint8_t last[SM3_DIGEST_SIZE];
+    sm3_prefix_t prefix;
+    uint64_t blocks = ((uint64_t)klen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+    uint64_t ct = 1;
+
+    if (blocks > 0xFFFFFFFFULL)
+        return -1;
+
+    sm3_prefix_init(&prefix, z, z_len);
+    for (int i = 0; i < SM3_KDF_BATCH; i++)
+    {
+        suffixes[i] = counters[i];
+        lens[i] = sizeof(counters[i]);
+    }
+
+    while (ct <= blocks)
+    {
+        uint64_t batch = blocks - ct + 1;
+        if (batch > SM3_KDF_BATCH)
+            batch = SM3_KDF_BATCH;
+
+        for (uint64_t i = 0; i < batch; i++)
+        {
+            uint32_t c = (uint32_t)(ct + i);
+            counters[i][0] = (uint8_t)(c >> 24);
+            counters[i][1] = (uint8_t)(c >> 16);
+            counters[i][2] = (uint8_t)(c >> 8);
+            counters[i][3] = (uint8_t)c;
+        }
+
+        // 最后一块不足 32 字节时单独输出到临时缓冲区
+        uint8_t *dst = key + (ct - 1) * SM3_DIGEST_SIZE;
+        uint64_t direct = batch;
+        if (ct + batch - 1 == blocks && klen % SM3_DIGEST_SIZE != 0)
+            direct--;
+
+        sm3_hash_many_prefixed(&prefix, suffixes, lens, (uint8_t (*)[SM3_DIGEST_SIZE])dst, (size_t)direct);
+        if (direct < batch)
+        {
+            sm3_hash_many_prefixed(&prefix, suffixes + direct, lens + direct, &last, 1);
+            memcpy(dst + direct * SM3_DIGEST_SIZE, last, klen % SM3_DIGEST_SIZE);
+        }
+        ct += batch;
+    }
+    return 0;
+}
@@ -0,0 +1,396 @@
+/*
+ * SM3 Multi-Buffer Engine
+ * SM3 多路并行哈希引擎
+ *
+ * 将 4/8/16 条相互独立的消息放入 SIMD 寄存器的不同通道同时压缩：
+ * - AVX2:    8 路，状态 A..H 各占一个 __m256i（sm3_mb_avx2.c）
+ * - AVX-512: 16 路，状态 A..H 各占一个 __m512i，vprold 原生循环移位（sm3_mb_avx512.c）
+ * - NEON:    4 路，状态 A..H 各占一个 uint32x4_t
+ * - 通用C:   逐路标量回退
+ *
+ * 内核由 sm3_dispatch.c 在运行时选定，
+ * 调度器按"通道补位"方式工作：某一路消息处理完成后立即装入下一条消息，
+ * 适合 Merkle 叶子、KDF 计数块等大量短消息场景；
+ * 所有消息共享同一前缀时各路从前缀的中间状态开始（sm3_hash_many_prefixed），前缀只压缩一次
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h> // ARM NEON intrinsics
+#endif
+
+#include "sm3_internal.h"
+
+// 基础运算宏
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define P0(x) ((x) ^ ROTL32((x), 9) ^ ROTL32((x), 17))
+#define P1(x) ((x) ^ ROTL32((x), 15) ^ ROTL32((x), 23))
+
+// 空闲通道使用的占位消息块
+static const uint8_t sm3_mb_dummy_block[SM3_BLOCK_SIZE] __attribute__((aligned(64)));
+
+// 通用C实现：逐路执行标准压缩函数
+static inline void sm3_mb_compress_lanes(uint32_t *state, const uint8_t *const *blocks, const int lanes)
+{
+    for (int l = 0; l < lanes; l++)
+    {
+        const uint8_t *p = blocks[l];
+        uint32_t W[68];
+
+        for (int i = 0; i < 16; i++)
+        {
+            W[i] = ((uint32_t)p[i * 4] << 24) | ((uint32_t)p[i * 4 + 1] << 16) |
+                   ((uint32_t)p[i * 4 + 2] << 8) | p[i * 4 + 3];
+        }
+        for (int j = 16; j < 68; j++)
+        {
+            W[j] = P1(W[j - 16] ^ W[j - 9] ^ ROTL32(W[j - 3], 15)) ^ ROTL32(W[j - 13], 7) ^ W[j - 6];
+        }
+
+        uint32_t A = state[0 * lanes + l], B = state[1 * lanes + l];
+        uint32_t C = state[2 * lanes + l], D = state[3 * lanes + l];
+        uint32_t E = state[4 * lanes + l], F = state[5 * lanes + l];
+        uint32_t G = state[6 * lanes + l], H = state[7 * lanes + l];
+
+        for (int j = 0; j < 64; j++)
+        {
+            uint32_t A12 = ROTL32(A, 12);
+            uint32_t SS1 = ROTL32(A12 + E + sm3_T_rotated[j], 7);
+            uint32_t SS2 = SS1 ^ A12;
+            uint32_t FF = (j < 16) ? (A ^ B ^ C) : ((A & B) | (A & C) | (B & C));
+            uint32_t GG = (j < 16) ? (E ^ F ^ G) : ((E & F) | (~E & G));
+            uint32_t TT1 = FF + D + SS2 + (W[j] ^ W[j + 4]);
+            uint32_t TT2 = GG + H + SS1 + W[j];
+            D = C;
+            C = ROTL32(B, 9);
+            B = A;
+            A = TT1;
+            H = G;
+            G = ROTL32(F, 19);
+            F = E;
+            E = P0(TT2);
+        }
+
+        state[0 * lanes + l] ^= A;
+        state[1 * lanes + l] ^= B;
+        state[2 * lanes + l] ^= C;
+        state[3 * lanes + l] ^= D;
+        state[4 * lanes + l] ^= E;
+        state[5 * lanes + l] ^= F;
+        state[6 * lanes + l] ^= G;
+        state[7 * lanes + l] ^= H;
+    }
+}
+
+void sm3_mb_compress_x4_generic(uint32_t *state, const uint8_t *const *blocks)
+{
+    sm3_mb_compress_lanes(state, blocks, 4);
+}
+
+void sm3_mb_compress_x8_generic(uint32_t *state, const uint8_t *const *blocks)
+{
+    sm3_mb_compress_lanes(state, blocks, 8);
+}
+
+void sm3_mb_compress_x16_generic(uint32_t *state, const uint8_t *const *blocks)
+{
+    sm3_mb_compress_lanes(state, blocks, 16);
+}
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+// ARM NEON 4路实现：vshlq + vsriq 组合实现循环移位
+#define V4_ROTL(x, n) vsriq_n_u32(vshlq_n_u32((x), (n)), (x), 32 - (n))
+#define V4_XOR3(a, b, c) veorq_u32(veorq_u32((a), (b)), (c))
+#define V4_P0(x) V4_XOR3((x), V4_ROTL((x), 9), V4_ROTL((x), 17))
+#define V4_P1(x) V4_XOR3((x), V4_ROTL((x), 15), V4_ROTL((x), 23))
+#define V4_MAJ(x, y, z) vbslq_u32(veorq_u32((x), (y)), (z), (y))
+#define V4_CH(x, y, z) vbslq_u32((x), (y), (z))
+
+static inline uint32x4_t sm3_mb_load_be_neon(const uint8_t *p)
+{
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+void sm3_mb_compress_x4_neon(uint32_t *state, const uint8_t *const *blocks)
+{
+    uint32x4_t W[68];
+
+    // 4x4 转置：W[j] 的第 l 个通道为第 l 路消息的第 j 个字
+    for (int g = 0; g < 4; g++)
+    {
+        uint32x4_t r0 = sm3_mb_load_be_neon(blocks[0] + g * 16);
+        uint32x4_t r1 = sm3_mb_load_be_neon(blocks[1] + g * 16);
+        uint32x4_t r2 = sm3_mb_load_be_neon(blocks[2] + g * 16);
+        uint32x4_t r3 = sm3_mb_load_be_neon(blocks[3] + g * 16);
+        uint32x4x2_t t01 = vtrnq_u32(r0, r1);
+        uint32x4x2_t t23 = vtrnq_u32(r2, r3);
+        W[g * 4 + 0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+        W[g * 4 + 1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+        W[g * 4 + 2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+        W[g * 4 + 3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+    }
+    for (int j = 16; j < 68; j++)
+    {
+        uint32x4_t t = V4_XOR3(W[j - 16], W[j - 9], V4_ROTL(W[j - 3], 15));
+        W[j] = V4_XOR3(V4_P1(t), V4_ROTL(W[j - 13], 7), W[j - 6]);
+    }
+
+    uint32x4_t A = vld1q_u32(state + 0), B = vld1q_u32(state + 4);
+    uint32x4_t C = vld1q_u32(state + 8), D = vld1q_u32(state + 12);
+    uint32x4_t E = vld1q_u32(state + 16), F = vld1q_u32(state + 20);
+    uint32x4_t G = vld1q_u32(state + 24), H = vld1q_u32(state + 28);
+    uint32x4_t A0 = A, B0 = B, C0 = C, D0 = D, E0 = E, F0 = F, G0 = G, H0 = H;
+
+    for (int j = 0; j < 64; j++)
+    {
+        uint32x4_t A12 = V4_ROTL(A, 12);
+        uint32x4_t SS1 = vaddq_u32(vaddq_u32(A12, E), vdupq_n_u32(sm3_T_rotated[j]));
+        SS1 = V4_ROTL(SS1, 7);
+        uint32x4_t SS2 = veorq_u32(SS1, A12);
+        uint32x4_t FF = (j < 16) ? V4_XOR3(A, B, C) : V4_MAJ(A, B, C);
+        uint32x4_t GG = (j < 16) ? V4_XOR3(E, F, G) : V4_CH(E, F, G);
+        uint32x4_t TT1 = vaddq_u32(vaddq_u32(FF, D), vaddq_u32(SS2, veorq_u32(W[j], W[j + 4])));
+        uint32x4_t TT2 = vaddq_u32(vaddq_u32(GG, H), vaddq_u32(SS1, W[j]));
+        D = C;
+        C = V4_ROTL(B, 9);
+        B = A;
+        A = TT1;
+        H = G;
+        G = V4_ROTL(F, 19);
+        F = E;
+        E = V4_P0(TT2);
+    }
+
+    vst1q_u32(state + 0, veorq_u32(A, A0));
+    vst1q_u32(state + 4, veorq_u32(B, B0));
+    vst1q_u32(state + 8, veorq_u32(C, C0));
+    vst1q_u32(state + 12, veorq_u32(D, D0));
+    vst1q_u32(state + 16, veorq_u32(E, E0));
+    vst1q_u32(state + 20, veorq_u32(F, F0));
+    vst1q_u32(state + 24, veorq_u32(G, G0));
+    vst1q_u32(state + 28, veorq_u32(H, H0));
+}
+#endif
+
+// 多路内核描述
+typedef struct
+{
+    sm3_mb_compress_fn compress;
+    int lanes;
+} sm3_mb_kernel_t;
+
+// 每一路的调度状态
+// 一路消息是 公共前缀的状态 + 前缀未满一块的部分 pre + 本路后缀 msg；无前缀时 pre 为空、状态为 IV
+typedef struct
+{
+    const uint8_t *pre;
+    size_t pre_len;
+    const uint8_t *msg;
+    size_t full_blocks;  // pre || msg 中可直接压缩的完整块数
+    size_t total_blocks; // 含填充块的总块数
+    size_t next_block;
+    size_t job;
+    uint8_t block[SM3_BLOCK_SIZE];    // pre 非空时拼接出的完整块
+    uint8_t tail[2 * SM3_BLOCK_SIZE]; // 尾部数据与填充
+} sm3_mb_lane_t;
+
+// 选择内核：优先取能一次容纳全部消息的最窄加速内核，否则取最宽内核；
+// 当前分派的内核组合没有多路实现时使用通用C版本
+static sm3_mb_kernel_t sm3_mb_select(size_t count)
+{
+    const sm3_kernel_t *k = sm3_active_kernel;
+    const sm3_mb_kernel_t candidates[3] = {
+        {k->mb_x16, 16},
+        {k->mb_x8, 8},
+        {k->mb_x4, 4},
+    };
+    sm3_mb_kernel_t best = {NULL, 0};
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (candidates[i].compress == NULL)
+            continue;
+        if (best.compress == NULL || (size_t)candidates[i].lanes >= count)
+            best = candidates[i];
+    }
+    if (best.compress == NULL)
+        best = (sm3_mb_kernel_t){sm3_mb_compress_x8_generic, 8};
+    return best;
+}
+
+int sm3_mb_lanes(void)
+{
+    const sm3_kernel_t *k = sm3_active_kernel;
+
+    if (k->mb_x16)
+        return 16;
+    if (k->mb_x8)
+        return 8;
+    if (k->mb_x4)
+        return 4;
+    return 8;
+}
+
+// 从 pre || msg 的 offset 处复制 n 字节
+static void sm3_mb_gather(const sm3_mb_lane_t *lane, size_t offset, size_t n, uint8_t *dst)
+{
+    if (offset < lane->pre_len)
+    {
+        size_t k = lane->pre_len - offset;
+        if (k > n)
+            k = n;
+        memcpy(dst, lane->pre + offset, k);
+        dst += k;
+        offset += k;
+        n -= k;
+    }
+    if (n > 0)
+        memcpy(dst, lane->msg + (offset - lane->pre_len), n);
+}
+
+// 为一路装入新消息：完整块直接引用原始数据，尾部数据在通道缓冲区内填充
+static void sm3_mb_lane_load(sm3_mb_lane_t *lane, uint32_t *state, int lanes, int l,
+                             const sm3_prefix_t *prefix, const uint8_t *msg, size_t len, size_t job)
+{
+    const uint32_t *init = prefix ? prefix->state : sm3_IV;
+    size_t pre_len = prefix ? prefix->buffer_length : 0;
+    size_t total = pre_len + len;
+    size_t rem = total % SM3_BLOCK_SIZE;
+    size_t tail_blocks = (rem + 9 > SM3_BLOCK_SIZE) ? 2 : 1;
+    size_t tail_len = tail_blocks * SM3_BLOCK_SIZE;
+    uint64_t bit_len = (prefix ? prefix->total_length : 0) + (uint64_t)len * 8;
+
+    SM3_STAT_ADD(bytes_hashed[sm3_kernel_index(sm3_active_kernel)], len);
+
+    lane->pre = prefix ? prefix->buffer : NULL;
+    lane->pre_len = pre_len;
+    lane->msg = msg;
+    lane->full_blocks = total / SM3_BLOCK_SIZE;
+    lane->total_blocks = lane->full_blocks + tail_blocks;
+    lane->next_block = 0;
+    lane->job = job;
+
+    sm3_mb_gather(lane, lane->full_blocks * SM3_BLOCK_SIZE, rem, lane->tail);
+    lane->tail[rem] = 0x80;
+    memset(lane->tail + rem + 1, 0, tail_len - rem - 1 - 8);
+    for (int i = 0; i < 8; i++)
+    {
+        lane->tail[tail_len - 1 - i] = (uint8_t)(bit_len >> (i * 8));
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        state[i * lanes + l] = init[i];
+    }
+}
+
+static inline const uint8_t *sm3_mb_lane_block(sm3_mb_lane_t *lane)
+{
+    if (lane->next_block < lane->full_blocks)
+    {
+        if (lane->pre_len == 0)
+            return lane->msg + lane->next_block * SM3_BLOCK_SIZE;
+        sm3_mb_gather(lane, lane->next_block * SM3_BLOCK_SIZE, SM3_BLOCK_SIZE, lane->block);
+        return lane->block;
+    }
+    return lane->tail + (lane->next_block - lane->full_blocks) * SM3_BLOCK_SIZE;
+}
+
+// 通道补位调度
+static void sm3_mb_run(const sm3_mb_kernel_t *kernel, const sm3_prefix_t *prefix, const uint8_t *const *msgs,
+                       const size_t *lens, uint8_t (*out)[SM3_DIGEST_SIZE], size_t count)
+{
+    uint32_t state[8 * SM3_MB_MAX_LANES] __attribute__((aligned(64)));
+    sm3_mb_lane_t lane[SM3_MB_MAX_LANES];
+    const uint8_t *blocks[SM3_MB_MAX_LANES];
+    int active[SM3_MB_MAX_LANES];
+    const int lanes = kernel->lanes;
+    size_t next_job = 0;
+    int busy = 0;
+
+    memset(state, 0, sizeof(state));
+    for (int l = 0; l < lanes; l++)
+    {
+        active[l] = next_job < count;
+        if (active[l])
+        {
+            sm3_mb_lane_load(&lane[l], state, lanes, l, prefix, msgs[next_job], lens[next_job], next_job);
+            next_job++;
+            busy++;
+        }
+    }
+
+    while (busy > 0)
+    {
+        for (int l = 0; l < lanes; l++)
+        {
+            blocks[l] = active[l] ? sm3_mb_lane_block(&lane[l]) : sm3_mb_dummy_block;
+        }
+
+        SM3_STAT_ADD(mb_lane_blocks[sm3_kernel_index(sm3_active_kernel)], busy);
+        SM3_STAT_ADD(mb_idle_blocks[sm3_kernel_index(sm3_active_kernel)], lanes - busy);
+        kernel->compress(state, blocks);
+
+        for (int l = 0; l < lanes; l++)
+        {
+            if (!active[l] || ++lane[l].next_block < lane[l].total_blocks)
+                continue;
+
+            // 输出哈希值（大端序）
+            uint8_t *digest = out[lane[l].job];
+            for (int i = 0; i < 8; i++)
+            {
+                uint32_t v = state[i * lanes + l];
+                digest[i * 4] = (v >> 24) & 0xFF;
+                digest[i * 4 + 1] = (v >> 16) & 0xFF;
+                digest[i * 4 + 2] = (v >> 8) & 0xFF;
+                digest[i * 4 + 3] = v & 0xFF;
+            }
+
+            if (next_job < count)
+            {
+                sm3_mb_lane_load(&lane[l], state, lanes, l, prefix, msgs[next_job], lens[next_job], next_job);
+                next_job++;
+            }
+            else
+            {
+                active[l] = 0;
+                busy--;
+            }
+        }
+    }
+}
+
+void sm3_hash_many(const uint8_t *const *msgs, const size_t *lens,
+                   uint8_t (*out)[SM3_DIGEST_SIZE], size_t count)
+{
+    if (count == 0)
+        return;
+    sm3_mb_kernel_t kernel = sm3_mb_select(count);
+    sm3_mb_run(&kernel, NULL, msgs, lens, out, count);
+}
+
+void sm3_hash_many_prefixed(const sm3_prefix_t *prefix, const uint8_t *const *suffixes, const size_t *lens,
+                            uint8_t (*out)[SM3_DIGEST_SIZE], size_t count)
+{
+    if (count == 0)
+        return;
+    sm3_mb_kernel_t kernel = sm3_mb_select(count);
+    sm3_mb_run(&kernel, prefix, suffixes, lens, out, count);
+}
+
+void sm3_hash_x4(const uint8_t *msgs[4], const size_t lens[4], uint8_t out[4][SM3_DIGEST_SIZE])
+{
+    sm3_hash_many(msgs, lens, out, 4);
+}
+
+void sm3_hash_x8(const uint8_t *msgs[8], const size_t lens[8], uint8_t out[8][SM3_DIGEST_SIZE])
+{
+    sm3_hash_many(msgs, lens, out, 8);
+}
+
+void sm3_hash_x16(const uint8_t *msgs[16], const size_t lens[16], uint8_t out[16][SM3_DIGEST_SIZE])
+{
+    sm3_hash_many(msgs, lens, out, 16);
+}
@@ -0,0 +1,128 @@
+/*
+ * SM3 Multi-Buffer Kernel - AVX2
+ * SM3 8路并行压缩内核（AVX2）
+ *
+ * 8 条消息的 A..H 状态分别存放在 8 个 __m256i 的各通道中，
+ * 本文件以 AVX2 目标编译，仅在运行时检测到 AVX2 后调用
+ */
+
+#ifdef __x86_64__
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+#include "sm3_internal.h"
+
+// AVX2 无循环移位指令，使用移位+或实现
+#define V8_ROTL(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+#define V8_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256((a), (b)), (c))
+#define V8_ADD(a, b) _mm256_add_epi32((a), (b))
+#define V8_P0(x) V8_XOR3((x), V8_ROTL((x), 9), V8_ROTL((x), 17))
+#define V8_P1(x) V8_XOR3((x), V8_ROTL((x), 15), V8_ROTL((x), 23))
+// FF_16_63(x, y, z) = (x & y) | ((x | y) & z)
+#define V8_MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256(_mm256_or_si256((x), (y)), (z)))
+// GG_16_63(x, y, z) = (x & y) | (~x & z)
+#define V8_CH(x, y, z) _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_andnot_si256((x), (z)))
+
+// 8x8 转置：输入 r[l] 为第 l 路的 8 个连续消息字，输出 w[j] 为 8 路的第 j 个字
+static inline void sm3_mb_transpose8(__m256i r[8], __m256i w[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    w[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    w[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    w[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    w[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    w[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    w[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    w[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    w[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// 加载 8 路消息块的 16 个字（大端序）
+static inline void sm3_mb_load_x8(const uint8_t *const *blocks, __m256i W[16])
+{
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i r[8];
+
+    for (int half = 0; half < 2; half++)
+    {
+        for (int l = 0; l < 8; l++)
+        {
+            r[l] = _mm256_loadu_si256((const __m256i *)(blocks[l] + half * 32));
+            r[l] = _mm256_shuffle_epi8(r[l], bswap);
+        }
+        sm3_mb_transpose8(r, &W[half * 8]);
+    }
+}
+
+void sm3_mb_compress_x8_avx2(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m256i W[68];
+
+    sm3_mb_load_x8(blocks, W);
+    for (int j = 16; j < 68; j++)
+    {
+        __m256i t = V8_XOR3(W[j - 16], W[j - 9], V8_ROTL(W[j - 3], 15));
+        W[j] = V8_XOR3(V8_P1(t), V8_ROTL(W[j - 13], 7), W[j - 6]);
+    }
+
+    __m256i A = _mm256_load_si256((const __m256i *)(state + 0));
+    __m256i B = _mm256_load_si256((const __m256i *)(state + 8));
+    __m256i C = _mm256_load_si256((const __m256i *)(state + 16));
+    __m256i D = _mm256_load_si256((const __m256i *)(state + 24));
+    __m256i E = _mm256_load_si256((const __m256i *)(state + 32));
+    __m256i F = _mm256_load_si256((const __m256i *)(state + 40));
+    __m256i G = _mm256_load_si256((const __m256i *)(state + 48));
+    __m256i H = _mm256_load_si256((const __m256i *)(state + 56));
+    __m256i A0 = A, B0 = B, C0 = C, D0 = D, E0 = E, F0 = F, G0 = G, H0 = H;
+
+    for (int j = 0; j < 64; j++)
+    {
+        __m256i A12 = V8_ROTL(A, 12);
+        __m256i SS1 = V8_ROTL(V8_ADD(V8_ADD(A12, E), _mm256_set1_epi32((int)sm3_T_rotated[j])), 7);
+        __m256i SS2 = _mm256_xor_si256(SS1, A12);
+        __m256i FF = (j < 16) ? V8_XOR3(A, B, C) : V8_MAJ(A, B, C);
+        __m256i GG = (j < 16) ? V8_XOR3(E, F, G) : V8_CH(E, F, G);
+        __m256i TT1 = V8_ADD(V8_ADD(FF, D), V8_ADD(SS2, _mm256_xor_si256(W[j], W[j + 4])));
+        __m256i TT2 = V8_ADD(V8_ADD(GG, H), V8_ADD(SS1, W[j]));
+        D = C;
+        C = V8_ROTL(B, 9);
+        B = A;
+        A = TT1;
+        H = G;
+        G = V8_ROTL(F, 19);
+        F = E;
+        E = V8_P0(TT2);
+    }
+
+    _mm256_store_si256((__m256i *)(state + 0), _mm256_xor_si256(A, A0));
+    _mm256_store_si256((__m256i *)(state + 8), _mm256_xor_si256(B, B0));
+    _mm256_store_si256((__m256i *)(state + 16), _mm256_xor_si256(C, C0));
+    _mm256_store_si256((__m256i *)(state + 24), _mm256_xor_si256(D, D0));
+    _mm256_store_si256((__m256i *)(state + 32), _mm256_xor_si256(E, E0));
+    _mm256_store_si256((__m256i *)(state + 40), _mm256_xor_si256(F, F0));
+    _mm256_store_si256((__m256i *)(state + 48), _mm256_xor_si256(G, G0));
+    _mm256_store_si256((__m256i *)(state + 56), _mm256_xor_si256(H, H0));
+}
+
+#pragma GCC pop_options
+
+#endif // __x86_64__
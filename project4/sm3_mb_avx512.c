@@ -0,0 +1,135 @@
+/*
+ * SM3 Multi-Buffer Kernel - AVX-512
+ * SM3 16路并行压缩内核（AVX-512）
+ *
+ * 16 条消息的 A..H 状态分别存放在 8 个 __m512i 的各通道中，
+ * 循环移位使用原生 vprold，布尔函数使用 vpternlogd 单指令完成，
+ * 本文件以 AVX-512F 目标编译，仅在运行时检测到 AVX-512F 后调用
+ */
+
+#ifdef __x86_64__
+
+#pragma GCC push_options
+#pragma GCC target("avx2,avx512f")
+
+#include "sm3_internal.h"
+
+#define V16_ROTL(x, n) _mm512_rol_epi32((x), (n))
+#define V16_ADD(a, b) _mm512_add_epi32((a), (b))
+// vpternlogd 真值表：XOR3 = 0x96，MAJ = 0xE8，CH (x ? y : z) = 0xCA
+#define V16_XOR3(a, b, c) _mm512_ternarylogic_epi32((a), (b), (c), 0x96)
+#define V16_MAJ(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0xE8)
+#define V16_CH(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0xCA)
+#define V16_P0(x) V16_XOR3((x), V16_ROTL((x), 9), V16_ROTL((x), 17))
+#define V16_P1(x) V16_XOR3((x), V16_ROTL((x), 15), V16_ROTL((x), 23))
+
+// 8x8 转置（256位），与 AVX2 内核相同
+static inline void sm3_mb_transpose8(__m256i r[8], __m256i w[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    w[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    w[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    w[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    w[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    w[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    w[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    w[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    w[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// 加载 16 路消息块的 16 个字（大端序）：四个 8x8 子块转置后拼接
+static inline void sm3_mb_load_x16(const uint8_t *const *blocks, __m512i W[16])
+{
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i r[8], lo[8], hi[8];
+
+    for (int half = 0; half < 2; half++)
+    {
+        for (int l = 0; l < 8; l++)
+        {
+            r[l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(blocks[l] + half * 32)), bswap);
+        }
+        sm3_mb_transpose8(r, lo);
+        for (int l = 0; l < 8; l++)
+        {
+            r[l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(blocks[l + 8] + half * 32)), bswap);
+        }
+        sm3_mb_transpose8(r, hi);
+        for (int j = 0; j < 8; j++)
+        {
+            W[half * 8 + j] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[j]), hi[j], 1);
+        }
+    }
+}
+
+void sm3_mb_compress_x16_avx512(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m512i W[68];
+
+    sm3_mb_load_x16(blocks, W);
+    for (int j = 16; j < 68; j++)
+    {
+        __m512i t = V16_XOR3(W[j - 16], W[j - 9], V16_ROTL(W[j - 3], 15));
+        W[j] = V16_XOR3(V16_P1(t), V16_ROTL(W[j - 13], 7), W[j - 6]);
+    }
+
+    __m512i A = _mm512_load_si512(state + 0);
+    __m512i B = _mm512_load_si512(state + 16);
+    __m512i C = _mm512_load_si512(state + 32);
+    __m512i D = _mm512_load_si512(state + 48);
+    __m512i E = _mm512_load_si512(state + 64);
+    __m512i F = _mm512_load_si512(state + 80);
+    __m512i G = _mm512_load_si512(state + 96);
+    __m512i H = _mm512_load_si512(state + 112);
+    __m512i A0 = A, B0 = B, C0 = C, D0 = D, E0 = E, F0 = F, G0 = G, H0 = H;
+
+    for (int j = 0; j < 64; j++)
+    {
+        __m512i A12 = V16_ROTL(A, 12);
+        __m512i SS1 = V16_ROTL(V16_ADD(V16_ADD(A12, E), _mm512_set1_epi32((int)sm3_T_rotated[j])), 7);
+        __m512i SS2 = _mm512_xor_si512(SS1, A12);
+        __m512i FF = (j < 16) ? V16_XOR3(A, B, C) : V16_MAJ(A, B, C);
+        __m512i GG = (j < 16) ? V16_XOR3(E, F, G) : V16_CH(E, F, G);
+        __m512i TT1 = V16_ADD(V16_ADD(FF, D), V16_ADD(SS2, _mm512_xor_si512(W[j], W[j + 4])));
+        __m512i TT2 = V16_ADD(V16_ADD(GG, H), V16_ADD(SS1, W[j]));
+        D = C;
+        C = V16_ROTL(B, 9);
+        B = A;
+        A = TT1;
+        H = G;
+        G = V16_ROTL(F, 19);
+        F = E;
+        E = V16_P0(TT2);
+    }
+
+    _mm512_store_si512(state + 0, _mm512_xor_si512(A, A0));
+    _mm512_store_si512(state + 16, _mm512_xor_si512(B, B0));
+    _mm512_store_si512(state + 32, _mm512_xor_si512(C, C0));
+    _mm512_store_si512(state + 48, _mm512_xor_si512(D, D0));
+    _mm512_store_si512(state + 64, _mm512_xor_si512(E, E0));
+    _mm512_store_si512(state + 80, _mm512_xor_si512(F, F0));
+    _mm512_store_si512(state + 96, _mm512_xor_si512(G, G0));
+    _mm512_store_si512(state + 112, _mm512_xor_si512(H, H0));
+}
+
+#pragma GCC pop_options
+
+#endif // __x86_64__
@@ -0,0 +1,194 @@
+/*
+ * SM3 / Merkle Runtime Statistics
+ * 每线程计数器与快照导出
+ *
+ * 线程首次计数时分配一块计数器并以无锁方式挂到全局链表头部；链表只增不减，
+ * 线程退出后其计数器仍保留在链表中，累计值不会丢失。快照遍历链表逐字段求和，
+ * 与计数线程之间只有 relaxed 原子访问，不加锁也不打断热路径
+ */
+
+#define _POSIX_C_SOURCE 200112L // clock_gettime
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sm3_internal.h"
+
+#define SM3_STATS_WORDS (sizeof(sm3_stats_t) / sizeof(uint64_t))
+
+static const char *const sm3_stats_proof_names[SM3_STATS_PROOF_KINDS] = {"inclusion", "consistency", "multiproof"};
+
+uint64_t sm3_stats_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef SM3_STATS
+typedef struct sm3_stats_block
+{
+    sm3_stats_t counters;
+    struct sm3_stats_block *next;
+} sm3_stats_block_t;
+
+static __thread sm3_stats_block_t *sm3_stats_local;
+static sm3_stats_block_t *sm3_stats_head; // 原子读写
+static sm3_stats_block_t sm3_stats_fallback; // 分配失败时共用，计数可能有损但不崩溃
+static sm3_stats_t sm3_stats_baseline;    // reset 时的累计值
+static int sm3_stats_baseline_lock;
+
+sm3_stats_t *sm3_stats_thread(void)
+{
+    sm3_stats_block_t *block = sm3_stats_local;
+
+    if (block)
+        return &block->counters;
+
+    block = calloc(1, sizeof(sm3_stats_block_t));
+    if (!block)
+    {
+        sm3_stats_local = &sm3_stats_fallback;
+        return &sm3_stats_fallback.counters;
+    }
+    block->next = __atomic_load_n(&sm3_stats_head, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&sm3_stats_head, &block->next, block, 1, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED))
+        ;
+    sm3_stats_local = block;
+    return &block->counters;
+}
+
+// 所有线程（含回退块）的累计值
+static void sm3_stats_total(uint64_t *sum)
+{
+    const uint64_t *words;
+
+    memset(sum, 0, sizeof(sm3_stats_t));
+    for (sm3_stats_block_t *b = __atomic_load_n(&sm3_stats_head, __ATOMIC_ACQUIRE); b; b = b->next)
+    {
+        words = (const uint64_t *)&b->counters;
+        for (size_t i = 0; i < SM3_STATS_WORDS; i++)
+            sum[i] += __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+    }
+    words = (const uint64_t *)&sm3_stats_fallback.counters;
+    for (size_t i = 0; i < SM3_STATS_WORDS; i++)
+        sum[i] += __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+}
+
+static void sm3_stats_lock(void)
+{
+    while (__atomic_exchange_n(&sm3_stats_baseline_lock, 1, __ATOMIC_ACQUIRE))
+        ;
+}
+
+static void sm3_stats_unlock(void)
+{
+    __atomic_store_n(&sm3_stats_baseline_lock, 0, __ATOMIC_RELEASE);
+}
+
+int sm3_stats_enabled(void)
+{
+    return 1;
+}
+
+void sm3_stats_snapshot(sm3_stats_t *out)
+{
+    uint64_t *words = (uint64_t *)out;
+    const uint64_t *base = (const uint64_t *)&sm3_stats_baseline;
+
+    sm3_stats_total(words);
+    sm3_stats_lock();
+    for (size_t i = 0; i < SM3_STATS_WORDS; i++)
+        words[i] -= base[i];
+    sm3_stats_unlock();
+}
+
+void sm3_stats_reset(void)
+{
+    sm3_stats_t total;
+
+    sm3_stats_total((uint64_t *)&total);
+    sm3_stats_lock();
+    sm3_stats_baseline = total;
+    sm3_stats_unlock();
+}
+#else
+int sm3_stats_enabled(void)
+{
+    return 0;
+}
+
+void sm3_stats_snapshot(sm3_stats_t *out)
+{
+    memset(out, 0, sizeof(sm3_stats_t));
+}
+
+void sm3_stats_reset(void)
+{
+}
+#endif // SM3_STATS
+
+uint64_t sm3_stats_hist_percentile(const uint64_t *hist, double p)
+{
+    uint64_t total = 0, seen = 0;
+
+    for (int i = 0; i < SM3_STATS_HIST_BUCKETS; i++)
+        total += hist[i];
+    if (total == 0)
+        return 0;
+
+    for (int i = 0; i < SM3_STATS_HIST_BUCKETS; i++)
+    {
+        seen += hist[i];
+        if ((double)seen >= p * (double)total)
+            return (uint64_t)2 << i;
+    }
+    return (uint64_t)2 << (SM3_STATS_HIST_BUCKETS - 1);
+}
+
+static void sm3_stats_write_hist(FILE *out, const uint64_t *hist)
+{
+    uint64_t count = 0;
+
+    for (int i = 0; i < SM3_STATS_HIST_BUCKETS; i++)
+        count += hist[i];
+    fprintf(out, "{\"count\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"log2_ns\": [", (unsigned long long)count,
+            (unsigned long long)sm3_stats_hist_percentile(hist, 0.50),
+            (unsigned long long)sm3_stats_hist_percentile(hist, 0.99));
+    for (int i = 0; i < SM3_STATS_HIST_BUCKETS; i++)
+        fprintf(out, "%s%llu", i ? ", " : "", (unsigned long long)hist[i]);
+    fprintf(out, "]}");
+}
+
+void sm3_stats_write_json(FILE *out, const sm3_stats_t *stats)
+{
+    uint64_t lookups = stats->node_hits + stats->node_misses;
+    const char *name;
+
+    fprintf(out, "{\n    \"enabled\": %s,\n    \"kernels\": {", sm3_stats_enabled() ? "true" : "false");
+    for (int k = 0; k < SM3_STATS_MAX_KERNELS && (name = sm3_kernel_name_at(k)) != NULL; k++)
+    {
+        fprintf(out,
+                "%s\n        \"%s\": {\"bytes\": %llu, \"compress_blocks\": %llu, \"mb_lane_blocks\": %llu, "
+                "\"mb_idle_blocks\": %llu}",
+                k ? "," : "", name, (unsigned long long)stats->bytes_hashed[k],
+                (unsigned long long)stats->compress_blocks[k], (unsigned long long)stats->mb_lane_blocks[k],
+                (unsigned long long)stats->mb_idle_blocks[k]);
+    }
+    fprintf(out, "\n    },\n    \"tree_builds\": %llu,\n    \"tree_build_leaves\": %llu,\n    \"tree_build\": ",
+            (unsigned long long)stats->tree_builds, (unsigned long long)stats->tree_build_leaves);
+    sm3_stats_write_hist(out, stats->tree_build_ns);
+    for (int kind = 0; kind < SM3_STATS_PROOF_KINDS; kind++)
+    {
+        fprintf(out, ",\n    \"%s_generate\": ", sm3_stats_proof_names[kind]);
+        sm3_stats_write_hist(out, stats->proof_generate_ns[kind]);
+        fprintf(out, ",\n    \"%s_verify\": ", sm3_stats_proof_names[kind]);
+        sm3_stats_write_hist(out, stats->proof_verify_ns[kind]);
+    }
+    fprintf(out, ",\n    \"node_hits\": %llu,\n    \"node_misses\": %llu,\n    \"node_hit_rate\": %.6f\n}",
+            (unsigned long long)stats->node_hits, (unsigned long long)stats->node_misses,
+            lookups ? (double)stats->node_hits / (double)lookups : 0.0);
+}
@@ -0,0 +1,107 @@
+/*
+ * SM3 / Merkle Runtime Statistics
+ * 运行时统计与 USDT 探针
+ *
+ * 以 -DSM3_STATS 编译（make STATS=1）时启用：每个线程一块私有计数器，
+ * 只由本线程以 relaxed 原子读写更新（普通的 load/store，无总线锁），
+ * sm3_stats_snapshot 遍历所有线程的计数器求和。未定义 SM3_STATS 时所有统计宏展开为空，
+ * 热路径上不留任何代码，快照接口返回全零
+ *
+ * 系统提供 <sys/sdt.h> 时同时编入 USDT 探针（provider 为 sm3），可用 bpftrace/perf 挂载：
+ *   sm3:compress(kernel, blocks)  sm3:tree_build(leaves, ns)
+ *   sm3:proof_generate(kind, ns)  sm3:proof_verify(kind, ns)
+ */
+
+#ifndef SM3_STATS_H
+#define SM3_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SM3_STATS_MAX_KERNELS 8   // 不小于 sm3_dispatch.c 中的内核数
+#define SM3_STATS_HIST_BUCKETS 40 // 第 i 个桶统计耗时落在 [2^i, 2^(i+1)) 纳秒的次数
+
+// 证明类型
+#define SM3_STATS_PROOF_INCLUSION 0
+#define SM3_STATS_PROOF_CONSISTENCY 1
+#define SM3_STATS_PROOF_MULTIPROOF 2
+#define SM3_STATS_PROOF_KINDS 3
+
+typedef struct
+{
+    // 按内核（sm3_kernel_name_at 的下标）统计
+    uint64_t bytes_hashed[SM3_STATS_MAX_KERNELS];    // 输入的消息字节数
+    uint64_t compress_blocks[SM3_STATS_MAX_KERNELS]; // 单路压缩的块数
+    uint64_t mb_lane_blocks[SM3_STATS_MAX_KERNELS];  // 多路引擎中有效通道压缩的块数
+    uint64_t mb_idle_blocks[SM3_STATS_MAX_KERNELS];  // 多路引擎中空闲通道陪跑的块数
+
+    // Merkle 树
+    uint64_t tree_builds;
+    uint64_t tree_build_leaves;
+    uint64_t tree_build_ns[SM3_STATS_HIST_BUCKETS];
+    uint64_t proof_generate_ns[SM3_STATS_PROOF_KINDS][SM3_STATS_HIST_BUCKETS];
+    uint64_t proof_verify_ns[SM3_STATS_PROOF_KINDS][SM3_STATS_HIST_BUCKETS];
+
+    // 节点缓存：生成证明时直接读到已存节点记为命中，为历史大小重算右边缘节点记为未命中
+    uint64_t node_hits;
+    uint64_t node_misses;
+} sm3_stats_t;
+
+int sm3_stats_enabled(void);               // 编译时启用统计返回1，否则返回0
+void sm3_stats_snapshot(sm3_stats_t *out); // 自上次 reset 以来所有线程的累计值
+void sm3_stats_reset(void);                // 以当前累计值为新的基线
+uint64_t sm3_stats_now_ns(void);           // 单调时钟，纳秒
+uint64_t sm3_stats_hist_percentile(const uint64_t *hist, double p); // 直方图分位数（桶上界，纳秒）
+void sm3_stats_write_json(FILE *out, const sm3_stats_t *stats);
+
+#ifdef SM3_STATS
+
+// 当前线程的计数器，首次调用时分配并登记
+sm3_stats_t *sm3_stats_thread(void);
+
+static inline void sm3_stats_add(uint64_t *counter, uint64_t n)
+{
+    // 只有所属线程写入，relaxed 读改写即可，快照线程读到的总是某个完整的值
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline int sm3_stats_bucket(uint64_t ns)
+{
+    int b = 63 - __builtin_clzll(ns | 1);
+    return b < SM3_STATS_HIST_BUCKETS ? b : SM3_STATS_HIST_BUCKETS - 1;
+}
+
+#define SM3_STAT_ADD(field, n) sm3_stats_add(&sm3_stats_thread()->field, (uint64_t)(n))
+#define SM3_STAT_HIST(field, ns) sm3_stats_add(&sm3_stats_thread()->field[sm3_stats_bucket(ns)], 1)
+#define SM3_STAT_TIMER(name) uint64_t name = sm3_stats_now_ns()
+
+// 记录自 SM3_STAT_TIMER(start) 以来的耗时并触发探针
+#define SM3_STAT_LATENCY(field, start, probe, arg)                  \
+    do                                                              \
+    {                                                               \
+        uint64_t sm3_stat_ns_ = sm3_stats_now_ns() - (start);       \
+        SM3_STAT_HIST(field, sm3_stat_ns_);                         \
+        SM3_PROBE2(probe, (uint64_t)(arg), sm3_stat_ns_);           \
+    } while (0)
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SM3_PROBE2(name, a, b) DTRACE_PROBE2(sm3, name, a, b)
+#endif
+#endif
+
+#else
+
+#define SM3_STAT_ADD(field, n) ((void)0)
+#define SM3_STAT_HIST(field, ns) ((void)0)
+#define SM3_STAT_TIMER(name) ((void)0)
+#define SM3_STAT_LATENCY(field, start, probe, arg) ((void)0)
+
+#endif // SM3_STATS
+
+#ifndef SM3_PROBE2
+#define SM3_PROBE2(name, a, b) ((void)0)
+#endif
+
+#endif // SM3_STATS_H